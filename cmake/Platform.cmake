@@ -43,7 +43,10 @@ cyan_check_include_files("sys/inotify.h" HAVE_SYS_INOTIFY_H)
 cyan_check_include_files("sys/select.h" HAVE_SYS_SELECT_H)
 cyan_check_include_files("sys/signalfd.h" HAVE_SYS_SIGNALFD_H)
 cyan_check_include_files("sys/stat.h" HAVE_SYS_STAT_H)
+cyan_check_include_files("sys/timerfd.h" HAVE_SYS_TIMERFD_H)
+cyan_check_include_files("linux/io_uring.h" HAVE_LINUX_IO_URING_H)
 cyan_check_include_files("sys/types.h" HAVE_SYS_TYPES_H)
+cyan_check_include_files("sys/uio.h" HAVE_SYS_UIO_H)
 cyan_check_include_files(unistd.h HAVE_UNISTD_H)
 cyan_check_include_files("netinet/in.h" HAVE_NETINET_IN_H)
 cyan_check_include_files("netinet/in6.h" HAVE_NETINET_IN6_H)
@@ -109,6 +112,27 @@ check_cxx_source_compiles(
     HAVE___DECLPSEC
 )
 
+# Threads
+set(CMAKE_REQUIRED_DEFINITIONS -D_GNU_SOURCE)
+set(CMAKE_REQUIRED_LIBRARIES pthread)
+check_symbol_exists(pthread_setaffinity_np pthread.h HAVE_PTHREAD_SETAFFINITY_NP)
+check_cxx_source_compiles(
+    "
+    #include <pthread.h>
+    int main() { return pthread_setname_np(pthread_self(), \"name\"); }
+    "
+    HAVE_PTHREAD_SETNAME_NP
+)
+check_cxx_source_compiles(
+    "
+    #include <pthread.h>
+    int main() { return pthread_setname_np(\"name\"); }
+    "
+    HAVE_PTHREAD_SETNAME_NP_SELF
+)
+unset(CMAKE_REQUIRED_DEFINITIONS)
+unset(CMAKE_REQUIRED_LIBRARIES)
+
 # Tweaks
 set(HAVE_CLOCK_SYSCALL ${HAVE_CLOCK_GETTIME})
 
@@ -0,0 +1,206 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+namespace cyan {
+
+namespace detail {
+
+// Log-linear bucketing in the spirit of HdrHistogram: every power of two
+// is split into 2^SubBucketBits linear sub-buckets, which bounds the
+// relative error of a recorded value to 2^-SubBucketBits.
+template<std::size_t SubBucketBits, std::size_t MaxValueBits>
+struct histogram_layout {
+  static_assert(SubBucketBits > 0 && SubBucketBits < MaxValueBits && MaxValueBits < 64);
+
+  constexpr static std::size_t sub_bucket_count = std::size_t(1) << SubBucketBits;
+  constexpr static std::size_t bucket_count = (MaxValueBits - SubBucketBits + 1) * sub_bucket_count;
+  constexpr static std::uint64_t max_value = (std::uint64_t(1) << MaxValueBits) - 1;
+
+  constexpr static std::size_t index_of(std::uint64_t value) noexcept {
+    value = std::min(value, max_value);
+    if (value < sub_bucket_count) return static_cast<std::size_t>(value);
+
+    std::size_t const shift = std::bit_width(value) - 1 - SubBucketBits;
+    std::size_t const top = static_cast<std::size_t>(value >> shift);
+    return (shift + 1) * sub_bucket_count + (top - sub_bucket_count);
+  }
+
+  // Highest value that maps onto the bucket at `index`.
+  constexpr static std::uint64_t value_at(std::size_t index) noexcept {
+    if (index < sub_bucket_count) return index;
+
+    std::size_t const shift = index / sub_bucket_count - 1;
+    std::uint64_t const top = sub_bucket_count + index % sub_bucket_count;
+    return ((top + 1) << shift) - 1;
+  }
+};
+
+} // detail
+
+template<std::size_t SubBucketBits = 6, std::size_t MaxValueBits = 40>
+class basic_histogram {
+public:
+  using layout_type = detail::histogram_layout<SubBucketBits, MaxValueBits>;
+  using count_type = std::uint64_t;
+  using value_type = std::uint64_t;
+
+  constexpr static std::size_t bucket_count = layout_type::bucket_count;
+
+  basic_histogram() noexcept : counts_{}, total_count_{ 0 }, total_sum_{ 0 },
+        min_{ std::numeric_limits<value_type>::max() }, max_{ 0 } {
+  }
+
+  void record(value_type value, count_type count = 1) noexcept {
+    counts_[layout_type::index_of(value)] += count;
+    total_count_ += count;
+    total_sum_ += value * count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  basic_histogram& merge(basic_histogram const& other) noexcept {
+    for (std::size_t i = 0; i < bucket_count; i++) counts_[i] += other.counts_[i];
+    total_count_ += other.total_count_;
+    total_sum_ += other.total_sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    return *this;
+  }
+
+  void reset() noexcept {
+    *this = basic_histogram{};
+  }
+
+  count_type count() const noexcept {
+    return total_count_;
+  }
+
+  value_type min() const noexcept {
+    return total_count_ ? min_ : 0;
+  }
+
+  value_type max() const noexcept {
+    return max_;
+  }
+
+  double mean() const noexcept {
+    return total_count_ ? double(total_sum_) / double(total_count_) : 0.;
+  }
+
+  // Returns the value below which `percentile` percent of the recorded
+  // values fall, e.g. `value_at_percentile(99.9)`.
+  value_type value_at_percentile(double percentile) const noexcept {
+    if (total_count_ == 0) return 0;
+
+    percentile = std::clamp(percentile, 0., 100.);
+    auto const rank = std::max<count_type>(1, count_type(percentile / 100. * double(total_count_) + 0.5));
+
+    count_type seen = 0;
+    for (std::size_t i = 0; i < bucket_count; i++) {
+      seen += counts_[i];
+      if (seen >= rank) return std::min(layout_type::value_at(i), max_);
+    }
+    return max_;
+  }
+
+private:
+  template<std::size_t, std::size_t>
+  friend class basic_concurrent_histogram;
+
+  std::array<count_type, bucket_count> counts_;
+  count_type total_count_;
+  value_type total_sum_;
+  value_type min_;
+  value_type max_;
+};
+
+// Histogram meant to be recorded into by a single owning thread while other
+// threads take snapshots. Counters are relaxed atomics that the writer
+// updates with plain load/store pairs, so recording never issues a locked
+// instruction; snapshots are not instantaneous but every bucket is exact.
+template<std::size_t SubBucketBits = 6, std::size_t MaxValueBits = 40>
+class basic_concurrent_histogram {
+public:
+  using histogram_type = basic_histogram<SubBucketBits, MaxValueBits>;
+  using layout_type = typename histogram_type::layout_type;
+  using count_type = typename histogram_type::count_type;
+  using value_type = typename histogram_type::value_type;
+
+  constexpr static std::size_t bucket_count = histogram_type::bucket_count;
+
+  basic_concurrent_histogram() noexcept : total_count_{ 0 }, total_sum_{ 0 },
+        min_{ std::numeric_limits<value_type>::max() }, max_{ 0 } {
+    for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+  }
+
+  void record(value_type value) noexcept {
+    increment(counts_[layout_type::index_of(value)], 1);
+    increment(total_sum_, value);
+    if (value < min_.load(std::memory_order_relaxed)) min_.store(value, std::memory_order_relaxed);
+    if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+    // Published last, so a snapshot never sees more values than bucket counts.
+    total_count_.store(total_count_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  histogram_type snapshot() const noexcept {
+    histogram_type result;
+    result.total_count_ = total_count_.load(std::memory_order_acquire);
+    result.total_sum_ = total_sum_.load(std::memory_order_relaxed);
+    result.min_ = min_.load(std::memory_order_relaxed);
+    result.max_ = max_.load(std::memory_order_relaxed);
+
+    count_type bucketed = 0;
+    for (std::size_t i = 0; i < bucket_count; i++) {
+      result.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+      bucketed += result.counts_[i];
+    }
+    // Values recorded while copying are counted in their buckets only.
+    result.total_count_ = std::max(result.total_count_, bucketed);
+    return result;
+  }
+
+private:
+  static void increment(std::atomic<std::uint64_t>& counter, std::uint64_t by) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<count_type>, bucket_count> counts_;
+  std::atomic<count_type> total_count_;
+  std::atomic<value_type> total_sum_;
+  std::atomic<value_type> min_;
+  std::atomic<value_type> max_;
+};
+
+using histogram = basic_histogram<>;
+using concurrent_histogram = basic_concurrent_histogram<>;
+
+} // cyan
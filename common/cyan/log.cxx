@@ -0,0 +1,296 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <bit>
+#include <ctime>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <cstring>
+
+#include <cyan/log.h>
+
+namespace cyan::log {
+
+namespace {
+
+class ring {
+public:
+  ring(std::size_t capacity, std::uint32_t tid) : mask_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 },
+        records_{ std::make_unique<detail::record[]>(mask_ + 1) }, head_{ 0 }, tail_{ 0 }, cached_tail_{ 0 },
+        dropped_{ 0 }, tid_{ tid }, orphaned_{ false } {
+  }
+
+  detail::record* claim() noexcept {
+    auto const head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ > mask_) {
+      // Only re-read the consumer's position when the ring looks full
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head - cached_tail_ > mask_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+    }
+    return &records_[head & mask_];
+  }
+
+  void commit() noexcept {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  std::size_t consume(std::string& out, std::size_t max, std::uint64_t until);
+
+  std::uint64_t head() const noexcept {
+    return head_.load(std::memory_order_acquire);
+  }
+
+  std::uint32_t tid() const noexcept {
+    return tid_;
+  }
+
+  bool empty() const noexcept {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t dropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  void orphan() noexcept {
+    orphaned_.store(true, std::memory_order_release);
+  }
+
+  bool is_orphaned() const noexcept {
+    return orphaned_.load(std::memory_order_acquire);
+  }
+
+private:
+  std::size_t const mask_;
+  std::unique_ptr<detail::record[]> records_;
+
+  alignas(std::hardware_destructive_interference_size)
+  std::atomic<std::uint64_t> head_;
+
+  alignas(std::hardware_destructive_interference_size)
+  std::atomic<std::uint64_t> tail_;
+
+  alignas(std::hardware_destructive_interference_size)
+  std::uint64_t cached_tail_;
+  std::atomic<std::uint64_t> dropped_;
+  std::uint32_t const tid_;
+  std::atomic<bool> orphaned_;
+};
+
+struct registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ring>> rings;
+  std::size_t capacity = default_capacity;
+  std::uint32_t next_tid = 1;
+  std::uint64_t retired_dropped = 0;
+};
+
+registry& get_registry() {
+  static registry instance;
+  return instance;
+}
+
+// Hands the ring over to the consumer when its thread exits
+struct ring_holder {
+  ~ring_holder() {
+    if (local) local->orphan();
+  }
+
+  std::shared_ptr<ring> local;
+};
+
+ring& this_thread_ring() {
+  static thread_local ring_holder holder;
+
+  if (!holder.local) {
+    auto& reg = get_registry();
+    std::lock_guard<std::mutex> lock{ reg.mutex };
+    holder.local = std::make_shared<ring>(reg.capacity, reg.next_tid++);
+    reg.rings.push_back(holder.local);
+  }
+
+  return *holder.local;
+}
+
+char const* level_name(level severity) noexcept {
+  switch (severity) {
+    case level::trace: return "TRACE";
+    case level::debug: return "DEBUG";
+    case level::info: return "INFO ";
+    case level::warn: return "WARN ";
+    case level::error: return "ERROR";
+  }
+  return "?    ";
+}
+
+void append_line(std::string& out, detail::record const& r, std::uint32_t tid) {
+  auto const seconds = static_cast<std::time_t>(r.timestamp / 1000000000);
+  std::tm tm{};
+#ifdef WIN32
+  ::gmtime_s(&tm, &seconds);
+#else
+  ::gmtime_r(&seconds, &tm);
+#endif // WIN32
+
+  char prefix[64];
+  auto const length = std::snprintf(prefix, sizeof(prefix), "%04d-%02d-%02d %02d:%02d:%02d.%06d %s [%u] ",
+        tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+        static_cast<int>(r.timestamp % 1000000000 / 1000), level_name(r.severity), tid);
+  out.append(prefix, static_cast<std::size_t>(std::max(length, 0)));
+
+  if (r.format) {
+    char text[512];
+    out.append(text, r.format(text, sizeof(text), r.payload));
+  } else {
+    out.append(reinterpret_cast<char const*>(r.payload), r.size);
+  }
+  out.push_back('\n');
+}
+
+std::size_t ring::consume(std::string& out, std::size_t max, std::uint64_t until) {
+  auto const begin = tail_.load(std::memory_order_relaxed);
+  auto const head = std::max(std::min(head_.load(std::memory_order_acquire), until), begin);
+  auto const end = head - begin > max ? begin + max : head;
+
+  for (auto tail = begin; tail != end; tail++) {
+    append_line(out, records_[tail & mask_], tid_);
+    // Frees the slot for the producer as early as possible
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+  return static_cast<std::size_t>(end - begin);
+}
+
+} // anonymous
+
+namespace detail {
+
+std::atomic<level> threshold{ level::info };
+
+record* claim(level severity) noexcept {
+  auto* r = this_thread_ring().claim();
+  if (!r) return nullptr;
+
+  r->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+  r->format = nullptr;
+  r->size = 0;
+  r->severity = severity;
+  return r;
+}
+
+void commit() noexcept {
+  this_thread_ring().commit();
+}
+
+} // detail
+
+void set_level(level severity) noexcept {
+  detail::threshold.store(severity, std::memory_order_relaxed);
+}
+
+void set_capacity(std::size_t capacity) {
+  auto& reg = get_registry();
+  std::lock_guard<std::mutex> lock{ reg.mutex };
+  reg.capacity = capacity;
+}
+
+void write(level severity, std::string_view text) noexcept {
+  if (!is_enabled(severity)) return;
+
+  auto* r = detail::claim(severity);
+  if (!r) return;
+
+  r->size = static_cast<std::uint16_t>(std::min(text.size(), detail::record::payload_size));
+  std::memcpy(r->payload, text.data(), r->size);
+  detail::commit();
+}
+
+namespace {
+
+std::size_t take(std::vector<std::string>& batches, snapshot const* until, std::size_t max_per_thread) {
+  auto& reg = get_registry();
+  std::vector<std::shared_ptr<ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock{ reg.mutex };
+    rings = reg.rings;
+  }
+
+  // Both are in thread id order
+  std::size_t next = 0;
+  std::size_t count = 0;
+  for (auto& r : rings) {
+    auto limit = ~std::uint64_t(0);
+    if (until) {
+      auto const& heads = until->heads;
+      while (next < heads.size() && heads[next].first < r->tid()) next++;
+      limit = next < heads.size() && heads[next].first == r->tid() ? heads[next].second : 0;
+    }
+
+    std::string batch;
+    count += r->consume(batch, max_per_thread, limit);
+    if (!batch.empty()) batches.push_back(std::move(batch));
+  }
+
+  // Rings of exited threads go once drained
+  std::lock_guard<std::mutex> lock{ reg.mutex };
+  std::erase_if(reg.rings, [&](auto const& r) {
+    if (!r->is_orphaned() || !r->empty()) return false;
+    reg.retired_dropped += r->dropped();
+    return true;
+  });
+  return count;
+}
+
+} // anonymous
+
+snapshot mark() {
+  auto& reg = get_registry();
+  std::lock_guard<std::mutex> lock{ reg.mutex };
+
+  snapshot result;
+  result.heads.reserve(reg.rings.size());
+  for (auto& r : reg.rings) result.heads.emplace_back(r->tid(), r->head());
+  return result;
+}
+
+std::size_t consume(std::vector<std::string>& batches, std::size_t max_per_thread) {
+  return take(batches, nullptr, max_per_thread);
+}
+
+std::size_t consume(std::vector<std::string>& batches, snapshot const& until, std::size_t max_per_thread) {
+  return take(batches, &until, max_per_thread);
+}
+
+std::uint64_t dropped() noexcept {
+  auto& reg = get_registry();
+  std::lock_guard<std::mutex> lock{ reg.mutex };
+  auto total = reg.retired_dropped;
+  for (auto& r : reg.rings) total += r->dropped();
+  return total;
+}
+
+} // cyan::log
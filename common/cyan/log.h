@@ -0,0 +1,141 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cyan/config.h>
+
+// Asynchronous logging. Each thread writes records into its own lock-free
+// ring; a single consumer (see cyan::dispatch::log_writer) formats and writes
+// them out in batches. Producers never block nor take a lock: a record that
+// does not fit in its thread's ring is dropped and counted.
+namespace cyan::log {
+
+enum class level : std::uint8_t {
+  trace,
+  debug,
+  info,
+  warn,
+  error
+};
+
+// Records retained per thread before new ones are dropped.
+constexpr std::size_t default_capacity = 1u << 12;
+
+namespace detail {
+
+using formatter = std::size_t (*)(char* out, std::size_t capacity, void const* args) noexcept;
+
+struct record {
+  constexpr static std::size_t payload_size = 224;
+
+  std::int64_t timestamp;
+  // Null when `payload` holds `size` bytes of text
+  formatter format;
+  std::uint16_t size;
+  level severity;
+  alignas(std::max_align_t) unsigned char payload[payload_size];
+};
+
+extern CYAN_API std::atomic<level> threshold;
+
+// Slot for a record of the calling thread, null when its ring is full;
+// publish it with commit()
+CYAN_API record* claim(level severity) noexcept;
+CYAN_API void commit() noexcept;
+
+} // detail
+
+inline bool is_enabled(level severity) noexcept {
+  return severity >= detail::threshold.load(std::memory_order_relaxed);
+}
+
+CYAN_API void set_level(level severity) noexcept;
+
+// Ring size, in records, of threads that have not logged yet.
+CYAN_API void set_capacity(std::size_t capacity);
+
+// Copies pre-formatted text, truncated to what a record holds.
+CYAN_API void write(level severity, std::string_view text) noexcept;
+
+// Defers formatting to the consumer: only the format and the arguments are
+// copied on the calling thread. Arguments must be trivially copyable, and
+// pointers (C strings included) must outlive the record, e.g. literals.
+template<typename ...Args>
+void printf(level severity, char const* format, Args... args) noexcept {
+  using args_type = std::tuple<char const*, Args...>;
+  static_assert((std::is_trivially_copyable_v<Args> && ...), "log::printf: arguments must be trivially copyable");
+  static_assert(sizeof(args_type) <= detail::record::payload_size, "log::printf: arguments too large");
+
+  if (!is_enabled(severity)) return;
+
+  if constexpr (sizeof...(Args) == 0) {
+    write(severity, format);
+  } else {
+    auto* r = detail::claim(severity);
+    if (!r) return;
+
+    new (r->payload) args_type{ format, args... };
+    r->format = [](char* out, std::size_t capacity, void const* p) noexcept -> std::size_t {
+      auto const written = std::apply([&](auto... xs) { return std::snprintf(out, capacity, xs...); },
+            *static_cast<args_type const*>(p));
+      return written < 0 ? 0 : std::min<std::size_t>(static_cast<std::size_t>(written), capacity - 1);
+    };
+    detail::commit();
+  }
+}
+
+// How far each thread had logged at one point in time; threads that log
+// for the first time afterwards are not part of it.
+struct snapshot {
+  // Thread id and number of records it had logged, by thread id
+  std::vector<std::pair<std::uint32_t, std::uint64_t>> heads;
+};
+
+CYAN_API snapshot mark();
+
+// Formats what every thread has logged so far, one line per record, into
+// one batch per thread; at most `max_per_thread` records each. Returns the
+// number of records taken. Only one thread may consume at a time.
+CYAN_API std::size_t consume(std::vector<std::string>& batches, std::size_t max_per_thread = ~std::size_t(0));
+// Same, but takes nothing logged after `until`
+CYAN_API std::size_t consume(std::vector<std::string>& batches, snapshot const& until,
+      std::size_t max_per_thread = ~std::size_t(0));
+
+// Records dropped because their thread's ring was full.
+CYAN_API std::uint64_t dropped() noexcept;
+
+} // cyan::log
@@ -0,0 +1,333 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <cyan/trace.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif // HAVE_UNISTD_H
+
+namespace cyan::trace {
+
+namespace {
+
+// Event fields are copied with relaxed atomics so that a dump racing the
+// writer is well-defined; the slot's sequence tells whether the copy is whole.
+void store_relaxed(event& to, event const& from) noexcept {
+  std::atomic_ref{ to.name }.store(from.name, std::memory_order_relaxed);
+  std::atomic_ref{ to.category }.store(from.category, std::memory_order_relaxed);
+  std::atomic_ref{ to.timestamp }.store(from.timestamp, std::memory_order_relaxed);
+  std::atomic_ref{ to.duration }.store(from.duration, std::memory_order_relaxed);
+  std::atomic_ref{ to.id }.store(from.id, std::memory_order_relaxed);
+  std::atomic_ref{ to.type }.store(from.type, std::memory_order_relaxed);
+}
+
+event load_relaxed(event& from) noexcept {
+  return event{
+    std::atomic_ref{ from.name }.load(std::memory_order_relaxed),
+    std::atomic_ref{ from.category }.load(std::memory_order_relaxed),
+    std::atomic_ref{ from.timestamp }.load(std::memory_order_relaxed),
+    std::atomic_ref{ from.duration }.load(std::memory_order_relaxed),
+    std::atomic_ref{ from.id }.load(std::memory_order_relaxed),
+    std::atomic_ref{ from.type }.load(std::memory_order_relaxed)
+  };
+}
+
+class ring {
+public:
+  ring(std::size_t capacity, std::uint32_t tid) : mask_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 },
+        slots_{ std::make_unique<slot[]>(mask_ + 1) }, head_{ 0 }, cleared_at_{ 0 }, tid_{ tid },
+        orphaned_{ false } {
+  }
+
+  // Seqlock per slot: odd while the event at `head` is being written, then
+  // even and unique to that position.
+  void push(event const& e) noexcept {
+    auto const head = head_.load(std::memory_order_relaxed);
+    auto& s = slots_[head & mask_];
+    s.sequence.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    store_relaxed(s.data, e);
+    s.sequence.store(2 * head + 2, std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  std::vector<event> copy() const {
+    auto const head = head_.load(std::memory_order_acquire);
+    auto const capacity = mask_ + 1;
+    auto const begin = std::max<std::uint64_t>(head > capacity ? head - capacity : 0,
+          cleared_at_.load(std::memory_order_acquire));
+
+    std::vector<event> result;
+    if (begin >= head) return result;
+
+    result.reserve(head - begin);
+    for (auto i = begin; i < head; i++) {
+      // Skip events the writer overwrote or is overwriting while we copy
+      auto& s = slots_[i & mask_];
+      auto const sequence = 2 * i + 2;
+      if (s.sequence.load(std::memory_order_acquire) != sequence) continue;
+      auto const e = load_relaxed(s.data);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (s.sequence.load(std::memory_order_relaxed) != sequence) continue;
+      result.push_back(e);
+    }
+    return result;
+  }
+
+  void clear() noexcept {
+    // Only moves the read window; the owner keeps writing past it.
+    cleared_at_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  std::uint32_t tid() const noexcept {
+    return tid_;
+  }
+
+  void orphan() noexcept {
+    orphaned_.store(true, std::memory_order_release);
+  }
+
+  bool is_orphaned() const noexcept {
+    return orphaned_.load(std::memory_order_acquire);
+  }
+
+  std::string name;
+
+private:
+  struct slot {
+    std::atomic<std::uint64_t> sequence{ 0 };
+    event data{};
+  };
+
+  std::size_t const mask_;
+  std::unique_ptr<slot[]> slots_;
+  std::atomic<std::uint64_t> head_;
+  std::atomic<std::uint64_t> cleared_at_;
+  std::uint32_t const tid_;
+  std::atomic<bool> orphaned_;
+};
+
+// Rings of exited threads kept for dumps; older ones are freed, so that
+// short-lived threads do not pile up rings.
+constexpr std::size_t max_orphaned_rings = 16;
+
+struct registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ring>> rings;
+  std::size_t capacity = default_capacity;
+  std::uint32_t next_tid = 1;
+};
+
+registry& get_registry() {
+  static registry instance;
+  return instance;
+}
+
+std::chrono::steady_clock::time_point epoch() {
+  static auto const value = std::chrono::steady_clock::now();
+  return value;
+}
+
+std::atomic<std::uint64_t> flow_ids{ 1 };
+
+// The ring is only allocated on the first event, which needs tracing on;
+// until then the thread just keeps its name.
+struct ring_holder {
+  ~ring_holder() {
+    if (!local) return;
+
+    auto& reg = get_registry();
+    std::lock_guard<std::mutex> lock{ reg.mutex };
+    local->orphan();
+    auto orphaned = std::count_if(reg.rings.begin(), reg.rings.end(), [](auto const& r) { return r->is_orphaned(); });
+    std::erase_if(reg.rings, [&](auto const& r) {
+      if (orphaned <= std::ptrdiff_t(max_orphaned_rings) || !r->is_orphaned()) return false;
+      orphaned--;
+      return true;
+    });
+  }
+
+  std::shared_ptr<ring> local;
+  std::string name;
+};
+
+ring_holder& this_thread_holder() {
+  static thread_local ring_holder holder;
+  return holder;
+}
+
+ring& this_thread_ring() {
+  auto& holder = this_thread_holder();
+
+  if (!holder.local) {
+    auto& reg = get_registry();
+    std::lock_guard<std::mutex> lock{ reg.mutex };
+    holder.local = std::make_shared<ring>(reg.capacity, reg.next_tid++);
+    holder.local->name = holder.name;
+    reg.rings.push_back(holder.local);
+  }
+
+  return *holder.local;
+}
+
+void write_escaped(std::ostream& os, char const* str) {
+  os << '"';
+  for (; str && *str; str++) {
+    if (*str == '"' || *str == '\\') os << '\\';
+    if (static_cast<unsigned char>(*str) >= 0x20) os << *str;
+  }
+  os << '"';
+}
+
+void write_timestamp(std::ostream& os, std::uint64_t ns) {
+  // Chrome trace timestamps are in microseconds
+  os << ns / 1000 << '.';
+  auto const frac = ns % 1000;
+  if (frac < 100) os << '0';
+  if (frac < 10) os << '0';
+  os << frac;
+}
+
+int process_id() {
+#ifdef HAVE_UNISTD_H
+  return static_cast<int>(::getpid());
+#else
+  return 1;
+#endif // HAVE_UNISTD_H
+}
+
+} // anonymous
+
+namespace detail {
+
+std::atomic<bool> enabled{ false };
+
+std::uint64_t now() noexcept {
+  auto const elapsed = std::chrono::steady_clock::now() - epoch();
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) + 1;
+}
+
+void record(event const& e) noexcept {
+  this_thread_ring().push(e);
+}
+
+} // detail
+
+void enable(std::size_t capacity) {
+  {
+    auto& reg = get_registry();
+    std::lock_guard<std::mutex> lock{ reg.mutex };
+    reg.capacity = capacity;
+  }
+  detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void disable() {
+  detail::enabled.store(false, std::memory_order_relaxed);
+}
+
+void clear() {
+  auto& reg = get_registry();
+  std::lock_guard<std::mutex> lock{ reg.mutex };
+  std::erase_if(reg.rings, [](auto const& r) { return r->is_orphaned(); });
+  for (auto& r : reg.rings) r->clear();
+}
+
+void set_thread_name(std::string const& name) {
+  auto& holder = this_thread_holder();
+  std::lock_guard<std::mutex> lock{ get_registry().mutex };
+  holder.name = name;
+  if (holder.local) holder.local->name = name;
+}
+
+std::uint64_t next_flow_id() noexcept {
+  return flow_ids.fetch_add(1, std::memory_order_relaxed);
+}
+
+void write_chrome_trace(std::ostream& os) {
+  auto& reg = get_registry();
+  std::vector<std::shared_ptr<ring>> rings;
+  std::vector<std::string> names;
+  {
+    std::lock_guard<std::mutex> lock{ reg.mutex };
+    rings = reg.rings;
+    for (auto& r : rings) names.push_back(r->name);
+  }
+
+  auto const pid = process_id();
+  bool first = true;
+  auto separator = [&] {
+    if (!first) os << ",\n";
+    first = false;
+  };
+
+  os << "{\"traceEvents\":[\n";
+  for (std::size_t i = 0; i < rings.size(); i++) {
+    auto const& r = *rings[i];
+
+    if (!names[i].empty()) {
+      separator();
+      os << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << r.tid()
+          << ",\"args\":{\"name\":";
+      write_escaped(os, names[i].c_str());
+      os << "}}";
+    }
+
+    for (auto const& e : r.copy()) {
+      separator();
+      os << "{\"ph\":\"" << static_cast<char>(e.type) << "\",\"name\":";
+      write_escaped(os, e.name);
+      os << ",\"cat\":";
+      write_escaped(os, e.category);
+      os << ",\"pid\":" << pid << ",\"tid\":" << r.tid() << ",\"ts\":";
+      write_timestamp(os, e.timestamp);
+
+      switch (e.type) {
+      case phase::complete:
+        os << ",\"dur\":";
+        write_timestamp(os, e.duration);
+        break;
+      case phase::instant:
+        os << ",\"s\":\"t\"";
+        break;
+      case phase::flow_start:
+        os << ",\"id\":" << e.id;
+        break;
+      case phase::flow_end:
+        os << ",\"id\":" << e.id << ",\"bp\":\"e\"";
+        break;
+      }
+      os << '}';
+    }
+  }
+  os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+} // cyan::trace
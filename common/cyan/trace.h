@@ -0,0 +1,135 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include <cyan/config.h>
+
+// Opt-in execution tracer. Events are recorded into per-thread ring buffers
+// (single writer, no locks on the recording path) and can be dumped on
+// demand in the Chrome trace event format, which both chrome://tracing and
+// the Perfetto UI load. While tracing is disabled every hook costs a single
+// relaxed load.
+namespace cyan::trace {
+
+enum class phase : char {
+  complete = 'X',
+  instant = 'i',
+  flow_start = 's',
+  flow_end = 'f'
+};
+
+struct event {
+  char const* name;
+  char const* category;
+  std::uint64_t timestamp;
+  std::uint64_t duration;
+  std::uint64_t id;
+  phase type;
+};
+
+constexpr std::size_t default_capacity = 1u << 16;
+
+namespace detail {
+
+extern CYAN_API std::atomic<bool> enabled;
+
+CYAN_API std::uint64_t now() noexcept;
+CYAN_API void record(event const& e) noexcept;
+
+} // detail
+
+inline bool is_enabled() noexcept {
+  return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Starts recording; `capacity` is the number of events retained per thread
+// (rounded up to a power of two) and only applies to threads that have not
+// recorded anything yet.
+CYAN_API void enable(std::size_t capacity = default_capacity);
+CYAN_API void disable();
+
+// Drops every recorded event.
+CYAN_API void clear();
+
+// Names the calling thread in dumps.
+CYAN_API void set_thread_name(std::string const& name);
+
+// Returns a fresh, non-zero id to correlate a flow across threads.
+CYAN_API std::uint64_t next_flow_id() noexcept;
+
+// Writes every retained event as Chrome trace JSON. Safe to call while
+// other threads keep recording; events overwritten during the dump are
+// skipped.
+CYAN_API void write_chrome_trace(std::ostream& os);
+
+inline void instant(char const* name, char const* category) noexcept {
+  if (!is_enabled()) return;
+  detail::record(event{ name, category, detail::now(), 0, 0, phase::instant });
+}
+
+// Marks the start of a hand-off, e.g. a post to another thread. Returns the
+// id to pass to the `scope` that picks the work up, or 0 when disabled.
+inline std::uint64_t flow_start() noexcept {
+  if (!is_enabled()) return 0;
+  auto const id = next_flow_id();
+  detail::record(event{ "flow", "flow", detail::now(), 0, id, phase::flow_start });
+  return id;
+}
+
+// Records a complete slice for its lifetime. A non-zero `flow_id` binds the
+// slice to the flow started by `flow_start`.
+class scope {
+public:
+  scope(char const* name, char const* category, std::uint64_t flow_id = 0) noexcept
+        : name_{ name }, category_{ category }, begin_{ 0 } {
+    if (!is_enabled()) return;
+
+    begin_ = detail::now();
+    if (flow_id) {
+      detail::record(event{ "flow", "flow", begin_, 0, flow_id, phase::flow_end });
+    }
+  }
+
+  scope(scope const&) = delete;
+  scope& operator =(scope const&) = delete;
+
+  ~scope() {
+    if (begin_) {
+      detail::record(event{ name_, category_, begin_, detail::now() - begin_, 0, phase::complete });
+    }
+  }
+
+private:
+  char const* name_;
+  char const* category_;
+  std::uint64_t begin_;
+};
+
+} // cyan::trace
@@ -28,3 +28,11 @@
 #include <cyan/dispatch/handler.h>
 #include <cyan/dispatch/thread_pool.h>
 #include <cyan/dispatch/handler_thread.h>
+#include <cyan/dispatch/topology.h>
+#include <cyan/dispatch/channel.h>
+#include <cyan/dispatch/pipeline.h>
+#include <cyan/dispatch/blocking_pool.h>
+#include <cyan/dispatch/timer_service.h>
+#include <cyan/dispatch/rate_limiter.h>
+#include <cyan/dispatch/keyed_executor.h>
+#include <cyan/dispatch/log_writer.h>
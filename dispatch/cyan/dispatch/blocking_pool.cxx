@@ -0,0 +1,129 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <exception>
+
+#include <cyan/dispatch/topology.h>
+#include <cyan/dispatch/blocking_pool.h>
+
+namespace cyan::dispatch {
+
+namespace {
+
+class blocking_handler : public handler {
+public:
+  void on_initialize() override {}
+  void on_message(std::any&&) override {}
+  void on_finalize() override {}
+  void on_error(std::exception&) override {}
+};
+
+blocking_handler empty_handler;
+
+} // <anonymous>
+
+std::shared_ptr<blocking_pool> global_blocking_pool() {
+  static std::once_flag once_flag;
+  static std::shared_ptr<blocking_pool> blocking_pool;
+
+  std::call_once(once_flag, [&] {
+    blocking_pool = std::make_shared<cyan::dispatch::blocking_pool>();
+  });
+
+  return blocking_pool;
+}
+
+blocking_pool::blocking_pool(blocking_pool_options const& options) : options_{ options }, idle_{ 0 },
+      stopping_{ false } {
+}
+
+blocking_pool::~blocking_pool() {
+  std::unique_lock<std::mutex> lock{ mutex_ };
+  stopping_ = true;
+  available_.notify_all();
+  exited_.wait(lock, [this] { return threads_.empty(); });
+
+  auto finished = std::move(finished_);
+  lock.unlock();
+  for (auto& thread : finished) thread.join();
+}
+
+std::uint32_t blocking_pool::size() const {
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  return static_cast<std::uint32_t>(threads_.size());
+}
+
+void blocking_pool::enqueue(std::unique_ptr<detail::message>&& msg) {
+  std::vector<std::thread> finished;
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (stopping_) return;
+
+    tasks_.push_back(std::move(msg));
+    if (tasks_.size() > idle_ && threads_.size() < std::max(options_.max_threads, 1u)) {
+      std::thread thread{ &blocking_pool::execute, this };
+      auto const id = thread.get_id();
+      threads_.emplace(id, std::move(thread));
+    } else {
+      available_.notify_one();
+    }
+    finished.swap(finished_);
+  }
+
+  // Reap threads that exited after idling
+  for (auto& thread : finished) thread.join();
+}
+
+void blocking_pool::execute() {
+  detail::set_current_thread_name(options_.name);
+
+  std::unique_lock<std::mutex> lock{ mutex_ };
+  for (;;) {
+    if (!tasks_.empty()) {
+      auto msg = std::move(tasks_.front());
+      tasks_.pop_front();
+      lock.unlock();
+      msg->process(empty_handler);
+      msg = nullptr;
+      lock.lock();
+      continue;
+    }
+
+    if (stopping_) break;
+
+    idle_++;
+    auto const woken = available_.wait_for(lock, options_.keep_alive, [this] {
+      return !tasks_.empty() || stopping_;
+    });
+    idle_--;
+
+    if (!woken) break;
+  }
+
+  // Hand our own std::thread over to be joined by someone else
+  auto self = threads_.extract(std::this_thread::get_id());
+  finished_.push_back(std::move(self.mapped()));
+  exited_.notify_all();
+}
+
+} // cyan::dispatch
@@ -0,0 +1,84 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <cyan/noncopyable.h>
+#include <cyan/dispatch/message.h>
+
+namespace cyan::dispatch {
+
+// Options of a blocking_pool.
+//  - max_threads: upper bound on threads; tasks queue up beyond it.
+//  - keep_alive: how long an idle thread lingers before exiting.
+//  - name: thread name, see thread_options.
+struct blocking_pool_options {
+  std::uint32_t max_threads = 512;
+  std::chrono::milliseconds keep_alive{ 10000 };
+  std::string name = "cyan-blocking";
+};
+
+// Elastic pool for tasks that block (file I/O, fsync, blocking syscalls).
+// Its threads do not run an event loop, so blocking here never delays
+// timers or sockets of a handler_thread. Threads are started on demand and
+// exit after keep_alive without work.
+class blocking_pool : public cyan::noncopyable {
+public:
+  explicit blocking_pool(blocking_pool_options const& options = {});
+  ~blocking_pool();
+
+  template<typename Callable>
+  void post(Callable&& callback) {
+    enqueue(detail::make_callable_message(std::forward<Callable>(callback)));
+  }
+
+  std::uint32_t size() const;
+
+private:
+  void enqueue(std::unique_ptr<detail::message>&& msg);
+  void execute();
+
+  blocking_pool_options const options_;
+  mutable std::mutex mutex_;
+  std::condition_variable available_;
+  std::condition_variable exited_;
+  std::deque<std::unique_ptr<detail::message>> tasks_;
+  std::unordered_map<std::thread::id, std::thread> threads_;
+  std::vector<std::thread> finished_;
+  std::uint32_t idle_;
+  bool stopping_;
+};
+
+std::shared_ptr<blocking_pool> global_blocking_pool();
+
+} // cyan::dispatch
@@ -0,0 +1,230 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/dispatch/channel.h>
+
+#include <algorithm>
+
+namespace cyan::dispatch::detail {
+
+namespace {
+
+bool erase_waiter(std::deque<std::shared_ptr<channel_waiter>>& waiters, channel_waiter const* waiter) {
+  auto it = std::find_if(waiters.begin(), waiters.end(), [waiter](auto const& w) { return w.get() == waiter; });
+  if (it == waiters.end()) return false;
+  waiters.erase(it);
+  return true;
+}
+
+}
+
+channel_waiter::channel_waiter() : notifier_{ channel_notifier::current() } {
+}
+
+channel_waiter::channel_waiter(std::weak_ptr<channel_notifier> const& notifier) : notifier_{ notifier } {
+}
+
+void channel_waiter::wake() {
+  if (auto notifier = notifier_.lock()) {
+    notifier->notify(shared_from_this());
+  }
+}
+
+send_waiter::send_waiter() : channel_waiter{ std::weak_ptr<channel_notifier>{} }, woken_{ false } {
+}
+
+void send_waiter::resume() {
+}
+
+bool send_waiter::is_done() const {
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  return woken_;
+}
+
+void send_waiter::wake() {
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    woken_ = true;
+  }
+  woken_cv_.notify_one();
+}
+
+void send_waiter::wait() {
+  std::unique_lock<std::mutex> lock{ mutex_ };
+  woken_cv_.wait(lock, [this] { return woken_; });
+}
+
+std::shared_ptr<channel_notifier> channel_notifier::current() {
+  thread_local std::shared_ptr<channel_notifier> notifier;
+
+  if (!notifier) {
+    notifier = std::make_shared<channel_notifier>(cyan::this_thread::get_event_loop());
+  }
+  return notifier;
+}
+
+channel_notifier::channel_notifier(std::weak_ptr<cyan::event::loop> const& loop) : async_{ loop } {
+  async_.set_callback<&channel_notifier::drain>(this);
+  async_.start();
+}
+
+void channel_notifier::notify(std::shared_ptr<channel_waiter>&& waiter) {
+  ready_.enqueue(std::move(waiter));
+  async_.send();
+}
+
+void channel_notifier::drain() {
+  std::shared_ptr<channel_waiter> waiter;
+  while (ready_.try_dequeue(waiter)) {
+    waiter->resume();
+  }
+  waiter = nullptr;
+}
+
+channel_state_base::channel_state_base() : closed_{ false }, waiting_{ 0 }, sending_{ 0 } {
+}
+
+void channel_state_base::close() {
+  closed_.store(true, std::memory_order_seq_cst);
+  wake_all();
+}
+
+bool channel_state_base::is_closed() const {
+  return closed_.load(std::memory_order_acquire);
+}
+
+void channel_state_base::park(std::shared_ptr<channel_waiter> const& waiter) {
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    waiters_.push_back(waiter);
+    waiting_.fetch_add(1, std::memory_order_seq_cst);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void channel_state_base::unpark(channel_waiter const* waiter) {
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  if (erase_waiter(waiters_, waiter)) waiting_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void channel_state_base::wake_one() {
+  std::shared_ptr<channel_waiter> waiter;
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    while (!waiters_.empty()) {
+      waiter = std::move(waiters_.front());
+      waiters_.pop_front();
+      waiting_.fetch_sub(1, std::memory_order_relaxed);
+
+      // Left behind by a select that completed on another channel
+      if (!waiter->is_done()) break;
+      waiter = nullptr;
+    }
+  }
+
+  if (waiter) waiter->wake();
+}
+
+void channel_state_base::wake_all() {
+  std::deque<std::shared_ptr<channel_waiter>> waiters;
+  std::deque<std::shared_ptr<channel_waiter>> senders;
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    waiters.swap(waiters_);
+    senders.swap(senders_);
+    waiting_.store(0, std::memory_order_relaxed);
+    sending_.store(0, std::memory_order_relaxed);
+  }
+
+  for (auto& waiter : waiters) waiter->wake();
+  for (auto& sender : senders) sender->wake();
+}
+
+void channel_state_base::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting_.load(std::memory_order_relaxed)) wake_one();
+}
+
+void channel_state_base::park_sender(std::shared_ptr<channel_waiter> const& waiter) {
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    senders_.push_back(waiter);
+    sending_.fetch_add(1, std::memory_order_seq_cst);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void channel_state_base::unpark_sender(channel_waiter const* waiter) {
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  if (erase_waiter(senders_, waiter)) sending_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void channel_state_base::notify_sender() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!sending_.load(std::memory_order_relaxed)) return;
+
+  std::shared_ptr<channel_waiter> sender;
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (senders_.empty()) return;
+    sender = std::move(senders_.front());
+    senders_.pop_front();
+    sending_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  sender->wake();
+}
+
+select_state::select_state() : done_{ false } {
+}
+
+bool select_state::is_done() const {
+  return done_.load(std::memory_order_acquire);
+}
+
+void select_state::park(std::shared_ptr<channel_state_base> const& channel,
+      std::shared_ptr<channel_waiter> const& waiter) {
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  if (is_done()) return;
+
+  channel->park(waiter);
+  auto const parked = std::find_if(parked_.begin(), parked_.end(), [&](auto const& p) { return p.second.lock() == waiter; });
+  if (parked == parked_.end()) parked_.emplace_back(channel, waiter);
+}
+
+void select_state::complete() {
+  done_.store(true, std::memory_order_release);
+
+  std::vector<std::pair<std::weak_ptr<channel_state_base>, std::weak_ptr<channel_waiter>>> parked;
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    parked.swap(parked_);
+  }
+
+  for (auto& [channel, waiter] : parked) {
+    auto state = channel.lock();
+    auto parked_waiter = waiter.lock();
+    if (state && parked_waiter) state->unpark(parked_waiter.get());
+  }
+}
+
+} // cyan::dispatch::detail
@@ -0,0 +1,360 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <optional>
+#include <functional>
+#include <condition_variable>
+#include <type_traits>
+
+#include <cyan/event.h>
+#include <cyan/noncopyable.h>
+#include <cyan/lockfree/queue.h>
+
+namespace cyan::dispatch {
+
+namespace detail {
+
+class channel_notifier;
+
+// A pending receive. Resumed on the event loop of the thread that started
+// the receive.
+class channel_waiter : public std::enable_shared_from_this<channel_waiter> {
+public:
+  channel_waiter();
+  virtual ~channel_waiter() = default;
+
+  virtual void resume() = 0;
+  virtual bool is_done() const = 0;
+
+  virtual void wake();
+
+protected:
+  explicit channel_waiter(std::weak_ptr<channel_notifier> const& notifier);
+
+private:
+  std::weak_ptr<channel_notifier> notifier_;
+};
+
+// A sender blocked on a full bounded channel. The sender blocks its own
+// thread rather than running a loop, so a wake-up signals it directly.
+class send_waiter : public channel_waiter {
+public:
+  send_waiter();
+
+  void resume() override;
+  bool is_done() const override;
+  void wake() override;
+
+  void wait();
+
+private:
+  mutable std::mutex mutex_;
+  std::condition_variable woken_cv_;
+  bool woken_;
+};
+
+// One per receiving thread: an async watcher on the thread's loop and the
+// waiters that are ready to be resumed there.
+class channel_notifier : public cyan::noncopyable {
+public:
+  static std::shared_ptr<channel_notifier> current();
+
+  explicit channel_notifier(std::weak_ptr<cyan::event::loop> const& loop);
+
+  void notify(std::shared_ptr<channel_waiter>&& waiter);
+
+private:
+  void drain();
+
+  cyan::lockfree::queue<std::shared_ptr<channel_waiter>> ready_;
+  cyan::event::async async_;
+};
+
+class channel_state_base : public cyan::noncopyable {
+public:
+  channel_state_base();
+
+  void close();
+  bool is_closed() const;
+
+  void park(std::shared_ptr<channel_waiter> const& waiter);
+  // Withdraws a parked receive, e.g. the losing cases of a select
+  void unpark(channel_waiter const* waiter);
+  void wake_one();
+  void wake_all();
+  // Called by senders after queueing a value
+  void notify();
+
+  void park_sender(std::shared_ptr<channel_waiter> const& waiter);
+  void unpark_sender(channel_waiter const* waiter);
+  // Called by receivers after taking a value from a bounded channel
+  void notify_sender();
+
+private:
+  std::atomic<bool> closed_;
+  std::atomic<std::size_t> waiting_;
+  std::atomic<std::size_t> sending_;
+  std::mutex mutex_;
+  std::deque<std::shared_ptr<channel_waiter>> waiters_;
+  std::deque<std::shared_ptr<channel_waiter>> senders_;
+};
+
+template<typename T>
+class channel_state : public channel_state_base {
+public:
+  explicit channel_state(std::size_t capacity) : capacity_{ capacity }, size_{ 0 } {}
+
+  bool try_send(T&& value) {
+    if (is_closed() || !reserve()) return false;
+    queue_.enqueue(std::optional<T>{ std::forward<T>(value) });
+    notify();
+    return true;
+  }
+
+  bool try_receive(T& value) {
+    std::optional<T> received;
+    if (!try_receive(received)) return false;
+    value = std::move(*received);
+    return true;
+  }
+
+  bool try_receive(std::optional<T>& value) {
+    // The queue is only safe with one consumer at a time
+    while (receiving_.test_and_set(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+
+    auto const received = queue_.try_dequeue(value);
+    receiving_.clear(std::memory_order_release);
+    if (!received) return false;
+    size_.fetch_sub(1, std::memory_order_acq_rel);
+    if (capacity_) notify_sender();
+    return true;
+  }
+
+  bool is_full() const {
+    return capacity_ && size() >= capacity_;
+  }
+
+  bool empty() const {
+    return queue_.empty();
+  }
+
+  std::size_t size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  std::size_t capacity() const {
+    return capacity_;
+  }
+
+private:
+  bool reserve() {
+    if (!capacity_) {
+      size_.fetch_add(1, std::memory_order_acq_rel);
+      return true;
+    }
+
+    auto size = size_.load(std::memory_order_acquire);
+    do {
+      if (size >= capacity_) return false;
+    } while (!size_.compare_exchange_weak(size, size + 1, std::memory_order_acq_rel));
+    return true;
+  }
+
+  std::size_t const capacity_;
+  std::atomic<std::size_t> size_;
+  std::atomic_flag receiving_;
+  // Optional so that T need not be default constructible
+  cyan::lockfree::queue<std::optional<T>> queue_;
+};
+
+// Shared by the cases of one select. Cases parked on their channels are
+// withdrawn as soon as one of them completes.
+class select_state : public cyan::noncopyable {
+public:
+  select_state();
+
+  bool is_done() const;
+  // Parks `waiter` on `channel` unless the select already completed
+  void park(std::shared_ptr<channel_state_base> const& channel, std::shared_ptr<channel_waiter> const& waiter);
+  void complete();
+
+private:
+  std::atomic<bool> done_;
+  std::mutex mutex_;
+  std::vector<std::pair<std::weak_ptr<channel_state_base>, std::weak_ptr<channel_waiter>>> parked_;
+};
+
+template<typename T, typename Callback>
+class select_waiter : public channel_waiter {
+public:
+  select_waiter(std::shared_ptr<channel_state<T>> const& state, Callback&& callback,
+        std::shared_ptr<select_state> const& select)
+        : state_{ state }, callback_{ std::forward<Callback>(callback) }, select_{ select } {}
+
+  void resume() override {
+    // Parked waiters are owned by the channel, so they must not own it back
+    auto state = state_.lock();
+
+    // Another case of the select won; pass the wake-up on
+    if (is_done()) {
+      if (state && !state->empty()) state->wake_one();
+      return;
+    }
+
+    std::optional<T> value;
+    if (!state || (state->is_closed() && state->empty())) {
+      complete(std::nullopt);
+    } else if (state->try_receive(value)) {
+      complete(std::move(value));
+    } else {
+      select_->park(state, shared_from_this());
+      // A send or close that raced with parking may not have seen us
+      if (!state->empty() || state->is_closed()) state->wake_one();
+    }
+  }
+
+  bool is_done() const override {
+    return select_->is_done();
+  }
+
+private:
+  void complete(std::optional<T>&& value) {
+    select_->complete();
+    callback_(std::move(value));
+  }
+
+  std::weak_ptr<channel_state<T>> state_;
+  std::decay_t<Callback> callback_;
+  std::shared_ptr<select_state> select_;
+};
+
+template<typename T, typename Callback>
+struct select_case {
+  std::shared_ptr<channel_state<T>> state;
+  Callback callback;
+
+  void start(std::shared_ptr<select_state> const& select) {
+    std::make_shared<select_waiter<T, Callback>>(state, std::move(callback), select)->wake();
+  }
+};
+
+} // detail
+
+// Typed channel for handing values between threads. Capacity 0 makes the
+// channel unbounded. Copies refer to the same channel.
+//
+// Receives are asynchronous: the callback runs on the event loop of the
+// thread that called receive() (e.g. inside a handler_thread), with an empty
+// optional once the channel is closed and drained.
+template<typename T>
+class channel {
+public:
+  using value_type = T;
+
+  explicit channel(std::size_t capacity = 0)
+        : state_{ std::make_shared<detail::channel_state<T>>(capacity) } {}
+
+  bool try_send(T value) {
+    return state_->try_send(std::move(value));
+  }
+
+  // Blocks the calling thread while a bounded channel is full, until a
+  // receive frees a slot. Returns false if the channel is closed.
+  bool send(T value) {
+    while (!state_->try_send(std::move(value))) {
+      if (state_->is_closed()) return false;
+
+      auto waiter = std::make_shared<detail::send_waiter>();
+      state_->park_sender(waiter);
+      // A receive or close that raced with parking may not have seen us
+      if (!state_->is_full() || state_->is_closed()) {
+        state_->unpark_sender(waiter.get());
+      } else {
+        waiter->wait();
+      }
+    }
+    return true;
+  }
+
+  bool try_receive(T& value) {
+    return state_->try_receive(value);
+  }
+
+  template<typename Callback>
+  void receive(Callback&& callback);
+
+  void close() {
+    state_->close();
+  }
+
+  bool is_closed() const {
+    return state_->is_closed();
+  }
+
+  std::size_t size() const {
+    return state_->size();
+  }
+
+  std::size_t capacity() const {
+    return state_->capacity();
+  }
+
+private:
+  template<typename U, typename Callback>
+  friend auto on(channel<U> const& ch, Callback&& callback) -> detail::select_case<U, std::decay_t<Callback>>;
+
+  std::shared_ptr<detail::channel_state<T>> state_;
+};
+
+// A case of select(): `callback` receives the value taken from `ch`.
+template<typename T, typename Callback>
+auto on(channel<T> const& ch, Callback&& callback) -> detail::select_case<T, std::decay_t<Callback>> {
+  static_assert(std::is_invocable_v<Callback, std::optional<T>&&>, "on: callback must accept std::optional<T>");
+  return { ch.state_, std::forward<Callback>(callback) };
+}
+
+// Waits on several channels at once and runs the callback of exactly one
+// case, the first to become ready, on the calling thread's event loop.
+template<typename ...Cases>
+void select(Cases&&... cases) {
+  auto state = std::make_shared<detail::select_state>();
+  (cases.start(state), ...);
+}
+
+template<typename T>
+template<typename Callback>
+void channel<T>::receive(Callback&& callback) {
+  select(on(*this, std::forward<Callback>(callback)));
+}
+
+} // cyan::dispatch
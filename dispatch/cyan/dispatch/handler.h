@@ -25,6 +25,7 @@
 
 #include <any>
 #include <exception>
+#include <stdexcept>
 
 namespace cyan::dispatch {
 
@@ -36,4 +37,32 @@ struct handler {
   virtual void on_error(std::exception&) = 0;
 };
 
+namespace detail {
+
+template<typename T>
+struct receiver {
+  virtual ~receiver() = default;
+  virtual void on_message(T&&) = 0;
+};
+
+} // detail
+
+// Handler with one `on_message(T&&)` overload per payload type. Used with
+// typed_handler_thread, payloads are stored in the message itself and
+// dispatched to the matching overload without going through std::any.
+template<typename ...Ts>
+struct typed_handler : public handler, public detail::receiver<Ts>... {
+  using detail::receiver<Ts>::on_message...;
+
+  void on_initialize() override {}
+  // Only reached by a payload sent through handler_thread::send, which
+  // bypasses the payload type check; the payload is dropped and on_error
+  // called with std::invalid_argument
+  void on_message(std::any&&) override {
+    throw std::invalid_argument{ "typed_handler: untyped payload; send through typed_handler_thread" };
+  }
+  void on_finalize() override {}
+  void on_error(std::exception&) override {}
+};
+
 }
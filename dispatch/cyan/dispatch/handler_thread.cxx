@@ -22,9 +22,14 @@
  * SOFTWARE.
  **/
 #include <atomic>
+#include <future>
+#include <algorithm>
 #include <exception>
 
 #include <cyan/event.h>
+#include <cyan/trace.h>
+#include <cyan/dispatch/topology.h>
+#include <cyan/dispatch/work_group.h>
 #include <cyan/dispatch/handler_thread.h>
 
 
@@ -40,23 +45,46 @@ public:
 
 static default_handler empty_handler;
 
+namespace {
+
+// Handler thread whose queue is being processed on the calling thread.
+thread_local void const* processing = nullptr;
+
+} // <anonymous>
+
 template<
   template<typename, typename> typename QueueType,
   template<typename> typename Alloc
 >
-class handler_thread::handler_thread_impl {
+class handler_thread::handler_thread_impl : public detail::work_group::member {
 public:
   using queue_type = QueueType<std::unique_ptr<detail::message>,
         Alloc<std::unique_ptr<detail::message>>>;
 
-  handler_thread_impl(handler& h) : handler_{ &h },
-        queue_{ std::make_unique<queue_type>() },
-        stopping_{ false }, running_{ false },
-        thread_{ &handler_thread_impl::execute, this } {
+  // Consecutive runs out of the LIFO slot before it is flushed to the back of
+  // the queue, so that a task re-posting itself cannot starve the queue.
+  static constexpr unsigned max_lifo_runs = 32;
+
+  // Deadline tasks run in a row before a waiting ordinary task gets its
+  // turn, so that a steady stream of them cannot starve the queue.
+  static constexpr unsigned max_deadline_runs = 8;
+
+  handler_thread_impl(handler& h, thread_options const& options,
+        std::shared_ptr<detail::work_group> group = nullptr, std::uint32_t index = 0)
+        : handler_{ &h }, options_{ options }, group_{ std::move(group) }, index_{ index },
+        deadline_runs_{ 0 }, idle_{ false }, stopping_{ false }, running_{ false } {
+    std::promise<void> ready;
+    auto future = ready.get_future();
+    thread_ = std::thread{ &handler_thread_impl::execute, this, std::move(ready) };
+    future.wait();
   }
 
   ~handler_thread_impl() {
     stop(true);
+    join();
+  }
+
+  void join() {
     if (thread_.joinable()) {
       thread_.join();
     }
@@ -80,9 +108,34 @@ public:
     return running_.load(std::memory_order_acquire);
   }
 
+  latency_statistics get_latency_statistics() const {
+    return latency_.snapshot();
+  }
+
+  thread_statistics get_statistics() const {
+    return statistics_.snapshot();
+  }
+
   void enqueue(std::unique_ptr<detail::message>&& msg) {
     if (is_stopping()) return;
 
+    statistics_.on_enqueue();
+
+    if (msg->has_deadline()) {
+      deadline_queue_->enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
+      if (queued_event_) queued_event_->send();
+      return;
+    }
+
+    // Posted by a message running on this pool worker: run it next, while
+    // its data is still in cache, instead of behind the rest of the queue.
+    // A standalone thread keeps posting order.
+    if (group_ && processing == this && msg->get_timeout().count() == 0) {
+      if (next_) flush_next();
+      next_ = std::forward<std::unique_ptr<detail::message>>(msg);
+      return;
+    }
+
     queue_->enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
 
     if (queued_event_) {
@@ -90,18 +143,101 @@ public:
     }
   }
 
+  // The poster is likely to block on the result, and siblings never steal
+  // the LIFO slot: queue it, and whatever the slot holds ahead of it, where
+  // an idle sibling can take it.
+  void enqueue_awaited(std::unique_ptr<detail::message>&& msg) {
+    if (processing != this) {
+      enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
+      return;
+    }
+    if (is_stopping()) return;
+
+    statistics_.on_enqueue();
+    if (next_) queue_->enqueue(std::move(next_));
+    queue_->enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
+    queued_event_->send();
+    if (group_) group_->wake_one(index_);
+  }
+
+  bool try_steal(std::unique_ptr<detail::message>& msg) override {
+    if (is_stopping() || consuming_.test_and_set(std::memory_order_acquire)) return false;
+
+    auto const dequeued = queue_->try_dequeue(msg);
+    consuming_.clear(std::memory_order_release);
+    if (!dequeued) return false;
+
+    // Lost a race with stop(); hand the stop message back
+    if (msg->get_type() == detail::message::type_t::stop) {
+      enqueue_unsafe(std::move(msg));
+      return false;
+    }
+
+    statistics_.on_stolen();
+    return true;
+  }
+
+  bool try_wake() override {
+    // Pairs with the fence in process_queue: either the member sees the
+    // work queued before this call, or this sees it idle
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto expected = true;
+    if (is_stopping() || !idle_.compare_exchange_strong(expected, false, std::memory_order_seq_cst)) {
+      return false;
+    }
+
+    queued_event_->send();
+    return true;
+  }
+
 private:
   void enqueue_unsafe(std::unique_ptr<detail::message>&& msg) {
     queue_->enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
     queued_event_->send();
   }
 
-  void execute() {
-    if (is_stopping()) return;
+  // The queue moves a value out before claiming it, which is only safe with a
+  // single consumer at a time. Thieves give up when the owner is dequeuing;
+  // the owner waits out a thief, which holds the flag for one dequeue.
+  bool try_dequeue(std::unique_ptr<detail::message>& msg) {
+    while (consuming_.test_and_set(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+
+    auto const dequeued = queue_->try_dequeue(msg);
+    consuming_.clear(std::memory_order_release);
+    return dequeued;
+  }
+
+  void reenqueue(std::unique_ptr<detail::message>&& msg) {
+    statistics_.on_reenqueue();
+    queue_->enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
+  }
+
+  void execute(std::promise<void> ready) {
+    detail::set_current_thread_affinity(options_.cpus);
+    detail::set_current_thread_name(options_.name);
+
+    // Allocated here rather than in the constructor so that the queue and its
+    // node pool land on the NUMA node this thread has been pinned to.
+    queue_ = std::make_unique<queue_type>();
+    deadline_queue_ = std::make_unique<queue_type>();
+    if (options_.reserve) queue_->reserve(options_.reserve);
+
+    if (group_) {
+      group_->set_current(index_);
+      group_->join(index_, this);
+    }
+
     running_.store(true, std::memory_order_release);
+    statistics_.on_start();
 
     initialize_message_queue();
 
+    // Only now can stop() reach the thread, so that a stop right after
+    // construction still drains whatever was posted before it
+    ready.set_value();
+
     try {
       handler_->on_initialize();
     } catch (std::exception& e) {
@@ -111,7 +247,10 @@ private:
     // Handle enqueued messages before thread was started
     process_queue();
 
-    cyan::this_thread::get_event_loop()->start();
+    // A stop handled above has nothing to break out of yet
+    if (!is_stopping() || !is_drained()) {
+      cyan::this_thread::get_event_loop()->start();
+    }
 
     try {
       handler_->on_finalize();
@@ -119,6 +258,7 @@ private:
       handler_->on_error(e);
     }
 
+    if (group_) group_->leave(index_);
     running_.store(false, std::memory_order_release);
   }
 
@@ -130,54 +270,220 @@ private:
     queued_event_->start();
     timer_wheel_->start();
 
-    queued_event_->set_callback(std::bind(&handler_thread_impl::process_queue, this));
+    queued_event_->set_callback<&handler_thread_impl::process_queue>(this);
   }
 
   void process_queue() {
+    statistics_.on_loop_iteration();
+    idle_.store(false, std::memory_order_release);
+    processing = this;
+
+    auto const max_time = options_.max_batch_time;
+    auto const deadline = max_time.count() > 0 ? std::chrono::steady_clock::now() + max_time
+          : std::chrono::steady_clock::time_point::max();
+    auto const max_size = options_.max_batch_size ? options_.max_batch_size : ~0u;
+    std::uint32_t processed = 0;
+    auto yielded = false;
+
     std::unique_ptr<detail::message> msg;
-    while (queue_->try_dequeue(msg)) {
-      auto timeout = msg->get_timeout();
-      if (timeout.count() > 0) {
-        timer_wheel_->post([this, msg = std::move(msg)] {
-          msg->process(*handler_);
-        }, timeout);
-      } else {
-        if (msg->try_acquire()) {
-          msg->process(*handler_);
-        } else {
-          enqueue(std::move(msg));
-        }
+    for (;;) {
+      if (processed >= max_size || (max_time.count() > 0 && std::chrono::steady_clock::now() >= deadline)) {
+        yielded = true;
+        break;
+      }
+
+      if (next(msg)) {
+        statistics_.on_dequeue();
+      } else if (!group_ || is_stopping()) {
+        break;
+      } else if (!group_->steal(index_, msg)) {
+        if (idle_.load(std::memory_order_relaxed)) break;
+
+        // A sibling may have tried to wake us while we were still busy;
+        // go idle first, then look once more before sleeping
+        idle_.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        continue;
       }
+      idle_.store(false, std::memory_order_relaxed);
+
+      dispatch(std::move(msg));
+      processed++;
+      processed += run_next(max_size - processed);
+    }
+
+    processing = nullptr;
+
+    // Out of budget: let the loop run timers and I/O, then come back
+    if (yielded) {
+      statistics_.on_yield();
+      queued_event_->send();
+      return;
     }
+    idle_.store(true, std::memory_order_release);
 
-    if (is_stopping() && queue_->empty()) {
+    if (is_stopping() && is_drained()) {
       cyan::this_thread::get_event_loop()->stop();
     }
   }
 
+  bool is_drained() const {
+    return queue_->empty() && deadline_queue_->empty() && deadlines_.empty();
+  }
+
+  bool next(std::unique_ptr<detail::message>& msg) {
+    if (deadline_runs_ < max_deadline_runs && next_by_deadline(msg)) {
+      deadline_runs_++;
+      return true;
+    }
+    if (try_dequeue(msg)) {
+      deadline_runs_ = 0;
+      return true;
+    }
+    // Nothing else waits
+    deadline_runs_ = 0;
+    return next_by_deadline(msg);
+  }
+
+  // Moves newly posted deadline tasks into the heap and takes the earliest
+  // that can still start in time, dropping the ones that cannot.
+  bool next_by_deadline(std::unique_ptr<detail::message>& msg) {
+    auto const later = [](auto const& a, auto const& b) { return a->get_deadline() > b->get_deadline(); };
+
+    std::unique_ptr<detail::message> incoming;
+    while (deadline_queue_->try_dequeue(incoming)) {
+      deadlines_.push_back(std::move(incoming));
+      std::push_heap(deadlines_.begin(), deadlines_.end(), later);
+    }
+    if (deadlines_.empty()) return false;
+
+    auto const now = std::chrono::steady_clock::now();
+    while (!deadlines_.empty()) {
+      std::pop_heap(deadlines_.begin(), deadlines_.end(), later);
+      msg = std::move(deadlines_.back());
+      deadlines_.pop_back();
+
+      auto const late = now - msg->get_deadline();
+      if (late.count() <= 0) return true;
+
+      msg = nullptr;
+      drop(late);
+    }
+    return false;
+  }
+
+  void drop(std::chrono::steady_clock::duration late) {
+    statistics_.on_dequeue();
+    statistics_.on_dropped();
+
+    if (!options_.on_deadline_missed) return;
+    try {
+      options_.on_deadline_missed(std::chrono::duration_cast<std::chrono::nanoseconds>(late));
+    } catch (std::exception& e) {
+      handler_->on_error(e);
+    }
+  }
+
+  std::uint32_t run_next(std::uint32_t budget) {
+    auto const max_runs = std::min(max_lifo_runs, budget);
+    auto runs = 0u;
+    for (; next_ && runs < max_runs; runs++) {
+      auto msg = std::move(next_);
+      statistics_.on_dequeue();
+      dispatch(std::move(msg));
+    }
+
+    if (next_) flush_next();
+    return runs;
+  }
+
+  // Moves the LIFO slot to the back of the queue, where idle siblings can
+  // steal it.
+  void flush_next() {
+    queue_->enqueue(std::move(next_));
+    if (group_) group_->wake_one(index_);
+  }
+
+  void dispatch(std::unique_ptr<detail::message>&& msg) {
+    auto timeout = msg->get_timeout();
+    if (timeout.count() > 0) {
+      timer_wheel_->post([this, msg = std::move(msg)] {
+        process(*msg);
+      }, timeout);
+    } else {
+      if (msg->try_acquire()) {
+        process(*msg);
+      } else {
+        reenqueue(std::move(msg));
+      }
+    }
+  }
+
+  void process(detail::message& msg) {
+    msg.process(*handler_);
+    if (msg.get_type() != detail::message::type_t::stop) {
+      latency_.record(msg);
+      statistics_.on_execute(msg.processing_time());
+    }
+  }
+
   handler* handler_;
+  thread_options const options_;
+  std::shared_ptr<detail::work_group> const group_;
+  std::uint32_t const index_;
   std::unique_ptr<queue_type> queue_;
+  std::unique_ptr<queue_type> deadline_queue_;
+  std::vector<std::unique_ptr<detail::message>> deadlines_;
+  std::unique_ptr<detail::message> next_;
+  unsigned deadline_runs_;
   std::unique_ptr<cyan::event::async> queued_event_;
   std::unique_ptr<cyan::event::timer_wheel> timer_wheel_;
+  detail::latency_recorder latency_;
+  detail::statistics_recorder statistics_;
+  std::atomic<bool> idle_;
+  std::atomic_flag consuming_;
   std::atomic<bool> stopping_;
   std::atomic<bool> running_;
   std::thread thread_;
 };
 
-handler_thread::handler_thread() : impl_{ std::make_unique<default_impl_type>(empty_handler) } {
+handler_thread::handler_thread() : handler_thread{ empty_handler, thread_options{} } {
+}
+
+handler_thread::handler_thread(handler& h) : handler_thread{ h, thread_options{} } {
+}
+
+handler_thread::handler_thread(thread_options const& options) : handler_thread{ empty_handler, options } {
+}
+
+handler_thread::handler_thread(handler& h, thread_options const& options)
+      : impl_{ std::make_shared<default_impl_type>(h, options) } {
 }
 
-handler_thread::handler_thread(handler& h) : impl_{ std::make_unique<default_impl_type>(h) } {
+handler_thread::handler_thread(thread_options const& options, std::shared_ptr<detail::work_group> group,
+      std::uint32_t index)
+      : impl_{ std::make_shared<default_impl_type>(empty_handler, options, std::move(group), index) } {
 }
 
 handler_thread::handler_thread(handler_thread&& other) : impl_{ std::move(other.impl_) } {
   other.impl_ = nullptr;
 }
 
+// A blocking task still in flight may hold the impl a little longer; stop
+// and join here so the thread is gone, and late completions are dropped,
+// by the time this returns.
 handler_thread::~handler_thread() {
+  if (impl_) {
+    impl_->stop(true);
+    impl_->join();
+  }
 }
 
 handler_thread& handler_thread::operator =(handler_thread&& other) {
+  if (impl_) {
+    impl_->stop(true);
+    impl_->join();
+  }
   impl_ = std::move(other.impl_);
   other.impl_ = nullptr;
   return *this;
@@ -187,6 +493,10 @@ void handler_thread::stop(bool safe) {
   impl_->stop(safe);
 }
 
+void handler_thread::join() {
+  impl_->join();
+}
+
 bool handler_thread::is_stopping() const {
   return impl_->is_stopping();
 }
@@ -195,8 +505,26 @@ bool handler_thread::is_running() const {
   return impl_->is_running();
 }
 
+latency_statistics handler_thread::get_latency_statistics() const {
+  return impl_->get_latency_statistics();
+}
+
+thread_statistics handler_thread::get_statistics() const {
+  return impl_->get_statistics();
+}
+
 void handler_thread::enqueue(std::unique_ptr<detail::message>&& msg) {
   impl_->enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
 }
 
+void handler_thread::enqueue_awaited(std::unique_ptr<detail::message>&& msg) {
+  impl_->enqueue_awaited(std::forward<std::unique_ptr<detail::message>>(msg));
+}
+
+void handler_thread::enqueue(std::weak_ptr<default_impl_type> const& impl, std::unique_ptr<detail::message>&& msg) {
+  if (auto target = impl.lock()) {
+    target->enqueue(std::forward<std::unique_ptr<detail::message>>(msg));
+  }
+}
+
 } // cyan::dispatch
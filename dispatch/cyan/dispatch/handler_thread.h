@@ -25,26 +25,67 @@
 
 #include <memory>
 #include <future>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
 
 #include <cyan/noncopyable.h>
 #include <cyan/lockfree/queue.h>
 #include <cyan/dispatch/handler.h>
 #include <cyan/dispatch/message.h>
+#include <cyan/dispatch/statistics.h>
+#include <cyan/dispatch/blocking_pool.h>
 
 namespace cyan::dispatch {
 
+namespace detail {
+
+class work_group;
+
+}
+
+// Placement of a handler thread.
+//  - name: shown by debuggers, top and traces; truncated to the platform
+//    limit.
+//  - cpus: CPUs the thread may run on; empty leaves scheduling to the OS.
+//  - reserve: minimum queue nodes to preallocate. The queue is built on
+//    the thread itself after pinning, so first-touch places it and its node
+//    pool on the thread's NUMA node.
+//  - max_batch_size, max_batch_time: budget for one pass over the queue,
+//    after which the thread goes back to its event loop so timers and I/O
+//    watchers get to run, and resumes the queue on the next iteration. Zero
+//    means unlimited.
+//  - on_deadline_missed: called on the thread, with how late it was, for
+//    every task posted with a deadline that passed before it started. The
+//    task is dropped either way.
+struct thread_options {
+  std::string name;
+  std::vector<std::uint32_t> cpus;
+  std::size_t reserve = 0;
+  std::uint32_t max_batch_size = 0;
+  std::chrono::nanoseconds max_batch_time{ 0 };
+  std::function<void(std::chrono::nanoseconds)> on_deadline_missed;
+};
+
 class handler_thread : public cyan::noncopyable {
 public:
   handler_thread();
   handler_thread(handler& h);
+  explicit handler_thread(thread_options const& options);
+  handler_thread(handler& h, thread_options const& options);
   explicit handler_thread(handler_thread&& other);
   ~handler_thread();
 
   handler_thread& operator =(handler_thread&& other);
 
   void stop(bool safe = true);
+  void join();
   bool is_stopping() const;
   bool is_running() const;
+  latency_statistics get_latency_statistics() const;
+  thread_statistics get_statistics() const;
 
   template<typename T>
   void send(T&& payload) {
@@ -73,13 +114,23 @@ public:
     enqueue(detail::make_callable_message(std::forward<Callable>(callback), timeout));
   }
 
+  // Runs `callback` unless it cannot start by `deadline`. Tasks with a
+  // deadline go ahead of the rest of the queue, earliest deadline first,
+  // a few at a time.
+  template<typename Callable>
+  void post_before(Callable&& callback, std::chrono::steady_clock::time_point deadline) {
+    auto msg = detail::make_callable_message(std::forward<Callable>(callback));
+    msg->set_deadline(deadline);
+    enqueue(std::move(msg));
+  }
+
   template<typename Callable>
   [[nodiscard]]
   auto post_awaitable(Callable&& callback) -> std::future<std::invoke_result_t<Callable>> {
     auto task = std::packaged_task<std::invoke_result_t<Callable>()>{ std::forward<Callable>(callback) };
     auto future = task.get_future();
 
-    post(std::move(task));
+    enqueue_awaited(detail::make_callable_message(std::move(task)));
 
     return future;
   }
@@ -90,7 +141,9 @@ public:
     auto task = std::packaged_task<std::invoke_result_t<Callable>()>{ std::forward<Callable>(callback) };
     auto future = task.get_future();
 
-    post(token, std::move(task));
+    auto msg = detail::make_callable_message(std::move(task));
+    msg->set_serial_token(token);
+    enqueue_awaited(std::move(msg));
 
     return future;
   }
@@ -108,10 +161,35 @@ public:
     return future;
   }
 
+  // Runs `callback` on the blocking pool, keeping this thread's loop free,
+  // then hands `completion` a ready std::future of its result on this
+  // thread. The completion is dropped if this thread is stopped or destroyed
+  // before the task finishes.
+  template<typename Callable, typename Completion>
+  void post_blocking(Callable&& callback, Completion&& completion) {
+    using result_type = std::invoke_result_t<Callable>;
+
+    auto task = std::packaged_task<result_type()>{ std::forward<Callable>(callback) };
+    auto future = task.get_future();
+
+    global_blocking_pool()->post([impl = std::weak_ptr<default_impl_type>{ impl_ }, task = std::move(task),
+          future = std::move(future), completion = std::forward<Completion>(completion)] () mutable {
+      task();
+      enqueue(impl, detail::make_callable_message([completion = std::move(completion), future = std::move(future)] () mutable {
+        completion(std::move(future));
+      }));
+    });
+  }
+
 protected:
   void enqueue(std::unique_ptr<detail::message>&& msg);
 
 private:
+  friend class thread_pool;
+
+  handler_thread(thread_options const& options, std::shared_ptr<detail::work_group> group,
+        std::uint32_t index);
+
   template<
     template<typename, typename> typename QueueType,
     template<typename> typename Alloc = std::allocator
@@ -119,7 +197,35 @@ private:
   class handler_thread_impl;
 
   using default_impl_type = handler_thread_impl<cyan::lockfree::queue>;
-  std::unique_ptr<default_impl_type> impl_;
+
+  static void enqueue(std::weak_ptr<default_impl_type> const& impl, std::unique_ptr<detail::message>&& msg);
+  void enqueue_awaited(std::unique_ptr<detail::message>&& msg);
+
+  std::shared_ptr<default_impl_type> impl_;
+};
+
+// Handler thread whose payloads are limited to Ts at compile time, stored in
+// place in the message and delivered to the typed_handler's matching
+// on_message overload.
+template<typename ...Ts>
+class typed_handler_thread : public handler_thread {
+public:
+  using handler_type = typed_handler<Ts...>;
+
+  explicit typed_handler_thread(handler_type& h, thread_options const& options = {})
+        : handler_thread{ h, options } {}
+
+  template<typename T>
+  void send(T&& payload) {
+    static_assert((std::is_same_v<std::decay_t<T>, Ts> || ...), "typed_handler_thread: unsupported payload type");
+    enqueue(detail::make_typed_payload_message<handler_type>(std::forward<T>(payload)));
+  }
+
+  template<typename T, typename R, typename D>
+  void send(T&& payload, std::chrono::duration<R, D> const& timeout) {
+    static_assert((std::is_same_v<std::decay_t<T>, Ts> || ...), "typed_handler_thread: unsupported payload type");
+    enqueue(detail::make_typed_payload_message<handler_type>(std::forward<T>(payload), timeout));
+  }
 };
 
 }
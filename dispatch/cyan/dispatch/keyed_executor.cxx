@@ -0,0 +1,125 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <exception>
+
+#include <cyan/dispatch/keyed_executor.h>
+
+namespace cyan::dispatch::detail {
+
+namespace {
+
+class strand_handler : public handler {
+public:
+  void on_initialize() override {}
+  void on_message(std::any&&) override {}
+  void on_finalize() override {}
+  void on_error(std::exception&) override {}
+};
+
+strand_handler empty_handler;
+
+// Messages a drain runs before handing its worker back to the pool
+constexpr std::uint32_t drain_budget = 64;
+
+} // <anonymous>
+
+strand::strand() : size_{ 0 } {
+}
+
+bool strand::push(std::unique_ptr<message>&& msg) {
+  auto const idle = size_.fetch_add(1, std::memory_order_acq_rel) == 0;
+  queue_.enqueue(std::move(msg));
+  return idle;
+}
+
+bool strand::drain(std::uint32_t budget) {
+  std::unique_ptr<message> msg;
+  for (std::uint32_t i = 0; i < budget; i++) {
+    // Counted by a producer that has yet to queue it
+    while (!queue_.try_dequeue(msg)) std::this_thread::yield();
+
+    msg->process(empty_handler);
+    msg = nullptr;
+
+    if (size_.fetch_sub(1, std::memory_order_acq_rel) == 1) return false;
+  }
+  return true;
+}
+
+keyed_executor_base::keyed_executor_base(thread_pool& pool, std::uint32_t shards) : pool_{ pool }, drains_{ 0 } {
+  strands_.reserve(std::max(shards, 1u));
+  for (std::uint32_t i = 0; i < std::max(shards, 1u); i++) {
+    strands_.emplace_back(std::make_unique<strand>());
+  }
+}
+
+keyed_executor_base::~keyed_executor_base() {
+  std::unique_lock<std::mutex> lock{ mutex_ };
+  idle_.wait(lock, [this] { return !drains_.load(std::memory_order_acquire); });
+}
+
+std::uint32_t keyed_executor_base::shards() const {
+  return static_cast<std::uint32_t>(strands_.size());
+}
+
+void keyed_executor_base::post(std::size_t hash, std::unique_ptr<message>&& msg) {
+  // Fibonacci hashing spreads the low-entropy hashes of integral keys
+  auto const mixed = static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ull;
+  auto& s = *strands_[(mixed >> 32) % strands_.size()];
+  if (s.push(std::move(msg))) schedule(s);
+}
+
+keyed_executor_base::drain_ticket::drain_ticket(keyed_executor_base* owner) : owner_{ owner } {
+  owner_->drains_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+keyed_executor_base::drain_ticket::drain_ticket(drain_ticket&& other) noexcept
+  : owner_{ std::exchange(other.owner_, nullptr) } {
+}
+
+keyed_executor_base::drain_ticket::~drain_ticket() {
+  if (owner_) owner_->release();
+}
+
+void keyed_executor_base::schedule(strand& s) {
+  pool_.post([this, &s, ticket = drain_ticket{ this }] { run(s); });
+}
+
+void keyed_executor_base::run(strand& s) {
+  // The next drain takes its ticket before this one gives its own back
+  if (s.drain(drain_budget)) {
+    schedule(s);
+  }
+}
+
+void keyed_executor_base::release() {
+  // Under the lock, so that the destructor cannot return in between
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  if (drains_.fetch_sub(1, std::memory_order_acq_rel) == 1) idle_.notify_all();
+}
+
+} // cyan::dispatch::detail
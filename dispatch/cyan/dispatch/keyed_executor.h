@@ -0,0 +1,121 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+#include <cyan/noncopyable.h>
+#include <cyan/lockfree/queue.h>
+#include <cyan/dispatch/message.h>
+#include <cyan/dispatch/thread_pool.h>
+
+namespace cyan::dispatch {
+
+namespace detail {
+
+// Runs its messages one at a time in posting order, on whichever worker
+// picks up its drain.
+class strand : public cyan::noncopyable {
+public:
+  strand();
+
+  // True when the strand was idle and the caller has to schedule a drain
+  bool push(std::unique_ptr<message>&& msg);
+  // Runs up to `budget` messages; true when more are left and the caller
+  // has to schedule another drain
+  bool drain(std::uint32_t budget);
+
+private:
+  // Counted before the message is queued, so that every queued message is
+  // accounted for and only one drain runs at a time
+  alignas(std::hardware_destructive_interference_size)
+  std::atomic<std::size_t> size_;
+  cyan::lockfree::queue<std::unique_ptr<message>> queue_;
+};
+
+class keyed_executor_base : public cyan::noncopyable {
+public:
+  keyed_executor_base(thread_pool& pool, std::uint32_t shards);
+  ~keyed_executor_base();
+
+  std::uint32_t shards() const;
+
+protected:
+  void post(std::size_t hash, std::unique_ptr<message>&& msg);
+
+private:
+  // Held by a posted drain and given back when the drain is destroyed, so
+  // that a drain the pool drops unrun, e.g. on stop, is accounted for too
+  class drain_ticket {
+  public:
+    explicit drain_ticket(keyed_executor_base* owner);
+    drain_ticket(drain_ticket&& other) noexcept;
+    ~drain_ticket();
+
+  private:
+    keyed_executor_base* owner_;
+  };
+
+  void schedule(strand& s);
+  void run(strand& s);
+  void release();
+
+  thread_pool& pool_;
+  std::vector<std::unique_ptr<strand>> strands_;
+  std::atomic<std::uint32_t> drains_;
+  std::mutex mutex_;
+  std::condition_variable idle_;
+};
+
+} // detail
+
+// Keeps the tasks of each key in FIFO order on a thread_pool. Keys are
+// hashed onto a fixed set of shards, each a strand, so keys need no state of
+// their own and posting copies no token. Keys sharing a shard are ordered
+// with one another too; more shards means less false sharing of order.
+// Destruction waits for the queued tasks to run.
+template<typename Key, typename Hash = std::hash<Key>>
+class keyed_executor : public detail::keyed_executor_base {
+public:
+  constexpr static std::uint32_t shards_per_worker = 16;
+
+  explicit keyed_executor(thread_pool& pool, std::uint32_t shards = 0, Hash const& hash = Hash{})
+        : detail::keyed_executor_base{ pool, shards ? shards : pool.size() * shards_per_worker }, hash_{ hash } {}
+
+  template<typename Callable>
+  void post(Key const& key, Callable&& callback) {
+    detail::keyed_executor_base::post(hash_(key), detail::make_callable_message(std::forward<Callable>(callback)));
+  }
+
+private:
+  Hash hash_;
+};
+
+} // cyan::dispatch
@@ -0,0 +1,150 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cerrno>
+#include <algorithm>
+
+#include <cyan/dispatch/log_writer.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif // HAVE_UNISTD_H
+
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif // HAVE_SYS_UIO_H
+
+namespace cyan::dispatch {
+
+namespace {
+
+thread_options make_options(std::string const& name) {
+  thread_options options;
+  options.name = name;
+  return options;
+}
+
+// Iovecs handed to one writev, well under any platform's IOV_MAX
+constexpr std::size_t max_iovecs = 64;
+
+} // <anonymous>
+
+log_writer::log_writer(log_writer_options const& options)
+      : options_{ options }, thread_{ make_options(options.name) }, behind_{ false }, written_{ 0 } {
+  thread_.post_awaitable([this] {
+    timer_ = std::make_unique<cyan::event::timer>(cyan::this_thread::get_event_loop());
+    timer_->set_timeout(options_.flush_interval);
+    timer_->set_callback<&log_writer::drain>(this);
+    timer_->start();
+  }).get();
+}
+
+log_writer::~log_writer() {
+  thread_.post_awaitable([this, until = cyan::log::mark()] {
+    drain_until(until);
+    timer_ = nullptr;
+  }).get();
+  thread_.stop(true);
+  thread_.join();
+}
+
+void log_writer::flush() {
+  thread_.post_awaitable([this, until = cyan::log::mark()] { drain_until(until); }).get();
+}
+
+std::uint64_t log_writer::written() const noexcept {
+  return written_.load(std::memory_order_relaxed);
+}
+
+void log_writer::drain() {
+  // The round already queued takes care of it
+  if (behind_) return;
+
+  // A backlog larger than one batch per thread is written in several rounds,
+  // each queued behind whatever was posted meanwhile, e.g. a flush()
+  auto const count = cyan::log::consume(batches_, options_.max_per_thread);
+  write_batches();
+  written_.fetch_add(count, std::memory_order_relaxed);
+  if (count < options_.max_per_thread) return;
+
+  behind_ = true;
+  thread_.post([this] {
+    behind_ = false;
+    drain();
+  });
+}
+
+void log_writer::drain_until(cyan::log::snapshot const& until) {
+  // Ends even if threads keep logging
+  for (;;) {
+    auto const count = cyan::log::consume(batches_, until, options_.max_per_thread);
+    if (!count) break;
+    write_batches();
+    written_.fetch_add(count, std::memory_order_relaxed);
+  }
+}
+
+void log_writer::write_batches() {
+#ifdef HAVE_SYS_UIO_H
+  std::size_t first = 0;
+  std::size_t offset = 0;
+
+  while (first < batches_.size()) {
+    ::iovec iov[max_iovecs];
+    std::size_t n = 0;
+    for (auto i = first; i < batches_.size() && n < max_iovecs; i++, n++) {
+      auto const skip = i == first ? offset : 0;
+      iov[n].iov_base = batches_[i].data() + skip;
+      iov[n].iov_len = batches_[i].size() - skip;
+    }
+
+    auto written = ::writev(options_.fd, iov, static_cast<int>(n));
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    // Skip what went out, possibly ending within a batch
+    auto remaining = static_cast<std::size_t>(written);
+    while (first < batches_.size() && remaining >= batches_[first].size() - offset) {
+      remaining -= batches_[first].size() - offset;
+      offset = 0;
+      first++;
+    }
+    offset += remaining;
+  }
+#else
+  for (auto& batch : batches_) {
+    for (std::size_t offset = 0; offset < batch.size();) {
+      auto const written = ::write(options_.fd, batch.data() + offset, batch.size() - offset);
+      if (written < 0 && errno == EINTR) continue;
+      if (written <= 0) break;
+      offset += static_cast<std::size_t>(written);
+    }
+  }
+#endif // HAVE_SYS_UIO_H
+
+  batches_.clear();
+}
+
+} // cyan::dispatch
@@ -0,0 +1,81 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cyan/log.h>
+#include <cyan/event.h>
+#include <cyan/noncopyable.h>
+#include <cyan/dispatch/handler_thread.h>
+
+namespace cyan::dispatch {
+
+// Options of a log_writer.
+//  - fd: descriptor written to; it is not closed.
+//  - flush_interval: how often the rings are drained.
+//  - max_per_thread: records taken from one thread per batch, so that a
+//    chatty thread cannot hold up the others.
+//  - name: name of the writer thread.
+struct log_writer_options {
+  int fd = 2;
+  std::chrono::milliseconds flush_interval{ 10 };
+  std::size_t max_per_thread = 1024;
+  std::string name = "cyan-log";
+};
+
+// Drains cyan::log on a dedicated handler thread: every flush_interval the
+// records of all threads are formatted and written with a single writev.
+// Only one log_writer may exist at a time.
+class log_writer : public cyan::noncopyable {
+public:
+  explicit log_writer(log_writer_options const& options = {});
+  // Writes whatever is left before returning
+  ~log_writer();
+
+  // Drains and writes everything logged so far, then returns
+  void flush();
+
+  // Records written so far
+  std::uint64_t written() const noexcept;
+
+private:
+  void drain();
+  void drain_until(cyan::log::snapshot const& until);
+  void write_batches();
+
+  log_writer_options const options_;
+  handler_thread thread_;
+  std::unique_ptr<cyan::event::timer> timer_;
+  std::vector<std::string> batches_;
+  // A drain is queued on thread_
+  bool behind_;
+  std::atomic<std::uint64_t> written_;
+};
+
+} // cyan::dispatch
@@ -21,12 +21,26 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  **/
+#include <algorithm>
+
 #include <cyan/event.h>
 #include <cyan/dispatch/message.h>
 
 namespace cyan::dispatch::detail {
 
-message::message(message::type_t type) : type_{ type }, arrival_time_{ std::chrono::steady_clock::now() } {
+message::message(message::type_t type) : type_{ type }, timeout_{ 0 },
+      deadline_{ std::chrono::steady_clock::time_point::max() },
+      arrival_time_{ std::chrono::steady_clock::now() },
+      idle_time_{ 0 }, processing_time_{ 0 }, turnaround_time_{ 0 },
+      trace_id_{ type == message::type_t::stop ? 0 : cyan::trace::flow_start() } {
+}
+
+// A message dropped unprocessed, e.g. posted to a stopping thread or past
+// its deadline, still ends its flow, so that it does not dangle in traces
+message::~message() {
+  if (trace_id_) {
+    cyan::trace::scope scope{ "message::dropped", "dispatch", trace_id_ };
+  }
 }
 
 message::type_t message::get_type() const {
@@ -41,6 +55,18 @@ std::chrono::milliseconds message::get_timeout() const {
   return timeout_;
 }
 
+void message::set_deadline(std::chrono::steady_clock::time_point const& deadline) {
+  deadline_ = deadline;
+}
+
+std::chrono::steady_clock::time_point message::get_deadline() const {
+  return deadline_;
+}
+
+bool message::has_deadline() const {
+  return deadline_ != std::chrono::steady_clock::time_point::max();
+}
+
 void message::set_serial_token(cyan::dispatch::serial_token const& token) {
   serial_token_.emplace(token);
   sequence_ = token.get_next_sequence();
@@ -59,30 +85,38 @@ std::chrono::steady_clock::time_point message::arrival_time() const {
   return arrival_time_;
 }
 
-std::chrono::milliseconds message::idle_time() const {
+std::chrono::nanoseconds message::idle_time() const {
   return idle_time_;
 }
 
-std::chrono::milliseconds message::processing_time() const {
+std::chrono::nanoseconds message::processing_time() const {
   return processing_time_;
 }
 
-std::chrono::milliseconds message::turnaround_time() const {
+std::chrono::nanoseconds message::turnaround_time() const {
   return turnaround_time_;
 }
 
+std::uint64_t message::get_trace_id() const {
+  return trace_id_;
+}
+
 void message::mark_begin_processing() const {
+  // The flow ends at the processing scope
+  trace_id_ = 0;
   begin_processing_time_ = std::chrono::steady_clock::now();
-  idle_time_ = std::chrono::duration_cast<std::chrono::milliseconds>(begin_processing_time_ - arrival_time_) - timeout_;
+  auto const waited = std::chrono::duration_cast<std::chrono::nanoseconds>(begin_processing_time_ - arrival_time_);
+  idle_time_ = std::max(std::chrono::nanoseconds(0), waited - timeout_);
 }
 
 void message::mark_end_processing() const {
   auto now = std::chrono::steady_clock::now();
-  processing_time_ = std::chrono::duration_cast<std::chrono::milliseconds>(now - begin_processing_time_);
+  processing_time_ = std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin_processing_time_);
   turnaround_time_ = processing_time_ + idle_time_;
 }
 
 void payload_message::process(cyan::dispatch::handler& handler) {
+  cyan::trace::scope scope{ "payload_message::process", "dispatch", get_trace_id() };
   mark_begin_processing();
   try {
     handler.on_message(std::move(payload_));
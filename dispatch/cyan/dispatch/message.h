@@ -29,6 +29,7 @@
 #include <optional>
 #include <type_traits>
 
+#include <cyan/trace.h>
 #include <cyan/dispatch/handler.h>
 #include <cyan/dispatch/serial_token.h>
 
@@ -41,18 +42,22 @@ struct message {
     stop
   };
 
-  virtual ~message() = default;
+  virtual ~message();
 
   message::type_t get_type() const;
   void set_timeout(std::chrono::milliseconds const& timeout);
   std::chrono::milliseconds get_timeout() const;
+  void set_deadline(std::chrono::steady_clock::time_point const& deadline);
+  std::chrono::steady_clock::time_point get_deadline() const;
+  bool has_deadline() const;
   void set_serial_token(cyan::dispatch::serial_token const& token);
   bool try_acquire();
   void release();
   std::chrono::steady_clock::time_point arrival_time() const;
-  std::chrono::milliseconds idle_time() const;
-  std::chrono::milliseconds processing_time() const;
-  std::chrono::milliseconds turnaround_time() const;
+  std::chrono::nanoseconds idle_time() const;
+  std::chrono::nanoseconds processing_time() const;
+  std::chrono::nanoseconds turnaround_time() const;
+  std::uint64_t get_trace_id() const;
 
   virtual void process(cyan::dispatch::handler& handler) = 0;
 
@@ -65,13 +70,15 @@ protected:
 private:
   message::type_t type_;
   std::chrono::milliseconds timeout_;
+  std::chrono::steady_clock::time_point deadline_;
   std::optional<cyan::dispatch::serial_token> serial_token_;
   cyan::dispatch::serial_token::sequence_type sequence_;
   mutable std::chrono::steady_clock::time_point arrival_time_;
   mutable std::chrono::steady_clock::time_point begin_processing_time_;
-  mutable std::chrono::milliseconds idle_time_;
-  mutable std::chrono::milliseconds processing_time_;
-  mutable std::chrono::milliseconds turnaround_time_;
+  mutable std::chrono::nanoseconds idle_time_;
+  mutable std::chrono::nanoseconds processing_time_;
+  mutable std::chrono::nanoseconds turnaround_time_;
+  mutable std::uint64_t trace_id_;
 };
 
 class payload_message : public message {
@@ -85,6 +92,28 @@ private:
   std::any payload_;
 };
 
+template<typename T, typename H>
+class typed_payload_message : public message {
+public:
+  template<typename U>
+  typed_payload_message(U&& payload) : message{ message::type_t::payload }, payload_{ std::forward<U>(payload) } {}
+
+  void process(cyan::dispatch::handler& handler) override {
+    cyan::trace::scope scope{ "typed_payload_message::process", "dispatch", get_trace_id() };
+    mark_begin_processing();
+    try {
+      // Only ever queued on a typed_handler_thread<H>, so the handler is an H
+      static_cast<receiver<T>&>(static_cast<H&>(handler)).on_message(std::move(payload_));
+    } catch (std::exception& e) {
+      handler.on_error(e);
+    }
+    mark_end_processing();
+  }
+
+private:
+  T payload_;
+};
+
 template<typename C>
 class callable_message : public message {
 public:
@@ -93,6 +122,7 @@ public:
   callable_message(C&& callable) : message{ message::type_t::callable }, callable_{ std::forward<C>(callable) } {}
 
   void process(cyan::dispatch::handler& handler) override {
+    cyan::trace::scope scope{ "callable_message::process", "dispatch", get_trace_id() };
     mark_begin_processing();
     try {
       callable_();
@@ -122,6 +152,16 @@ make_payload_message(T&& payload, std::chrono::milliseconds timeout = std::chron
   return msg;
 }
 
+template<typename H, typename T>
+std::unique_ptr<message>
+make_typed_payload_message(T&& payload, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+  std::unique_ptr<message> msg = std::unique_ptr<message>{
+    new typed_payload_message<std::decay_t<T>, H>{ std::forward<T>(payload) }
+  };
+  msg->set_timeout(timeout);
+  return msg;
+}
+
 template<typename C>
 std::unique_ptr<message>
 make_callable_message(C&& callable, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
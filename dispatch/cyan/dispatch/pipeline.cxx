@@ -0,0 +1,98 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/dispatch/pipeline.h>
+
+namespace cyan::dispatch::detail {
+
+stage_credits::stage_credits(std::size_t capacity) : capacity_{ std::max<std::size_t>(capacity, 1) },
+      available_{ capacity_ } {
+}
+
+std::size_t stage_credits::acquire(std::size_t count) {
+  // A batch larger than the whole capacity takes all of it
+  count = std::min(count, capacity_);
+
+  std::unique_lock<std::mutex> lock{ mutex_ };
+  if (available_ < count) {
+    auto const begin = std::chrono::steady_clock::now();
+    released_.wait(lock, [&] { return available_ >= count; });
+    wait_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+  } else {
+    wait_.record(0);
+  }
+
+  available_ -= count;
+  return count;
+}
+
+void stage_credits::release(std::size_t count) {
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    available_ += count;
+  }
+  released_.notify_all();
+}
+
+cyan::histogram stage_credits::get_wait_histogram() const {
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  return wait_;
+}
+
+pipeline_stage_base::pipeline_stage_base(std::string const& name, stage_options const& options)
+      : name_{ name }, options_{ options }, credits_{ options.capacity }, next_worker_{ 0 }, items_{ 0 } {
+  auto const workers = std::max(options_.workers, 1u);
+  for (std::uint32_t i = 0; i < workers; i++) {
+    thread_options thread_options;
+    thread_options.name = name_ + "-" + std::to_string(i);
+    workers_.emplace_back(std::make_unique<handler_thread>(thread_options));
+  }
+}
+
+pipeline_stage_base::~pipeline_stage_base() {
+  drain();
+}
+
+void pipeline_stage_base::drain() {
+  for (auto& worker : workers_) worker->stop(true);
+  for (auto& worker : workers_) worker->join();
+}
+
+stage_statistics pipeline_stage_base::get_statistics() const {
+  stage_statistics stats;
+  stats.name = name_;
+  for (auto& worker : workers_) stats.latency.merge(worker->get_latency_statistics());
+  stats.backpressure = credits_.get_wait_histogram();
+  stats.items = items_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+handler_thread& pipeline_stage_base::next_worker() {
+  return *workers_[next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+}
+
+void pipeline_stage_base::on_processed(std::size_t count) {
+  items_.fetch_add(count, std::memory_order_relaxed);
+}
+
+} // cyan::dispatch::detail
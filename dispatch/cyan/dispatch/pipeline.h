@@ -0,0 +1,330 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include <cyan/histogram.h>
+#include <cyan/noncopyable.h>
+#include <cyan/dispatch/statistics.h>
+#include <cyan/dispatch/handler_thread.h>
+
+namespace cyan::dispatch {
+
+// Options of one pipeline stage.
+//  - workers: handler threads running the stage in parallel.
+//  - capacity: items admitted into the stage and not yet handed on. An
+//    upstream stage (or push()) blocks while it is exhausted, which is how
+//    backpressure travels up the pipeline.
+//  - batch_size: most items handed to the next stage in one message.
+//    Outputs are held back until that many are ready, or until the stage
+//    has no input left to process.
+//  - ordered: hand outputs on in input order, even with several workers.
+struct stage_options {
+  std::uint32_t workers = 1;
+  std::size_t capacity = 1024;
+  std::size_t batch_size = 64;
+  bool ordered = false;
+};
+
+// Per-stage statistics.
+//  - latency: per batch, queue_wait being the time between hand-off and the
+//    start of processing.
+//  - backpressure: time producers spent waiting for the stage's capacity.
+//  - items: items processed.
+struct stage_statistics {
+  std::string name;
+  latency_statistics latency;
+  cyan::histogram backpressure;
+  std::uint64_t items = 0;
+};
+
+namespace detail {
+
+// Counting semaphore over a stage's capacity.
+class stage_credits : public cyan::noncopyable {
+public:
+  explicit stage_credits(std::size_t capacity);
+
+  std::size_t acquire(std::size_t count);
+  void release(std::size_t count);
+  cyan::histogram get_wait_histogram() const;
+
+private:
+  std::size_t const capacity_;
+  std::size_t available_;
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  cyan::histogram wait_;
+};
+
+class pipeline_stage_base : public cyan::noncopyable {
+public:
+  pipeline_stage_base(std::string const& name, stage_options const& options);
+  virtual ~pipeline_stage_base();
+
+  // Processes everything queued so far, then stops the workers
+  void drain();
+  stage_statistics get_statistics() const;
+
+protected:
+  handler_thread& next_worker();
+  void on_processed(std::size_t count);
+
+  std::string const name_;
+  stage_options const options_;
+  stage_credits credits_;
+
+private:
+  std::vector<std::unique_ptr<handler_thread>> workers_;
+  std::atomic<std::uint32_t> next_worker_;
+  std::atomic<std::uint64_t> items_;
+};
+
+// Output type of a stage whose function returns void
+struct no_output {};
+
+template<typename In>
+class stage_input {
+public:
+  virtual ~stage_input() = default;
+  virtual void dispatch(std::vector<In>&& batch) = 0;
+};
+
+template<typename In, typename Out, typename F>
+class pipeline_stage : public pipeline_stage_base, public stage_input<In> {
+public:
+  pipeline_stage(std::string const& name, F&& fn, stage_options const& options)
+        : pipeline_stage_base{ name, options }, fn_{ std::forward<F>(fn) }, next_{ nullptr },
+        next_sequence_{ 0 }, next_output_{ 0 }, handing_off_{ false }, in_flight_{ 0 } {}
+
+  void connect(stage_input<Out>* next) {
+    next_ = next;
+  }
+
+  // Callers hand batches in order; the sequence number is taken here so
+  // that ordered stages can restore that order after running in parallel.
+  void dispatch(std::vector<In>&& batch) override {
+    auto const credits = credits_.acquire(batch.size());
+    auto const sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+
+    next_worker().post([this, batch = std::move(batch), credits, sequence] () mutable {
+      process(std::move(batch), sequence);
+      credits_.release(credits);
+    });
+  }
+
+private:
+  void process(std::vector<In>&& batch, std::uint64_t sequence) {
+    auto const count = batch.size();
+
+    if constexpr (std::is_same_v<Out, no_output>) {
+      for (auto& item : batch) fn_(std::move(item));
+      (void) sequence;
+    } else {
+      std::vector<Out> outputs;
+      outputs.reserve(count);
+      for (auto& item : batch) outputs.push_back(fn_(std::move(item)));
+
+      if (options_.ordered) {
+        hand_off_in_order(std::move(outputs), sequence);
+      } else {
+        hand_off(std::move(outputs));
+      }
+
+      // The last batch in flight flushes what the others left buffered
+      if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock{ output_mutex_ };
+        flush();
+      }
+    }
+
+    on_processed(count);
+  }
+
+  // Hand-off may block on the next stage's capacity, so it runs outside the
+  // lock. One worker at a time owns it and keeps going while batches are in
+  // sequence; the others just leave theirs in reorder_.
+  void hand_off_in_order(std::vector<Out>&& outputs, std::uint64_t sequence) {
+    std::unique_lock<std::mutex> lock{ reorder_mutex_ };
+    reorder_.emplace(sequence, std::move(outputs));
+    if (handing_off_) return;
+    handing_off_ = true;
+
+    std::vector<std::vector<Out>> ready;
+    for (;;) {
+      for (auto it = reorder_.begin(); it != reorder_.end() && it->first == next_output_;
+            it = reorder_.erase(it), next_output_++) {
+        ready.push_back(std::move(it->second));
+      }
+      if (ready.empty()) break;
+
+      lock.unlock();
+      for (auto& batch : ready) hand_off(std::move(batch));
+      ready.clear();
+      lock.lock();
+    }
+    handing_off_ = false;
+  }
+
+  // Coalesces outputs into batches of batch_size. The lock is held across
+  // dispatch so that batches reach the next stage in the order they filled.
+  void hand_off(std::vector<Out>&& outputs) {
+    if (!next_ || outputs.empty()) return;
+
+    auto const batch_size = std::max<std::size_t>(options_.batch_size, 1);
+    std::lock_guard<std::mutex> lock{ output_mutex_ };
+    for (auto& output : outputs) {
+      output_.push_back(std::move(output));
+      if (output_.size() >= batch_size) flush();
+    }
+  }
+
+  void flush() {
+    if (!next_ || output_.empty()) return;
+    next_->dispatch(std::exchange(output_, {}));
+  }
+
+  std::decay_t<F> fn_;
+  stage_input<Out>* next_;
+  std::atomic<std::uint64_t> next_sequence_;
+  std::mutex reorder_mutex_;
+  std::map<std::uint64_t, std::vector<Out>> reorder_;
+  std::uint64_t next_output_;
+  bool handing_off_;
+  std::atomic<std::size_t> in_flight_;
+  std::mutex output_mutex_;
+  std::vector<Out> output_;
+};
+
+template<typename In, typename F>
+using stage_output_t = std::invoke_result_t<F, std::add_rvalue_reference_t<In>>;
+
+template<typename T>
+using stage_value_t = std::conditional_t<std::is_void_v<T>, no_output, T>;
+
+} // detail
+
+// Stages run in order; each is a set of handler threads and hands its
+// outputs, in batches, to the next. Destroying the pipeline drains every
+// stage in order.
+template<typename In>
+class pipeline : public cyan::noncopyable {
+public:
+  pipeline(std::vector<std::unique_ptr<detail::pipeline_stage_base>>&& stages, detail::stage_input<In>* head)
+        : stages_{ std::move(stages) }, head_{ head } {}
+
+  ~pipeline() {
+    for (auto& stage : stages_) stage->drain();
+  }
+
+  // Blocks while the first stage is at capacity
+  void push(In item) {
+    std::vector<In> batch;
+    batch.push_back(std::move(item));
+    head_->dispatch(std::move(batch));
+  }
+
+  void push(std::vector<In>&& batch) {
+    if (!batch.empty()) head_->dispatch(std::move(batch));
+  }
+
+  std::vector<stage_statistics> get_statistics() const {
+    std::vector<stage_statistics> stats;
+    for (auto& stage : stages_) stats.push_back(stage->get_statistics());
+    return stats;
+  }
+
+private:
+  std::vector<std::unique_ptr<detail::pipeline_stage_base>> stages_;
+  detail::stage_input<In>* head_;
+};
+
+// Builds a pipeline<In> stage by stage, e.g.
+//
+//   auto p = make_pipeline<std::string>()
+//     .stage("parse", parse)
+//     .stage("enrich", enrich, { .workers = 4, .ordered = true })
+//     .stage("persist", persist)
+//     .build();
+template<typename In, typename Out>
+class pipeline_builder {
+public:
+  pipeline_builder() : head_{ nullptr } {}
+
+  template<typename F>
+  auto stage(std::string const& name, F&& fn, stage_options const& options = {}) &&
+        -> pipeline_builder<In, detail::stage_output_t<Out, F>> {
+    static_assert(!std::is_void_v<Out>, "pipeline_builder: no stage can follow one returning void");
+
+    using next_out = detail::stage_output_t<Out, F>;
+    using stage_type = detail::pipeline_stage<Out, detail::stage_value_t<next_out>, F>;
+
+    auto stage = std::make_unique<stage_type>(name, std::forward<F>(fn), options);
+    auto raw = stage.get();
+    if (connect_) connect_(raw);
+
+    pipeline_builder<In, next_out> next;
+    next.stages_ = std::move(stages_);
+    next.stages_.push_back(std::move(stage));
+    next.head_ = head_;
+    if constexpr (std::is_same_v<In, Out>) {
+      if (!next.head_) next.head_ = raw;
+    }
+    if constexpr (!std::is_void_v<next_out>) {
+      next.connect_ = [raw](detail::stage_input<next_out>* n) { raw->connect(n); };
+    }
+    return next;
+  }
+
+  pipeline<In> build() && {
+    static_assert(std::is_void_v<Out>, "pipeline_builder: the last stage must return void");
+    return pipeline<In>{ std::move(stages_), head_ };
+  }
+
+private:
+  template<typename, typename>
+  friend class pipeline_builder;
+
+  std::vector<std::unique_ptr<detail::pipeline_stage_base>> stages_;
+  detail::stage_input<In>* head_;
+  std::function<void(detail::stage_input<Out>*)> connect_;
+};
+
+template<typename In>
+pipeline_builder<In, In> make_pipeline() {
+  return {};
+}
+
+} // cyan::dispatch
@@ -0,0 +1,133 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <algorithm>
+
+#include <cyan/dispatch/rate_limiter.h>
+
+namespace cyan::dispatch::detail {
+
+namespace {
+
+std::int64_t to_ns(std::chrono::steady_clock::time_point t) noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+} // <anonymous>
+
+token_bucket::token_bucket(rate_limit const& limit)
+      : interval_{ static_cast<std::int64_t>(1e9 / std::max(limit.rate, 1e-9)) },
+      tolerance_{ interval_ * (std::max<std::int64_t>(limit.burst, 1) - 1) },
+      tat_{ 0 } {
+}
+
+bool token_bucket::try_acquire(std::chrono::steady_clock::time_point now) noexcept {
+  auto const t = to_ns(now);
+  auto tat = tat_.load(std::memory_order_relaxed);
+
+  for (;;) {
+    auto const from = std::max(tat, t);
+    if (from - t > tolerance_) return false;
+    if (tat_.compare_exchange_weak(tat, from + interval_, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+std::size_t token_bucket::try_acquire(std::chrono::steady_clock::time_point now, std::size_t max) noexcept {
+  auto const t = to_ns(now);
+  auto tat = tat_.load(std::memory_order_relaxed);
+
+  for (;;) {
+    auto const credit = t + tolerance_ - tat;
+    if (credit < 0 || !max) return 0;
+    auto const count = std::min<std::int64_t>(credit / interval_ + 1, static_cast<std::int64_t>(max));
+    if (tat_.compare_exchange_weak(tat, tat + count * interval_, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return static_cast<std::size_t>(count);
+    }
+  }
+}
+
+std::chrono::nanoseconds token_bucket::time_to_next(std::chrono::steady_clock::time_point now) const noexcept {
+  auto const wait = tat_.load(std::memory_order_acquire) - to_ns(now) - tolerance_;
+  return std::chrono::nanoseconds(std::max<std::int64_t>(wait, 0));
+}
+
+rate_limiter_state::rate_limiter_state(rate_limit const& limit)
+      : bucket_{ limit }, pending_{ 0 }, deferred_{ 0 }, scheduled_{ false } {
+}
+
+bool rate_limiter_state::try_admit() {
+  return !pending_.load(std::memory_order_acquire) && bucket_.try_acquire(std::chrono::steady_clock::now());
+}
+
+std::chrono::nanoseconds rate_limiter_state::defer(std::unique_ptr<pending_task>&& task) {
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  backlog_.push_back(std::move(task));
+  pending_.fetch_add(1, std::memory_order_release);
+  deferred_.fetch_add(1, std::memory_order_relaxed);
+
+  if (scheduled_) return std::chrono::nanoseconds(0);
+  scheduled_ = true;
+  // Never zero, which would read as "already scheduled"
+  return std::max(bucket_.time_to_next(std::chrono::steady_clock::now()), std::chrono::nanoseconds(1));
+}
+
+std::chrono::nanoseconds rate_limiter_state::release() {
+  std::deque<std::unique_ptr<pending_task>> ready;
+  std::chrono::nanoseconds next{ 0 };
+
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    // The timer fires late by up to its millisecond granularity; spend
+    // everything accrued meanwhile, or the rate would cap at burst per tick
+    auto const now = std::chrono::steady_clock::now();
+    for (auto count = bucket_.try_acquire(now, backlog_.size()); count; count--) {
+      ready.push_back(std::move(backlog_.front()));
+      backlog_.pop_front();
+    }
+
+    if (backlog_.empty()) {
+      scheduled_ = false;
+    } else {
+      next = std::max(bucket_.time_to_next(now), std::chrono::nanoseconds(1));
+    }
+  }
+
+  // Posted outside the lock, in backlog order
+  for (auto& task : ready) {
+    task->post();
+    pending_.fetch_sub(1, std::memory_order_release);
+  }
+  return next;
+}
+
+std::size_t rate_limiter_state::pending() const {
+  return pending_.load(std::memory_order_acquire);
+}
+
+std::uint64_t rate_limiter_state::deferred() const {
+  return deferred_.load(std::memory_order_relaxed);
+}
+
+} // cyan::dispatch::detail
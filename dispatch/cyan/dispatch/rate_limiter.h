@@ -0,0 +1,214 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <cyan/noncopyable.h>
+
+namespace cyan::dispatch {
+
+// Sustained `rate` in tasks per second, of which up to `burst` may run back
+// to back.
+struct rate_limit {
+  double rate = 1000.;
+  std::uint32_t burst = 1;
+};
+
+namespace detail {
+
+// Token bucket kept as a single theoretical arrival time (GCRA), so that
+// admission is one compare-and-swap.
+class token_bucket {
+public:
+  explicit token_bucket(rate_limit const& limit);
+
+  bool try_acquire(std::chrono::steady_clock::time_point now) noexcept;
+  // Takes up to `max` tokens, every one accrued since the last acquisition
+  // and not only the burst; for draining a backlog that kept the bucket
+  // empty, so the credit is never stale. Returns how many were taken.
+  std::size_t try_acquire(std::chrono::steady_clock::time_point now, std::size_t max) noexcept;
+  // Time until try_acquire can succeed again
+  std::chrono::nanoseconds time_to_next(std::chrono::steady_clock::time_point now) const noexcept;
+
+private:
+  std::int64_t const interval_;
+  std::int64_t const tolerance_;
+  std::atomic<std::int64_t> tat_;
+};
+
+struct pending_task {
+  virtual ~pending_task() = default;
+  virtual void post() = 0;
+};
+
+template<typename Executor, typename Callable>
+class pending_task_impl : public pending_task {
+public:
+  pending_task_impl(Executor& executor, Callable&& callable)
+        : executor_{ executor }, callable_{ std::forward<Callable>(callable) } {}
+
+  void post() override {
+    executor_.post(std::move(callable_));
+  }
+
+private:
+  Executor& executor_;
+  std::decay_t<Callable> callable_;
+};
+
+// Bucket and backlog of one limiter. Tasks over the rate wait in the backlog
+// in order; a single release timer at a time drains it.
+class rate_limiter_state : public cyan::noncopyable {
+public:
+  explicit rate_limiter_state(rate_limit const& limit);
+
+  // Lock-free unless tasks are already waiting, which keeps them ahead
+  bool try_admit();
+  // Returns the delay of the release timer to schedule, zero when one is
+  // already scheduled
+  std::chrono::nanoseconds defer(std::unique_ptr<pending_task>&& task);
+  // Posts every waiting task a token is available for; returns the delay
+  // of the next release, zero once the backlog is empty
+  std::chrono::nanoseconds release();
+
+  std::size_t pending() const;
+  std::uint64_t deferred() const;
+
+private:
+  token_bucket bucket_;
+  std::atomic<std::size_t> pending_;
+  std::atomic<std::uint64_t> deferred_;
+  mutable std::mutex mutex_;
+  std::deque<std::unique_ptr<pending_task>> backlog_;
+  bool scheduled_;
+};
+
+} // detail
+
+// Executes tasks on `executor` (a handler_thread or thread_pool) no faster
+// than `limit`. Tasks over the rate are queued and released from the
+// executor's timer, never by sleeping on its threads. Tasks still queued
+// when the limiter is destroyed are dropped.
+template<typename Executor>
+class rate_limiter : public cyan::noncopyable {
+public:
+  rate_limiter(Executor& executor, rate_limit const& limit)
+        : executor_{ executor }, state_{ std::make_shared<detail::rate_limiter_state>(limit) } {}
+
+  template<typename Callable>
+  void post(Callable&& callback) {
+    if (state_->try_admit()) {
+      executor_.post(std::forward<Callable>(callback));
+      return;
+    }
+
+    auto delay = state_->defer(std::make_unique<detail::pending_task_impl<Executor, Callable>>(
+          executor_, std::forward<Callable>(callback)));
+    if (delay.count()) schedule(executor_, state_, delay);
+  }
+
+  // Tasks waiting for a token
+  std::size_t pending() const {
+    return state_->pending();
+  }
+
+  // Tasks that had to wait for a token so far
+  std::uint64_t deferred() const {
+    return state_->deferred();
+  }
+
+private:
+  static void schedule(Executor& executor, std::weak_ptr<detail::rate_limiter_state> const& state,
+        std::chrono::nanoseconds delay) {
+    // Delayed posts have millisecond granularity; a late release catches up
+    // on the tokens it missed
+    auto const timeout = std::max(std::chrono::ceil<std::chrono::milliseconds>(delay), std::chrono::milliseconds(1));
+
+    executor.post([&executor, state] {
+      auto locked = state.lock();
+      if (!locked) return;
+
+      auto const next = locked->release();
+      if (next.count()) schedule(executor, state, next);
+    }, timeout);
+  }
+
+  Executor& executor_;
+  std::shared_ptr<detail::rate_limiter_state> state_;
+};
+
+// A rate_limiter per key, created on first use. Admission takes a shared
+// lock to find the key's bucket and is lock-free from there.
+template<typename Key, typename Executor, typename Hash = std::hash<Key>>
+class keyed_rate_limiter : public cyan::noncopyable {
+public:
+  keyed_rate_limiter(Executor& executor, rate_limit const& limit) : executor_{ executor }, limit_{ limit } {}
+
+  template<typename Callable>
+  void post(Key const& key, Callable&& callback) {
+    get(key)->post(std::forward<Callable>(callback));
+  }
+
+  std::size_t pending(Key const& key) const {
+    std::shared_lock<std::shared_mutex> lock{ mutex_ };
+    auto it = limiters_.find(key);
+    return it != limiters_.end() ? it->second->pending() : 0;
+  }
+
+  // Forgets the key's bucket; its waiting tasks are dropped
+  void erase(Key const& key) {
+    std::unique_lock<std::shared_mutex> lock{ mutex_ };
+    limiters_.erase(key);
+  }
+
+private:
+  std::shared_ptr<rate_limiter<Executor>> get(Key const& key) {
+    {
+      std::shared_lock<std::shared_mutex> lock{ mutex_ };
+      auto it = limiters_.find(key);
+      if (it != limiters_.end()) return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock{ mutex_ };
+    auto& limiter = limiters_[key];
+    if (!limiter) limiter = std::make_shared<rate_limiter<Executor>>(executor_, limit_);
+    return limiter;
+  }
+
+  Executor& executor_;
+  rate_limit const limit_;
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<Key, std::shared_ptr<rate_limiter<Executor>>, Hash> limiters_;
+};
+
+} // cyan::dispatch
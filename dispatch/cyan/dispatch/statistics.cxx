@@ -0,0 +1,73 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/dispatch/message.h>
+#include <cyan/dispatch/statistics.h>
+
+namespace cyan::dispatch::detail {
+
+void latency_recorder::record(message const& msg) noexcept {
+  queue_wait_.record(msg.idle_time().count());
+  run_time_.record(msg.processing_time().count());
+  end_to_end_.record(msg.turnaround_time().count());
+}
+
+latency_statistics latency_recorder::snapshot() const noexcept {
+  latency_statistics stats;
+  stats.queue_wait = queue_wait_.snapshot();
+  stats.run_time = run_time_.snapshot();
+  stats.end_to_end = end_to_end_.snapshot();
+  return stats;
+}
+
+statistics_recorder::statistics_recorder() noexcept : enqueued_{ 0 }, stolen_{ 0 }, dequeued_{ 0 },
+      executed_{ 0 }, reenqueued_{ 0 }, loop_iterations_{ 0 }, yields_{ 0 }, dropped_{ 0 },
+      busy_ns_{ 0 }, start_time_{ 0 } {
+}
+
+void statistics_recorder::on_start() noexcept {
+  start_time_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+thread_statistics statistics_recorder::snapshot() const noexcept {
+  thread_statistics stats;
+  stats.dequeued = dequeued_.load(std::memory_order_relaxed);
+  stats.stolen = stolen_.load(std::memory_order_relaxed);
+  stats.executed = executed_.load(std::memory_order_relaxed);
+  stats.reenqueued = reenqueued_.load(std::memory_order_relaxed);
+  stats.loop_iterations = loop_iterations_.load(std::memory_order_relaxed);
+  stats.yields = yields_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.busy_time = std::chrono::nanoseconds(busy_ns_.load(std::memory_order_relaxed));
+  // Read last so that the derived queue depth never goes negative
+  stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+
+  auto const start = start_time_.load(std::memory_order_relaxed);
+  if (start) {
+    auto const now = std::chrono::steady_clock::now().time_since_epoch().count();
+    stats.uptime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::duration(now - start));
+  }
+  return stats;
+}
+
+} // cyan::dispatch::detail
@@ -0,0 +1,183 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+
+#include <cyan/utility.h>
+#include <cyan/histogram.h>
+
+namespace cyan::dispatch {
+
+namespace detail {
+
+struct message;
+
+}
+
+// Per-message latencies in nanoseconds.
+//  - queue_wait: from enqueue (or expiry of the delay, for delayed
+//    messages) until processing begins.
+//  - run_time: time spent processing the message.
+//  - end_to_end: queue_wait + run_time.
+struct latency_statistics {
+  cyan::histogram queue_wait;
+  cyan::histogram run_time;
+  cyan::histogram end_to_end;
+
+  latency_statistics& merge(latency_statistics const& other) noexcept {
+    queue_wait.merge(other.queue_wait);
+    run_time.merge(other.run_time);
+    end_to_end.merge(other.end_to_end);
+    return *this;
+  }
+};
+
+// Throughput and utilization counters of a handler thread.
+//  - enqueued: messages accepted from producers.
+//  - dequeued: messages taken off the queue by the thread.
+//  - executed: messages processed, including delayed ones.
+//  - reenqueued: messages put back because their serial token was busy.
+//  - stolen: messages taken off this thread's queue by idle pool siblings.
+//  - loop_iterations: passes over the queue, i.e. wake-ups of the thread.
+//  - yields: passes cut short by the batch budget.
+//  - dropped: messages whose deadline passed before they started.
+//  - busy_time: time spent processing messages.
+//  - uptime: time since the thread started its loop.
+struct thread_statistics {
+  std::uint64_t enqueued = 0;
+  std::uint64_t dequeued = 0;
+  std::uint64_t executed = 0;
+  std::uint64_t reenqueued = 0;
+  std::uint64_t stolen = 0;
+  std::uint64_t loop_iterations = 0;
+  std::uint64_t yields = 0;
+  std::uint64_t dropped = 0;
+  std::chrono::nanoseconds busy_time{ 0 };
+  std::chrono::nanoseconds uptime{ 0 };
+
+  std::uint64_t queue_depth() const noexcept {
+    auto const in = enqueued + reenqueued;
+    auto const out = dequeued + stolen;
+    return in > out ? in - out : 0;
+  }
+
+  double utilization() const noexcept {
+    return uptime.count() ? double(busy_time.count()) / double(uptime.count()) : 0.;
+  }
+
+  thread_statistics& merge(thread_statistics const& other) noexcept {
+    enqueued += other.enqueued;
+    dequeued += other.dequeued;
+    executed += other.executed;
+    reenqueued += other.reenqueued;
+    stolen += other.stolen;
+    loop_iterations += other.loop_iterations;
+    yields += other.yields;
+    dropped += other.dropped;
+    busy_time += other.busy_time;
+    uptime += other.uptime;
+    return *this;
+  }
+};
+
+namespace detail {
+
+// Producers only touch `enqueued_` and stealing siblings `stolen_`, each on
+// its own cache line; the rest is written by the handler thread alone with
+// plain load/store pairs.
+class statistics_recorder {
+public:
+  statistics_recorder() noexcept;
+
+  void on_start() noexcept;
+  void on_enqueue() noexcept {
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void on_stolen() noexcept {
+    stolen_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void on_dequeue() noexcept {
+    increment(dequeued_);
+  }
+  void on_reenqueue() noexcept {
+    increment(reenqueued_);
+  }
+  void on_loop_iteration() noexcept {
+    increment(loop_iterations_);
+  }
+  void on_yield() noexcept {
+    increment(yields_);
+  }
+  void on_dropped() noexcept {
+    increment(dropped_);
+  }
+  void on_execute(std::chrono::nanoseconds busy) noexcept {
+    increment(executed_);
+    increment(busy_ns_, static_cast<std::uint64_t>(busy.count()));
+  }
+
+  thread_statistics snapshot() const noexcept;
+
+private:
+  static void increment(std::atomic<std::uint64_t>& counter, std::uint64_t by = 1) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+  }
+
+  alignas(std::hardware_destructive_interference_size)
+  std::atomic<std::uint64_t> enqueued_;
+
+  alignas(std::hardware_destructive_interference_size)
+  std::atomic<std::uint64_t> stolen_;
+
+  alignas(std::hardware_destructive_interference_size)
+  std::atomic<std::uint64_t> dequeued_;
+  std::atomic<std::uint64_t> executed_;
+  std::atomic<std::uint64_t> reenqueued_;
+  std::atomic<std::uint64_t> loop_iterations_;
+  std::atomic<std::uint64_t> yields_;
+  std::atomic<std::uint64_t> dropped_;
+  std::atomic<std::uint64_t> busy_ns_;
+  std::atomic<std::chrono::steady_clock::rep> start_time_;
+};
+
+// Owned and recorded into by the handler thread; snapshots may be taken
+// from any thread.
+class latency_recorder {
+public:
+  void record(message const& msg) noexcept;
+  latency_statistics snapshot() const noexcept;
+
+private:
+  cyan::concurrent_histogram queue_wait_;
+  cyan::concurrent_histogram run_time_;
+  cyan::concurrent_histogram end_to_end_;
+};
+
+} // detail
+
+} // cyan::dispatch
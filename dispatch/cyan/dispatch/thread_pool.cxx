@@ -24,6 +24,8 @@
 #include <mutex>
 #include <algorithm>
 
+#include <cyan/dispatch/topology.h>
+#include <cyan/dispatch/work_group.h>
 #include <cyan/dispatch/thread_pool.h>
 
 namespace cyan::dispatch {
@@ -39,7 +41,49 @@ std::shared_ptr<thread_pool> global_concurrent_pool() {
   return concurrent_pool;
 }
 
-thread_pool::thread_pool(std::uint32_t size) : size_{ std::max(size, 1u) } {
+namespace {
+
+std::vector<std::vector<std::uint32_t>> get_placements(thread_pool_options const& options) {
+  std::vector<std::vector<std::uint32_t>> placements;
+
+  switch (options.affinity) {
+  case affinity::none:
+    break;
+  case affinity::cpus:
+    for (auto cpu : options.cpus) placements.push_back({ cpu });
+    break;
+  case affinity::physical_core:
+    for (auto cpu : topology::physical_cores()) placements.push_back({ cpu });
+    break;
+  case affinity::numa_node:
+    placements = topology::numa_nodes();
+    break;
+  }
+
+  return placements;
+}
+
+std::uint32_t get_size(thread_pool_options const& options,
+      std::vector<std::vector<std::uint32_t>> const& placements) {
+  if (options.size) return options.size;
+  if (!placements.empty()) return static_cast<std::uint32_t>(placements.size());
+  return std::thread::hardware_concurrency();
+}
+
+thread_pool_options make_options(std::uint32_t size) {
+  thread_pool_options options;
+  options.size = std::max(size, 1u);
+  return options;
+}
+
+} // <anonymous>
+
+thread_pool::thread_pool(std::uint32_t size) : thread_pool{ make_options(size) } {
+}
+
+thread_pool::thread_pool(thread_pool_options const& options) : options_{ options },
+      placements_{ get_placements(options_) },
+      size_{ std::max(get_size(options_, placements_), 1u) }, cur_idx_{ 0 } {
   start();
 }
 
@@ -49,24 +93,74 @@ thread_pool::~thread_pool() {
 
 void thread_pool::start() {
   if (threads_.size()) return;
+  group_ = std::make_shared<detail::work_group>(size_);
   for (std::uint32_t i = 0; i < size_; i++) {
-    threads_.emplace_back(std::make_unique<cyan::dispatch::handler_thread>());
+    threads_.emplace_back(new cyan::dispatch::handler_thread{ get_thread_options(i), group_, i });
   }
+  timers_ = std::make_shared<detail::timer_service>(options_.name + "-timer");
 }
 
 void thread_pool::stop() {
+  // Stop firing timers before the workers they post to go away
+  if (timers_) timers_->shutdown();
   for (auto& thd : threads_) thd->stop(true);
+  // Siblings may still be stealing from each other until all have exited
+  for (auto& thd : threads_) thd->join();
   threads_.clear();
+  group_ = nullptr;
 }
 
 std::uint32_t thread_pool::size() const {
   return size_;
 }
 
+latency_statistics thread_pool::get_latency_statistics() const {
+  latency_statistics stats;
+  for (auto& thd : threads_) stats.merge(thd->get_latency_statistics());
+  return stats;
+}
+
+thread_statistics thread_pool::get_statistics() const {
+  thread_statistics stats;
+  for (auto& thd : threads_) stats.merge(thd->get_statistics());
+  return stats;
+}
+
+thread_statistics thread_pool::get_statistics(std::uint32_t thread_idx) const {
+  return threads_.at(thread_idx)->get_statistics();
+}
+
+thread_options thread_pool::get_thread_options(std::uint32_t thread_idx) const {
+  thread_options options;
+  options.name = options_.name + "-" + std::to_string(thread_idx);
+  options.reserve = options_.reserve;
+  options.max_batch_size = options_.max_batch_size;
+  options.max_batch_time = options_.max_batch_time;
+  options.on_deadline_missed = options_.on_deadline_missed;
+  if (!placements_.empty()) options.cpus = placements_[thread_idx % placements_.size()];
+  return options;
+}
+
+// Fires on the service thread, so the service outlives the callback, and
+// stop() shuts it down before the workers go away
+void thread_pool::schedule(detail::timer_service& timers, std::shared_ptr<detail::periodic_task> const& task) {
+  timers.schedule(task->next, task->state, [this, &timers, task] {
+    post(task->token, [task] {
+      if (!task->state->cancelled.load(std::memory_order_acquire)) task->callback();
+    });
+
+    task->advance(std::chrono::steady_clock::now());
+    schedule(timers, task);
+  });
+}
+
 std::uint32_t thread_pool::get_next_thread_idx() const {
-  auto idx = cur_idx_.load(std::memory_order_relaxed);
-  while (cur_idx_.compare_exchange_weak(idx, (idx + 1) % size_));
-  return idx;
+  // Posts from a worker stay on it and run next; idle siblings steal any
+  // backlog that builds up behind it.
+  std::uint32_t idx;
+  if (group_ && group_->get_current(idx)) return idx;
+
+  return cur_idx_.fetch_add(1, std::memory_order_relaxed) % size_;
 }
 
 } // cyan::dispatch
@@ -25,17 +25,49 @@
 
 #include <thread>
 #include <memory>
+#include <tuple>
 #include <vector>
 #include <atomic>
+#include <string>
+#include <functional>
+#include <stdexcept>
 
 #include <cyan/dispatch/handler.h>
 #include <cyan/dispatch/handler_thread.h>
+#include <cyan/dispatch/timer_service.h>
 
 namespace cyan::dispatch {
 
+// How pool workers are pinned to CPUs.
+//  - none: no pinning.
+//  - cpus: worker i runs on cpus[i % cpus.size()].
+//  - physical_core: one worker per physical core, hyper-threads skipped.
+//  - numa_node: one worker per NUMA node, free to run on any of its CPUs.
+enum class affinity {
+  none,
+  cpus,
+  physical_core,
+  numa_node
+};
+
+// A size of 0 sizes the pool after the affinity: the number of CPUs, cores or
+// nodes, or the hardware concurrency when not pinned. Workers are named
+// "<name>-<index>". The rest applies to every worker, see thread_options.
+struct thread_pool_options {
+  std::uint32_t size = 0;
+  cyan::dispatch::affinity affinity = affinity::none;
+  std::vector<std::uint32_t> cpus;
+  std::string name = "cyan-pool";
+  std::size_t reserve = 0;
+  std::uint32_t max_batch_size = 0;
+  std::chrono::nanoseconds max_batch_time{ 0 };
+  std::function<void(std::chrono::nanoseconds)> on_deadline_missed;
+};
+
 class thread_pool {
 public:
   thread_pool(std::uint32_t size = std::thread::hardware_concurrency());
+  explicit thread_pool(thread_pool_options const& options);
   ~thread_pool();
 
   void start();
@@ -51,9 +83,51 @@ public:
     threads_[get_next_thread_idx()]->post(token, std::forward<Callable>(callback));
   }
 
+  template<typename Callable>
+  void post_before(Callable&& callback, std::chrono::steady_clock::time_point deadline) {
+    threads_[get_next_thread_idx()]->post_before(std::forward<Callable>(callback), deadline);
+  }
+
   template<typename Callable, typename R, typename D>
   void post(Callable&& callback, std::chrono::duration<R, D> const& timeout) {
-    threads_[get_next_thread_idx()]->post(std::forward<Callable>(callback), timeout);
+    post_at(std::forward<Callable>(callback), std::chrono::steady_clock::now() + timeout);
+  }
+
+  // Delayed tasks of the pool share one timer service thread; when due they
+  // are posted to the workers like any other task.
+  template<typename Callable>
+  timer_handle post_at(Callable&& callback, std::chrono::steady_clock::time_point when) {
+    auto state = std::make_shared<detail::timer_state>();
+
+    // Held as deduced, like message storage: lvalue callables by reference
+    timers_->schedule(when, state, [this, state, callback = std::tuple<Callable>{ std::forward<Callable>(callback) }] () mutable {
+      post([state, callback = std::move(callback)] () mutable {
+        if (!state->cancelled.load(std::memory_order_acquire)) std::get<0>(callback)();
+      });
+    });
+
+    return timer_handle{ state, timers_ };
+  }
+
+  // Runs `callback` every `period`, starting one period from now. Ticks are
+  // kept on a fixed grid so the schedule does not drift, and runs of one task
+  // never overlap. Throws std::invalid_argument unless `period` is positive.
+  template<typename Callable, typename R, typename D>
+  timer_handle post_every(std::chrono::duration<R, D> const& period, Callable&& callback,
+        overrun_policy policy = overrun_policy::skip) {
+    auto task = std::make_shared<detail::periodic_task>();
+    task->period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+    if (task->period <= std::chrono::steady_clock::duration::zero()) {
+      throw std::invalid_argument{ "thread_pool::post_every: period must be positive" };
+    }
+
+    task->callback = std::forward<Callable>(callback);
+    task->next = std::chrono::steady_clock::now() + task->period;
+    task->policy = policy;
+    task->state = std::make_shared<detail::timer_state>();
+
+    schedule(*timers_, task);
+    return timer_handle{ task->state, timers_ };
   }
 
   template<typename Callable>
@@ -69,16 +143,38 @@ public:
   template<typename Callable, typename R, typename D>
   auto post_awaitable(Callable&& callback, std::chrono::duration<R, D> const& timeout)
         -> std::future<std::invoke_result_t<Callable>> {
-    return threads_[get_next_thread_idx()]->post_awaitable(std::forward<Callable>(callback), timeout);
+    auto task = std::packaged_task<std::invoke_result_t<Callable>()>{ std::forward<Callable>(callback) };
+    auto future = task.get_future();
+
+    post(std::move(task), timeout);
+
+    return future;
+  }
+
+  // See handler_thread::post_blocking. The completion runs on the calling
+  // worker when called from one, otherwise on the next worker.
+  template<typename Callable, typename Completion>
+  void post_blocking(Callable&& callback, Completion&& completion) {
+    threads_[get_next_thread_idx()]->post_blocking(std::forward<Callable>(callback),
+          std::forward<Completion>(completion));
   }
 
   std::uint32_t size() const;
+  latency_statistics get_latency_statistics() const;
+  thread_statistics get_statistics() const;
+  thread_statistics get_statistics(std::uint32_t thread_idx) const;
 
 private:
   std::uint32_t get_next_thread_idx() const;
+  thread_options get_thread_options(std::uint32_t thread_idx) const;
+  void schedule(detail::timer_service& timers, std::shared_ptr<detail::periodic_task> const& task);
 
+  thread_pool_options const options_;
+  std::vector<std::vector<std::uint32_t>> placements_;
   std::uint32_t const size_;
   std::vector<std::unique_ptr<cyan::dispatch::handler_thread>> threads_;
+  std::shared_ptr<detail::work_group> group_;
+  std::shared_ptr<detail::timer_service> timers_;
   mutable std::atomic<std::uint32_t> cur_idx_;
 };
 
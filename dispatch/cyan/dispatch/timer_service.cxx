@@ -0,0 +1,89 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/dispatch/timer_service.h>
+
+namespace cyan::dispatch {
+
+void timer_handle::cancel() noexcept {
+  if (!state_) return;
+  state_->cancelled.store(true, std::memory_order_release);
+  if (auto service = service_.lock()) service->cancel(state_);
+}
+
+namespace detail {
+
+void periodic_task::advance(std::chrono::steady_clock::time_point now) {
+  next += period;
+
+  if (policy == overrun_policy::skip && next <= now) {
+    next += period * ((now - next) / period + 1);
+  }
+}
+
+namespace {
+
+thread_options make_options(std::string const& name) {
+  thread_options options;
+  options.name = name;
+  return options;
+}
+
+} // <anonymous>
+
+timer_service::timer_service(std::string const& name, std::chrono::milliseconds resolution)
+      : thread_{ make_options(name) } {
+  thread_.post_awaitable([this, resolution] {
+    wheel_ = std::make_unique<cyan::event::timer_wheel>(cyan::this_thread::get_event_loop(), resolution);
+  }).get();
+}
+
+void timer_service::cancel(std::shared_ptr<timer_state> const& state) {
+  thread_.post([this, state] {
+    if (!wheel_ || !state->scheduled) return;
+    wheel_->cancel(state->request);
+    state->scheduled = false;
+  });
+}
+
+bool timer_service::is_pending() {
+  if (thread_.is_stopping()) return false;
+  return thread_.post_awaitable([this] { return wheel_ && wheel_->is_pending(); }).get();
+}
+
+void timer_service::shutdown() {
+  if (thread_.is_stopping()) return;
+
+  // The wheel belongs to the service thread's loop
+  thread_.post_awaitable([this] { wheel_ = nullptr; }).get();
+  thread_.stop(true);
+  thread_.join();
+}
+
+timer_service::~timer_service() {
+  shutdown();
+}
+
+} // detail
+
+} // cyan::dispatch
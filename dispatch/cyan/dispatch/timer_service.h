@@ -0,0 +1,138 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <functional>
+
+#include <cyan/event.h>
+#include <cyan/noncopyable.h>
+#include <cyan/dispatch/serial_token.h>
+#include <cyan/dispatch/handler_thread.h>
+
+namespace cyan::dispatch {
+
+// What a periodic task does about ticks missed while it was late.
+//  - catch_up: run once for every missed tick, back to back.
+//  - skip: drop missed ticks and resume at the next one on the grid.
+enum class overrun_policy {
+  catch_up,
+  skip
+};
+
+namespace detail {
+
+class timer_service;
+
+// Shared by a timer_handle and the timer service
+struct timer_state {
+  std::atomic<bool> cancelled{ false };
+  // The pending wheel request, if any; touched on the service thread alone
+  cyan::event::timer_wheel::request_id_type request = 0;
+  bool scheduled = false;
+};
+
+} // detail
+
+// Cancels a task scheduled with post_at/post_every, taking its pending
+// request off the timer wheel. Cancelling does not interrupt a run that has
+// already started.
+class timer_handle {
+public:
+  timer_handle() = default;
+
+  void cancel() noexcept;
+
+  bool is_cancelled() const noexcept {
+    return state_ && state_->cancelled.load(std::memory_order_acquire);
+  }
+
+private:
+  friend class thread_pool;
+
+  timer_handle(std::shared_ptr<detail::timer_state> const& state,
+        std::weak_ptr<detail::timer_service> const& service) : state_{ state }, service_{ service } {}
+
+  std::shared_ptr<detail::timer_state> state_;
+  std::weak_ptr<detail::timer_service> service_;
+};
+
+namespace detail {
+
+struct periodic_task {
+  std::function<void()> callback;
+  std::chrono::steady_clock::duration period;
+  std::chrono::steady_clock::time_point next;
+  overrun_policy policy;
+  cyan::dispatch::serial_token token;
+  std::shared_ptr<timer_state> state;
+
+  // Advances `next` along the grid of the first deadline
+  void advance(std::chrono::steady_clock::time_point now);
+};
+
+// A handler thread owning the timer wheel shared by a whole pool. Callbacks
+// fire on the service thread and should only hand work off.
+class timer_service : public cyan::noncopyable {
+public:
+  constexpr static auto default_resolution = std::chrono::milliseconds(1);
+
+  explicit timer_service(std::string const& name,
+        std::chrono::milliseconds resolution = default_resolution);
+  ~timer_service();
+
+  // Fires `callback` at `when` unless `state` is cancelled first
+  template<typename Callable>
+  void schedule(std::chrono::steady_clock::time_point when, std::shared_ptr<timer_state> const& state,
+        Callable&& callback) {
+    thread_.post([this, when, state, callback = std::forward<Callable>(callback)] () mutable {
+      if (!wheel_ || state->cancelled.load(std::memory_order_acquire)) return;
+
+      state->request = wheel_->post_at([state, callback = std::move(callback)] () mutable {
+        state->scheduled = false;
+        callback();
+      }, when);
+      state->scheduled = true;
+    });
+  }
+
+  // Removes the pending request of `state` from the wheel
+  void cancel(std::shared_ptr<timer_state> const& state);
+  // Whether any request is left on the wheel
+  bool is_pending();
+  // Drops every pending request and joins the service thread; no callback
+  // runs once this returns, and later schedules are ignored
+  void shutdown();
+
+private:
+  handler_thread thread_;
+  std::unique_ptr<cyan::event::timer_wheel> wheel_;
+};
+
+} // detail
+
+} // cyan::dispatch
@@ -0,0 +1,154 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <set>
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <utility>
+
+#include <cyan/trace.h>
+#include <cyan/dispatch/topology.h>
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) || defined(HAVE_PTHREAD_SETNAME_NP) || defined(HAVE_PTHREAD_SETNAME_NP_SELF)
+#include <pthread.h>
+#endif
+
+namespace cyan::dispatch::topology {
+
+namespace {
+
+constexpr char const* sysfs_cpu = "/sys/devices/system/cpu/";
+constexpr char const* sysfs_node = "/sys/devices/system/node/";
+
+bool read_line(std::string const& path, std::string& line) {
+  std::ifstream in{ path };
+  return in && std::getline(in, line) && !line.empty();
+}
+
+// Parses the kernel's list format, e.g. "0-3,8,10-11".
+std::vector<std::uint32_t> parse_list(std::string const& list) {
+  std::vector<std::uint32_t> ids;
+  std::size_t pos = 0;
+
+  while (pos < list.size()) {
+    auto end = list.find(',', pos);
+    if (end == std::string::npos) end = list.size();
+
+    auto range = list.substr(pos, end - pos);
+    auto dash = range.find('-');
+    try {
+      auto first = static_cast<std::uint32_t>(std::stoul(range.substr(0, dash)));
+      auto last = dash == std::string::npos ? first
+            : static_cast<std::uint32_t>(std::stoul(range.substr(dash + 1)));
+      for (auto id = first; id <= last; id++) ids.push_back(id);
+    } catch (std::exception&) {
+    }
+
+    pos = end + 1;
+  }
+
+  return ids;
+}
+
+std::vector<std::uint32_t> read_list(std::string const& path) {
+  std::string line;
+  if (!read_line(path, line)) return {};
+  return parse_list(line);
+}
+
+} // <anonymous>
+
+std::vector<std::uint32_t> online_cpus() {
+  auto cpus = read_list(std::string{ sysfs_cpu } + "online");
+  if (cpus.empty()) {
+    auto const count = std::max(std::thread::hardware_concurrency(), 1u);
+    for (std::uint32_t i = 0; i < count; i++) cpus.push_back(i);
+  }
+  return cpus;
+}
+
+std::vector<std::uint32_t> physical_cores() {
+  std::vector<std::uint32_t> cores;
+  std::set<std::pair<std::string, std::string>> seen;
+
+  for (auto cpu : online_cpus()) {
+    auto const base = std::string{ sysfs_cpu } + "cpu" + std::to_string(cpu) + "/topology/";
+    std::string package, core;
+
+    if (!read_line(base + "physical_package_id", package) || !read_line(base + "core_id", core)) {
+      cores.push_back(cpu);
+    } else if (seen.emplace(package, core).second) {
+      cores.push_back(cpu);
+    }
+  }
+
+  return cores;
+}
+
+std::vector<std::vector<std::uint32_t>> numa_nodes() {
+  std::vector<std::vector<std::uint32_t>> nodes;
+
+  for (auto node : read_list(std::string{ sysfs_node } + "online")) {
+    auto cpus = read_list(std::string{ sysfs_node } + "node" + std::to_string(node) + "/cpulist");
+    if (!cpus.empty()) nodes.push_back(std::move(cpus));
+  }
+
+  if (nodes.empty()) nodes.push_back(online_cpus());
+  return nodes;
+}
+
+} // cyan::dispatch::topology
+
+namespace cyan::dispatch::detail {
+
+void set_current_thread_affinity(std::vector<std::uint32_t> const& cpus) {
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  if (cpus.empty()) return;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  }
+  ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+  (void) cpus;
+#endif
+}
+
+void set_current_thread_name(std::string const& name) {
+  if (name.empty()) return;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+  // Linux limits names to 15 characters plus the terminator.
+  ::pthread_setname_np(::pthread_self(), name.substr(0, 15).c_str());
+#elif defined(HAVE_PTHREAD_SETNAME_NP_SELF)
+  ::pthread_setname_np(name.c_str());
+#endif
+  cyan::trace::set_thread_name(name);
+}
+
+} // cyan::dispatch::detail
@@ -0,0 +1,51 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cyan::dispatch::topology {
+
+// Logical CPUs the kernel reports as online.
+std::vector<std::uint32_t> online_cpus();
+
+// One logical CPU per physical core, i.e. hyper-threading siblings are
+// skipped.
+std::vector<std::uint32_t> physical_cores();
+
+// Logical CPUs grouped by NUMA node. A machine without NUMA information is
+// reported as a single node.
+std::vector<std::vector<std::uint32_t>> numa_nodes();
+
+} // cyan::dispatch::topology
+
+namespace cyan::dispatch::detail {
+
+// Both apply to the calling thread and do nothing where unsupported.
+void set_current_thread_affinity(std::vector<std::uint32_t> const& cpus);
+void set_current_thread_name(std::string const& name);
+
+} // cyan::dispatch::detail
@@ -0,0 +1,78 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/dispatch/work_group.h>
+
+namespace cyan::dispatch::detail {
+
+namespace {
+
+thread_local work_group const* current_group = nullptr;
+thread_local std::uint32_t current_index = 0;
+
+} // <anonymous>
+
+work_group::work_group(std::uint32_t size) : members_(size) {
+  for (auto& m : members_) m.store(nullptr, std::memory_order_relaxed);
+}
+
+void work_group::join(std::uint32_t index, member* m) {
+  members_[index].store(m, std::memory_order_release);
+}
+
+void work_group::leave(std::uint32_t index) {
+  members_[index].store(nullptr, std::memory_order_release);
+}
+
+bool work_group::steal(std::uint32_t thief, std::unique_ptr<message>& msg) {
+  auto const size = static_cast<std::uint32_t>(members_.size());
+
+  // Start with the next sibling so that thieves spread over victims
+  for (std::uint32_t i = 1; i < size; i++) {
+    auto victim = members_[(thief + i) % size].load(std::memory_order_acquire);
+    if (victim && victim->try_steal(msg)) return true;
+  }
+  return false;
+}
+
+void work_group::wake_one(std::uint32_t waker) {
+  auto const size = static_cast<std::uint32_t>(members_.size());
+
+  for (std::uint32_t i = 1; i < size; i++) {
+    auto sibling = members_[(waker + i) % size].load(std::memory_order_acquire);
+    if (sibling && sibling->try_wake()) return;
+  }
+}
+
+void work_group::set_current(std::uint32_t index) {
+  current_group = this;
+  current_index = index;
+}
+
+bool work_group::get_current(std::uint32_t& index) const {
+  if (current_group != this) return false;
+  index = current_index;
+  return true;
+}
+
+} // cyan::dispatch::detail
@@ -0,0 +1,68 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <cyan/noncopyable.h>
+#include <cyan/dispatch/message.h>
+
+namespace cyan::dispatch::detail {
+
+// Handler threads of one pool. Idle members steal queued messages from busy
+// siblings, and a member that queues up work behind its LIFO slot wakes an
+// idle sibling to come and take it.
+class work_group : public cyan::noncopyable {
+public:
+  class member {
+  public:
+    virtual ~member() = default;
+
+    // Takes one message off the member's queue on behalf of a sibling.
+    virtual bool try_steal(std::unique_ptr<message>& msg) = 0;
+    // Wakes the member if it is idle; returns whether it was.
+    virtual bool try_wake() = 0;
+  };
+
+  explicit work_group(std::uint32_t size);
+
+  void join(std::uint32_t index, member* m);
+  void leave(std::uint32_t index);
+
+  bool steal(std::uint32_t thief, std::unique_ptr<message>& msg);
+  void wake_one(std::uint32_t waker);
+
+  // Marks the calling thread as member `index` of this group.
+  void set_current(std::uint32_t index);
+  // Index of the calling thread in this group, if it is a member.
+  bool get_current(std::uint32_t& index) const;
+
+private:
+  std::vector<std::atomic<member*>> members_;
+};
+
+} // cyan::dispatch::detail
@@ -0,0 +1,95 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <cyan/dispatch.h>
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) || defined(HAVE_PTHREAD_SETNAME_NP)
+#include <pthread.h>
+#endif
+
+class affinity_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(affinity_tests, topology) {
+  auto const cpus = cyan::dispatch::topology::online_cpus();
+  auto const cores = cyan::dispatch::topology::physical_cores();
+  auto const nodes = cyan::dispatch::topology::numa_nodes();
+
+  ASSERT_FALSE(cpus.empty());
+  ASSERT_FALSE(cores.empty());
+  ASSERT_FALSE(nodes.empty());
+  EXPECT_LE(cores.size(), cpus.size());
+  for (auto core : cores) {
+    EXPECT_NE(std::find(cpus.begin(), cpus.end(), core), cpus.end());
+  }
+}
+
+TEST_F(affinity_tests, pool_sized_by_placement) {
+  cyan::dispatch::thread_pool_options options;
+  options.affinity = cyan::dispatch::affinity::numa_node;
+
+  cyan::dispatch::thread_pool pool{ options };
+  EXPECT_EQ(pool.size(), cyan::dispatch::topology::numa_nodes().size());
+}
+
+TEST_F(affinity_tests, pinned_and_named_workers) {
+  auto const cpu = cyan::dispatch::topology::online_cpus().front();
+
+  cyan::dispatch::thread_pool_options options;
+  options.affinity = cyan::dispatch::affinity::cpus;
+  options.cpus = { cpu };
+  options.name = "pinned";
+  options.reserve = 2048;
+
+  cyan::dispatch::thread_pool pool{ options };
+  ASSERT_EQ(pool.size(), 1u);
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  auto on_cpu = pool.post_awaitable([cpu] {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    ::pthread_getaffinity_np(::pthread_self(), sizeof(set), &set);
+    return CPU_COUNT(&set) == 1 && CPU_ISSET(cpu, &set);
+  });
+  EXPECT_TRUE(on_cpu.get());
+#endif
+
+#ifdef HAVE_PTHREAD_SETNAME_NP
+  auto name = pool.post_awaitable([] {
+    char buffer[16] = {};
+    ::pthread_getname_np(::pthread_self(), buffer, sizeof(buffer));
+    return std::string{ buffer };
+  });
+  EXPECT_EQ(name.get(), "pinned-0");
+#endif
+}
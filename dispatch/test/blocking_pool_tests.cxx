@@ -0,0 +1,149 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <stdexcept>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class blocking_pool_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(blocking_pool_tests, completion_on_originating_thread) {
+  cyan::dispatch::handler_thread thread;
+  auto const thread_id = thread.post_awaitable([] { return std::this_thread::get_id(); }).get();
+  std::promise<std::pair<int, std::thread::id>> completed;
+
+  thread.post_blocking([thread_id] {
+    EXPECT_NE(std::this_thread::get_id(), thread_id);
+    std::this_thread::sleep_for(50ms);
+    return 42;
+  }, [&](std::future<int> result) {
+    completed.set_value({ result.get(), std::this_thread::get_id() });
+  });
+
+  // The handler thread stays responsive while the task blocks
+  auto responsive = thread.post_awaitable([] {});
+  EXPECT_EQ(responsive.wait_for(40ms), std::future_status::ready);
+
+  auto [value, id] = completed.get_future().get();
+  EXPECT_EQ(value, 42);
+  EXPECT_EQ(id, thread_id);
+}
+
+TEST_F(blocking_pool_tests, exception_in_future) {
+  cyan::dispatch::thread_pool pool{ 1 };
+  std::promise<bool> threw;
+
+  pool.post_blocking([] { throw std::runtime_error{ "failed" }; }, [&](std::future<void> result) {
+    try {
+      result.get();
+      threw.set_value(false);
+    } catch (std::runtime_error&) {
+      threw.set_value(true);
+    }
+  });
+
+  EXPECT_TRUE(threw.get_future().get());
+}
+
+TEST_F(blocking_pool_tests, elastic) {
+  constexpr int count = 8;
+  cyan::dispatch::blocking_pool_options options;
+  options.keep_alive = 50ms;
+  cyan::dispatch::blocking_pool pool{ options };
+  std::atomic<int> done{ 0 };
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) {
+    pool.post([&] {
+      std::this_thread::sleep_for(50ms);
+      done++;
+    });
+  }
+  EXPECT_EQ(pool.size(), std::uint32_t(count));
+
+  while (done.load() != count) std::this_thread::sleep_for(1ms);
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, count * 50ms);
+
+  // Idle threads exit after keep_alive
+  for (int i = 0; i < 100 && pool.size(); i++) std::this_thread::sleep_for(10ms);
+  EXPECT_EQ(pool.size(), 0u);
+}
+
+TEST_F(blocking_pool_tests, completion_dropped_after_destruction) {
+  std::promise<void> started;
+  std::promise<void> release;
+  auto finished = std::make_shared<std::promise<void>>();
+  std::atomic<bool> completed{ false };
+
+  {
+    cyan::dispatch::handler_thread thread;
+    thread.post_blocking([&, finished] {
+      started.set_value();
+      release.get_future().wait();
+      finished->set_value();
+    }, [&](std::future<void>) {
+      completed = true;
+    });
+    started.get_future().wait();
+  }
+
+  auto done = finished->get_future();
+  release.set_value();
+  done.wait();
+  std::this_thread::sleep_for(10ms);
+  EXPECT_FALSE(completed.load());
+}
+
+TEST_F(blocking_pool_tests, completion_dropped_after_pool_stop) {
+  cyan::dispatch::thread_pool pool{ 2 };
+  std::promise<void> started;
+  std::promise<void> release;
+  std::atomic<bool> completed{ false };
+
+  pool.post_blocking([&] {
+    started.set_value();
+    release.get_future().wait();
+  }, [&](std::future<void>) {
+    completed = true;
+  });
+  started.get_future().wait();
+  pool.stop();
+
+  release.set_value();
+  std::this_thread::sleep_for(10ms);
+  EXPECT_FALSE(completed.load());
+}
@@ -0,0 +1,77 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class budget_tests : public ::testing::Test {
+public:
+  // Keeps the queue of `thread` busy until a delayed message fires.
+  static bool timer_fires_under_load(cyan::dispatch::handler_thread& thread) {
+    std::atomic<bool> fired{ false };
+    std::promise<void> done;
+
+    std::function<void()> spin = [&] {
+      if (fired.load()) {
+        done.set_value();
+      } else {
+        thread.post(spin);
+        thread.post([] {});
+      }
+    };
+
+    thread.post([&] { fired = true; }, 1ms);
+    thread.post(spin);
+
+    return done.get_future().wait_for(5s) == std::future_status::ready;
+  }
+
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(budget_tests, message_budget) {
+  cyan::dispatch::thread_options options;
+  options.max_batch_size = 64;
+
+  cyan::dispatch::handler_thread thread{ options };
+  ASSERT_TRUE(timer_fires_under_load(thread));
+  EXPECT_GT(thread.get_statistics().yields, 0u);
+}
+
+TEST_F(budget_tests, time_budget) {
+  cyan::dispatch::thread_options options;
+  options.max_batch_time = 500us;
+
+  cyan::dispatch::handler_thread thread{ options };
+  ASSERT_TRUE(timer_fires_under_load(thread));
+  EXPECT_GT(thread.get_statistics().yields, 0u);
+}
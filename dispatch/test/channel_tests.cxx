@@ -0,0 +1,214 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <future>
+#include <thread>
+#include <functional>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class channel_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(channel_tests, bounded_try_send) {
+  cyan::dispatch::channel<int> ch{ 2 };
+
+  EXPECT_TRUE(ch.try_send(1));
+  EXPECT_TRUE(ch.try_send(2));
+  EXPECT_FALSE(ch.try_send(3));
+  EXPECT_EQ(ch.size(), 2u);
+
+  int value;
+  ASSERT_TRUE(ch.try_receive(value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(ch.try_send(3));
+  ASSERT_TRUE(ch.try_receive(value));
+  EXPECT_EQ(value, 2);
+  ASSERT_TRUE(ch.try_receive(value));
+  EXPECT_EQ(value, 3);
+  EXPECT_FALSE(ch.try_receive(value));
+}
+
+TEST_F(channel_tests, closed_channel) {
+  cyan::dispatch::channel<int> ch;
+  cyan::dispatch::handler_thread thread;
+
+  ch.close();
+  EXPECT_FALSE(ch.try_send(1));
+  EXPECT_FALSE(ch.send(1));
+
+  std::promise<bool> received;
+  thread.post([&] {
+    ch.receive([&](std::optional<int> value) { received.set_value(value.has_value()); });
+  });
+  EXPECT_FALSE(received.get_future().get());
+}
+
+TEST_F(channel_tests, receive_until_closed) {
+  constexpr int count = 10000;
+  cyan::dispatch::channel<int> ch{ 16 };
+  cyan::dispatch::handler_thread thread;
+  std::promise<long> sum;
+  long total = 0;
+
+  std::function<void(std::optional<int>)> on_value = [&](std::optional<int> value) {
+    if (!value) {
+      sum.set_value(total);
+      return;
+    }
+    total += *value;
+    ch.receive(on_value);
+  };
+  thread.post([&] { ch.receive(on_value); });
+
+  std::thread producer{ [&] {
+    for (int i = 1; i <= count; i++) ASSERT_TRUE(ch.send(i));
+    ch.close();
+  } };
+  producer.join();
+
+  EXPECT_EQ(sum.get_future().get(), long(count) * (count + 1) / 2);
+}
+
+TEST_F(channel_tests, select_runs_one_case) {
+  cyan::dispatch::channel<int> ints;
+  cyan::dispatch::channel<std::string> strings;
+  cyan::dispatch::handler_thread thread;
+  std::promise<std::string> selected;
+  std::atomic<int> calls{ 0 };
+
+  thread.post_awaitable([&] {
+    cyan::dispatch::select(
+      cyan::dispatch::on(ints, [&](std::optional<int>) {
+        calls++;
+        selected.set_value("int");
+      }),
+      cyan::dispatch::on(strings, [&](std::optional<std::string> value) {
+        calls++;
+        selected.set_value(*value);
+      })
+    );
+  }).get();
+
+  strings.send("hello");
+  EXPECT_EQ(selected.get_future().get(), "hello");
+
+  // The losing case was withdrawn and must not consume values
+  ints.send(1);
+  std::promise<int> received;
+  thread.post([&] {
+    ints.receive([&](std::optional<int> value) { received.set_value(*value); });
+  });
+  EXPECT_EQ(received.get_future().get(), 1);
+  EXPECT_EQ(calls.load(), 1);
+}
+
+TEST_F(channel_tests, select_releases_losing_cases) {
+  constexpr int count = 100;
+  cyan::dispatch::channel<int> idle;
+  cyan::dispatch::channel<int> ready;
+  cyan::dispatch::handler_thread thread;
+  auto token = std::make_shared<int>(0);
+  std::promise<void> done;
+
+  std::function<void(int)> next = [&](int remaining) {
+    cyan::dispatch::select(
+      cyan::dispatch::on(idle, [token](std::optional<int>) {}),
+      cyan::dispatch::on(ready, [&, remaining](std::optional<int>) {
+        if (remaining) {
+          next(remaining - 1);
+        } else {
+          done.set_value();
+        }
+      })
+    );
+  };
+
+  for (int i = 0; i <= count; i++) ASSERT_TRUE(ready.send(i));
+  thread.post([&] { next(count); });
+  done.get_future().get();
+
+  // Every losing case was withdrawn from the idle channel and released
+  EXPECT_EQ(token.use_count(), 1);
+}
+
+TEST_F(channel_tests, blocked_sender) {
+  cyan::dispatch::channel<int> ch{ 1 };
+  ASSERT_TRUE(ch.try_send(1));
+
+  // A receive makes room for one blocked sender
+  auto sent = std::async(std::launch::async, [&] { return ch.send(2); });
+  EXPECT_EQ(sent.wait_for(20ms), std::future_status::timeout);
+  int value;
+  ASSERT_TRUE(ch.try_receive(value));
+  EXPECT_TRUE(sent.get());
+  ASSERT_TRUE(ch.try_receive(value));
+  EXPECT_EQ(value, 2);
+
+  // Closing releases blocked senders
+  ASSERT_TRUE(ch.try_send(3));
+  auto rejected = std::async(std::launch::async, [&] { return ch.send(4); });
+  EXPECT_EQ(rejected.wait_for(20ms), std::future_status::timeout);
+  ch.close();
+  EXPECT_FALSE(rejected.get());
+}
+
+TEST_F(channel_tests, every_receive_wakes_a_sender) {
+  cyan::dispatch::channel<int> ch{ 4 };
+  for (int i = 0; i < 4; i++) ASSERT_TRUE(ch.try_send(i));
+
+  auto sent = std::async(std::launch::async, [&] { return ch.send(4); });
+  EXPECT_EQ(sent.wait_for(20ms), std::future_status::timeout);
+  int value;
+  ASSERT_TRUE(ch.try_receive(value));
+  ASSERT_EQ(sent.wait_for(1s), std::future_status::ready);
+  EXPECT_TRUE(sent.get());
+  EXPECT_EQ(ch.size(), 4u);
+}
+
+TEST_F(channel_tests, value_without_default_constructor) {
+  struct value_type {
+    explicit value_type(int v) : v{ v } {}
+    int v;
+  };
+  cyan::dispatch::channel<value_type> ch;
+  cyan::dispatch::handler_thread thread;
+  std::promise<int> received;
+
+  ASSERT_TRUE(ch.try_send(value_type{ 7 }));
+  thread.post([&] {
+    ch.receive([&](std::optional<value_type> value) { received.set_value(value->v); });
+  });
+  EXPECT_EQ(received.get_future().get(), 7);
+}
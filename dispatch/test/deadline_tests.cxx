@@ -0,0 +1,150 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <future>
+#include <functional>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class deadline_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(deadline_tests, earliest_deadline_first) {
+  cyan::dispatch::handler_thread thread;
+  std::promise<void> started, release;
+  std::vector<int> order;
+
+  thread.post([&started, future = release.get_future()] {
+    started.set_value();
+    future.wait();
+  });
+  started.get_future().wait();
+
+  auto const now = std::chrono::steady_clock::now();
+  thread.post([&] { order.push_back(0); });
+  thread.post_before([&] { order.push_back(3); }, now + 3s);
+  thread.post_before([&] { order.push_back(1); }, now + 1s);
+  thread.post_before([&] { order.push_back(2); }, now + 2s);
+
+  release.set_value();
+  thread.post_awaitable([] {}).get();
+
+  // Deadline tasks go ahead of the plain FIFO ones
+  EXPECT_EQ(order, (std::vector<int>{ 1, 2, 3, 0 }));
+}
+
+TEST_F(deadline_tests, missed_deadline_dropped) {
+  std::mutex mutex;
+  std::vector<std::chrono::nanoseconds> missed;
+
+  cyan::dispatch::thread_options options;
+  options.on_deadline_missed = [&](std::chrono::nanoseconds late) {
+    std::lock_guard<std::mutex> lock{ mutex };
+    missed.push_back(late);
+  };
+
+  cyan::dispatch::handler_thread thread{ options };
+  std::promise<void> started, release;
+  thread.post([&started, future = release.get_future()] {
+    started.set_value();
+    future.wait();
+  });
+  started.get_future().wait();
+
+  auto const now = std::chrono::steady_clock::now();
+  auto stale = std::packaged_task<void()>{ [] {} };
+  auto stale_future = stale.get_future();
+  thread.post_before(std::move(stale), now + 5ms);
+
+  auto fresh = std::packaged_task<void()>{ [] {} };
+  auto fresh_future = fresh.get_future();
+  thread.post_before(std::move(fresh), now + 10s);
+
+  std::this_thread::sleep_for(20ms);
+  release.set_value();
+
+  fresh_future.get();
+  EXPECT_THROW(stale_future.get(), std::future_error);
+
+  auto const stats = thread.get_statistics();
+  EXPECT_EQ(stats.dropped, 1u);
+  EXPECT_EQ(stats.queue_depth(), 0u);
+
+  std::lock_guard<std::mutex> lock{ mutex };
+  ASSERT_EQ(missed.size(), 1u);
+  EXPECT_GE(missed[0], 10ms);
+}
+
+TEST_F(deadline_tests, pool) {
+  std::atomic<int> missed{ 0 };
+
+  cyan::dispatch::thread_pool_options options;
+  options.size = 2;
+  options.on_deadline_missed = [&](std::chrono::nanoseconds) { ++missed; };
+  cyan::dispatch::thread_pool pool{ options };
+
+  std::promise<void> ran;
+  pool.post_before([&] { ran.set_value(); }, std::chrono::steady_clock::now() + 10s);
+  ran.get_future().get();
+
+  pool.post_before([] {}, std::chrono::steady_clock::now() - 1ms);
+  pool.post_awaitable([] {}).get();
+  std::this_thread::sleep_for(10ms);
+
+  EXPECT_EQ(missed.load(), 1);
+  EXPECT_EQ(pool.get_statistics().dropped, 1u);
+}
+
+TEST_F(deadline_tests, ordinary_tasks_not_starved) {
+  cyan::dispatch::handler_thread thread;
+  std::atomic<bool> ran{ false };
+  std::atomic<int> reposts{ 0 };
+  std::promise<void> done;
+
+  // Keeps a deadline task queued at all times until the plain one has run
+  std::function<void()> repost = [&] {
+    if (ran || ++reposts == 10000) {
+      done.set_value();
+      return;
+    }
+    thread.post_before(repost, std::chrono::steady_clock::now() + 10s);
+  };
+  thread.post_before(repost, std::chrono::steady_clock::now() + 10s);
+  thread.post([&] { ran = true; });
+
+  done.get_future().wait();
+  EXPECT_TRUE(ran);
+  EXPECT_LT(reposts.load(), 10000);
+}
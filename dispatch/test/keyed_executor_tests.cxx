@@ -0,0 +1,120 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include <cyan/dispatch.h>
+
+class keyed_executor_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(keyed_executor_tests, per_key_fifo) {
+  constexpr int keys = 64;
+  constexpr int per_key = 200;
+  cyan::dispatch::thread_pool pool{ 4 };
+  std::vector<std::vector<int>> seen(keys);
+
+  {
+    cyan::dispatch::keyed_executor<std::uint64_t> executor{ pool, 8 };
+    EXPECT_EQ(executor.shards(), 8u);
+
+    for (int i = 0; i < per_key; i++) {
+      for (int k = 0; k < keys; k++) {
+        // Tasks of a key never overlap, so no lock is needed
+        executor.post(k, [&seen, k, i] { seen[k].push_back(i); });
+      }
+    }
+  }
+
+  for (int k = 0; k < keys; k++) {
+    ASSERT_EQ(seen[k].size(), std::size_t(per_key));
+    for (int i = 0; i < per_key; i++) EXPECT_EQ(seen[k][i], i);
+  }
+}
+
+TEST_F(keyed_executor_tests, shard_is_serial) {
+  cyan::dispatch::thread_pool pool{ 4 };
+  std::atomic<int> running{ 0 };
+  std::atomic<bool> overlapped{ false };
+
+  {
+    // One shard: every key shares the same strand
+    cyan::dispatch::keyed_executor<int> executor{ pool, 1 };
+    for (int i = 0; i < 100; i++) {
+      executor.post(i, [&] {
+        if (++running > 1) overlapped = true;
+        std::this_thread::yield();
+        --running;
+      });
+    }
+  }
+
+  EXPECT_FALSE(overlapped);
+}
+
+TEST_F(keyed_executor_tests, exception_does_not_stall) {
+  cyan::dispatch::thread_pool pool{ 2 };
+  cyan::dispatch::keyed_executor<int> executor{ pool };
+  std::promise<void> done;
+
+  executor.post(1, [] { throw std::runtime_error{ "failed" }; });
+  executor.post(1, [&] { done.set_value(); });
+
+  EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(1)), std::future_status::ready);
+}
+
+TEST_F(keyed_executor_tests, pool_stopped_with_drains_left) {
+  cyan::dispatch::thread_pool pool{ 1 };
+  std::atomic<int> ran{ 0 };
+  std::promise<void> gate;
+  auto opened = gate.get_future().share();
+
+  {
+    cyan::dispatch::keyed_executor<int> executor{ pool };
+    executor.post(1, [opened] { opened.wait(); });
+    // More than one drain's worth, so the drain has to reschedule itself
+    for (int i = 0; i < 200; i++) executor.post(1, [&ran] { ran++; });
+
+    std::thread stopper{ [&pool] { pool.stop(); } };
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    gate.set_value();
+    stopper.join();
+  }
+
+  EXPECT_LT(ran.load(), 200);
+}
@@ -0,0 +1,157 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cyan/log.h>
+#include <cyan/dispatch.h>
+
+class log_tests : public ::testing::Test {
+public:
+  void SetUp() {
+    ASSERT_EQ(::pipe(fds_), 0);
+    cyan::log::set_level(cyan::log::level::debug);
+  }
+
+  void TearDown() {
+    cyan::log::set_level(cyan::log::level::info);
+    ::close(fds_[0]);
+    ::close(fds_[1]);
+  }
+
+  std::vector<std::string> read_lines() {
+    std::string data;
+    char buffer[4096];
+    ::fcntl(fds_[0], F_SETFL, O_NONBLOCK);
+    for (auto n = ::read(fds_[0], buffer, sizeof(buffer)); n > 0; n = ::read(fds_[0], buffer, sizeof(buffer))) {
+      data.append(buffer, static_cast<std::size_t>(n));
+    }
+
+    std::vector<std::string> lines;
+    std::istringstream is{ data };
+    for (std::string line; std::getline(is, line);) lines.push_back(line);
+    return lines;
+  }
+
+  int fds_[2];
+};
+
+TEST_F(log_tests, write_and_printf) {
+  cyan::dispatch::log_writer_options options;
+  options.fd = fds_[1];
+  cyan::dispatch::log_writer writer{ options };
+
+  cyan::log::write(cyan::log::level::info, "plain text");
+  cyan::log::printf(cyan::log::level::warn, "value=%d name=%s", 42, "literal");
+  cyan::log::printf(cyan::log::level::trace, "below the level");
+  writer.flush();
+
+  auto const lines = read_lines();
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_NE(lines[0].find("INFO "), std::string::npos);
+  EXPECT_NE(lines[0].find("plain text"), std::string::npos);
+  EXPECT_NE(lines[1].find("WARN "), std::string::npos);
+  EXPECT_NE(lines[1].find("value=42 name=literal"), std::string::npos);
+  EXPECT_EQ(writer.written(), 2u);
+}
+
+TEST_F(log_tests, many_threads) {
+  constexpr int threads = 4;
+  constexpr int per_thread = 100;
+  cyan::dispatch::log_writer_options options;
+  options.fd = fds_[1];
+  cyan::dispatch::log_writer writer{ options };
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threads; t++) {
+    producers.emplace_back([t] {
+      for (int i = 0; i < per_thread; i++) cyan::log::printf(cyan::log::level::debug, "t%d %d", t, i);
+    });
+  }
+  for (auto& producer : producers) producer.join();
+  writer.flush();
+
+  auto const lines = read_lines();
+  ASSERT_EQ(lines.size(), std::size_t(threads * per_thread));
+
+  // Each thread's records stay in order
+  std::vector<int> next(threads, 0);
+  for (auto& line : lines) {
+    int t = 0, i = 0;
+    ASSERT_EQ(std::sscanf(line.substr(line.rfind(" t") + 1).c_str(), "t%d %d", &t, &i), 2);
+    EXPECT_EQ(i, next[t]++);
+  }
+}
+
+TEST_F(log_tests, full_ring_drops) {
+  auto const before = cyan::log::dropped();
+  cyan::log::set_capacity(4);
+
+  std::thread producer{ [] {
+    for (int i = 0; i < 10; i++) cyan::log::write(cyan::log::level::error, "flood");
+  } };
+  producer.join();
+  cyan::log::set_capacity(cyan::log::default_capacity);
+
+  EXPECT_EQ(cyan::log::dropped() - before, 6u);
+
+  std::vector<std::string> batches;
+  EXPECT_EQ(cyan::log::consume(batches), 4u);
+}
+
+TEST_F(log_tests, flush_with_sustained_producer) {
+  cyan::dispatch::log_writer_options options;
+  options.fd = ::open("/dev/null", O_WRONLY);
+  options.max_per_thread = 1;
+  cyan::dispatch::log_writer writer{ options };
+
+  std::atomic<bool> done{ false };
+  std::atomic<bool> flushed{ false };
+  std::thread producer{ [&] {
+    while (!done) cyan::log::write(cyan::log::level::info, "busy");
+  } };
+
+  std::thread flusher{ [&] {
+    writer.flush();
+    flushed = true;
+  } };
+  auto const until = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (!flushed && std::chrono::steady_clock::now() < until) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // Still logging, so a flush that waits for the rings to empty never returns
+  EXPECT_TRUE(flushed);
+  done = true;
+  producer.join();
+  flusher.join();
+  ::close(options.fd);
+}
@@ -0,0 +1,198 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class pipeline_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(pipeline_tests, ordered_parallel_stage) {
+  constexpr int count = 200;
+  std::vector<int> results;
+  std::vector<cyan::dispatch::stage_statistics> stats;
+
+  {
+    cyan::dispatch::stage_options parallel;
+    parallel.workers = 4;
+    parallel.ordered = true;
+
+    auto pipeline = cyan::dispatch::make_pipeline<std::string>()
+      .stage("parse", [](std::string&& text) {
+        auto value = std::stoi(text);
+        if (value % 7 == 0) std::this_thread::sleep_for(100us);
+        return value;
+      }, parallel)
+      .stage("double", [](int&& value) { return value * 2; })
+      .stage("collect", [&](int&& value) { results.push_back(value); })
+      .build();
+
+    for (int i = 0; i < count; i++) pipeline.push(std::to_string(i));
+    stats = pipeline.get_statistics();
+  }
+
+  ASSERT_EQ(results.size(), std::size_t(count));
+  for (int i = 0; i < count; i++) EXPECT_EQ(results[i], i * 2);
+
+  ASSERT_EQ(stats.size(), 3u);
+  EXPECT_EQ(stats[0].name, "parse");
+  EXPECT_EQ(stats[2].name, "collect");
+}
+
+TEST_F(pipeline_tests, backpressure) {
+  constexpr int count = 50;
+  std::atomic<int> processed{ 0 };
+
+  cyan::dispatch::stage_options small;
+  small.capacity = 4;
+
+  auto pipeline = cyan::dispatch::make_pipeline<int>()
+    .stage("slow", [&](int&&) {
+      std::this_thread::sleep_for(200us);
+      processed++;
+    }, small)
+    .build();
+
+  for (int i = 0; i < count; i++) pipeline.push(i);
+
+  // Producer could never run more than `capacity` items ahead
+  EXPECT_GE(processed.load(), count - 4);
+
+  auto stats = pipeline.get_statistics();
+  EXPECT_EQ(stats[0].backpressure.count(), std::uint64_t(count));
+  EXPECT_GT(stats[0].backpressure.max(), 0u);
+}
+
+TEST_F(pipeline_tests, batched_hand_off) {
+  std::atomic<int> sum{ 0 };
+  std::vector<cyan::dispatch::stage_statistics> stats;
+
+  {
+    cyan::dispatch::stage_options batched;
+    batched.batch_size = 10;
+
+    auto pipeline = cyan::dispatch::make_pipeline<int>()
+      .stage("identity", [](int&& value) { return value; }, batched)
+      .stage("sum", [&](int&& value) { sum += value; })
+      .build();
+
+    std::vector<int> batch;
+    for (int i = 1; i <= 100; i++) batch.push_back(i);
+    pipeline.push(std::move(batch));
+
+    // Let the last stage finish before sampling its statistics
+    while (sum.load() != 5050) std::this_thread::sleep_for(1ms);
+    stats = pipeline.get_statistics();
+  }
+
+  EXPECT_EQ(sum.load(), 5050);
+  EXPECT_EQ(stats[1].items, 100u);
+  // 100 outputs in batches of at most 10
+  EXPECT_GE(stats[1].latency.queue_wait.count(), 9u);
+}
+
+TEST_F(pipeline_tests, coalesced_hand_off) {
+  constexpr int count = 100;
+  std::atomic<int> sum{ 0 };
+  std::promise<void> gate;
+  auto opened = gate.get_future().share();
+  std::vector<cyan::dispatch::stage_statistics> stats;
+
+  {
+    cyan::dispatch::stage_options batched;
+    batched.batch_size = 10;
+
+    auto pipeline = cyan::dispatch::make_pipeline<int>()
+      .stage("identity", [&](int&& value) {
+        opened.wait();
+        return value;
+      }, batched)
+      .stage("sum", [&](int&& value) { sum += value; })
+      .build();
+
+    // Single items queue up behind the gate and leave in batches of 10
+    for (int i = 1; i <= count; i++) pipeline.push(i);
+    gate.set_value();
+
+    while (sum.load() != count * (count + 1) / 2) std::this_thread::sleep_for(1ms);
+    stats = pipeline.get_statistics();
+  }
+
+  EXPECT_EQ(stats[1].items, std::uint64_t(count));
+  EXPECT_EQ(stats[1].latency.queue_wait.count(), 10u);
+}
+
+TEST_F(pipeline_tests, ordered_hand_off_outside_lock) {
+  constexpr int count = 6;
+  std::vector<int> results;
+  std::promise<void> gate;
+  auto opened = gate.get_future().share();
+  std::vector<cyan::dispatch::stage_statistics> stats;
+
+  {
+    cyan::dispatch::stage_options parallel;
+    parallel.workers = 2;
+    parallel.ordered = true;
+    cyan::dispatch::stage_options narrow;
+    narrow.capacity = 1;
+
+    auto pipeline = cyan::dispatch::make_pipeline<int>()
+      .stage("ordered", [](int&& value) {
+        // Odd items, on the second worker, reach the blocked stage first
+        if (value && value % 2 == 0) std::this_thread::sleep_for(10ms);
+        return value;
+      }, parallel)
+      .stage("blocked", [&](int&& value) {
+        opened.wait();
+        results.push_back(value);
+      }, narrow)
+      .build();
+
+    for (int i = 0; i < count; i++) pipeline.push(i);
+
+    // One worker waits on the blocked stage's capacity; the other still
+    // gets through its batches
+    for (int i = 0; i < 1000 && pipeline.get_statistics()[0].items < count / 2; i++) {
+      std::this_thread::sleep_for(1ms);
+    }
+    stats = pipeline.get_statistics();
+    gate.set_value();
+  }
+
+  EXPECT_GE(stats[0].items, std::uint64_t(count / 2));
+  ASSERT_EQ(results.size(), std::size_t(count));
+  for (int i = 0; i < count; i++) EXPECT_EQ(results[i], i);
+}
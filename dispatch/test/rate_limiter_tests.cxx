@@ -0,0 +1,133 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <string>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class rate_limiter_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(rate_limiter_tests, token_bucket) {
+  cyan::dispatch::detail::token_bucket bucket{ { 10., 3 } };
+  auto const now = std::chrono::steady_clock::now();
+
+  EXPECT_TRUE(bucket.try_acquire(now));
+  EXPECT_TRUE(bucket.try_acquire(now));
+  EXPECT_TRUE(bucket.try_acquire(now));
+  EXPECT_FALSE(bucket.try_acquire(now));
+  EXPECT_EQ(bucket.time_to_next(now), 100ms);
+
+  EXPECT_FALSE(bucket.try_acquire(now + 99ms));
+  EXPECT_TRUE(bucket.try_acquire(now + 100ms));
+  EXPECT_FALSE(bucket.try_acquire(now + 100ms));
+}
+
+TEST_F(rate_limiter_tests, rate) {
+  constexpr int count = 25;
+  cyan::dispatch::thread_pool pool{ 2 };
+  cyan::dispatch::rate_limiter<cyan::dispatch::thread_pool> limiter{ pool, { 200., 5 } };
+  std::atomic<int> executed{ 0 };
+  std::promise<void> done;
+
+  auto const start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) {
+    limiter.post([&] { if (++executed == count) done.set_value(); });
+  }
+  EXPECT_GT(limiter.pending(), 0u);
+
+  done.get_future().get();
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+
+  // The first burst runs at once, the rest at 5ms intervals
+  EXPECT_GE(elapsed, 95ms);
+  EXPECT_EQ(limiter.deferred(), std::uint64_t(count - 5));
+  EXPECT_EQ(limiter.pending(), 0u);
+}
+
+TEST_F(rate_limiter_tests, handler_thread) {
+  cyan::dispatch::handler_thread thread;
+  cyan::dispatch::rate_limiter<cyan::dispatch::handler_thread> limiter{ thread, { 100., 2 } };
+  std::atomic<int> executed{ 0 };
+  std::promise<void> done;
+
+  for (int i = 0; i < 4; i++) {
+    limiter.post([&] { if (++executed == 4) done.set_value(); });
+  }
+
+  EXPECT_EQ(done.get_future().wait_for(2s), std::future_status::ready);
+}
+
+TEST_F(rate_limiter_tests, keyed) {
+  cyan::dispatch::thread_pool pool{ 2 };
+  cyan::dispatch::keyed_rate_limiter<std::string, cyan::dispatch::thread_pool> limiter{ pool, { 5., 2 } };
+  std::atomic<int> executed{ 0 };
+
+  for (int i = 0; i < 3; i++) {
+    limiter.post("a", [&] { ++executed; });
+    limiter.post("b", [&] { ++executed; });
+  }
+
+  // Each key has its own bucket: two run at once, one waits
+  EXPECT_EQ(limiter.pending("a"), 1u);
+  EXPECT_EQ(limiter.pending("b"), 1u);
+  EXPECT_EQ(limiter.pending("c"), 0u);
+
+  pool.post_awaitable([] {}).get();
+  std::this_thread::sleep_for(20ms);
+  EXPECT_EQ(executed.load(), 4);
+
+  limiter.erase("a");
+  EXPECT_EQ(limiter.pending("a"), 0u);
+}
+
+TEST_F(rate_limiter_tests, sustained_rate_above_timer_granularity) {
+  constexpr int count = 1000;
+  cyan::dispatch::thread_pool pool{ 2 };
+  cyan::dispatch::rate_limiter<cyan::dispatch::thread_pool> limiter{ pool, { 5000., 1 } };
+  std::atomic<int> executed{ 0 };
+  std::promise<void> done;
+
+  auto const start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) {
+    limiter.post([&] { if (++executed == count) done.set_value(); });
+  }
+  done.get_future().get();
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+
+  // 200ms at 5000/s; one task per 1ms release timer would take a second
+  EXPECT_GE(elapsed, 190ms);
+  EXPECT_LT(elapsed, 500ms);
+}
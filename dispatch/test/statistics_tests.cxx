@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class statistics_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(statistics_tests, histogram_percentiles) {
+  cyan::histogram histogram;
+
+  for (std::uint64_t i = 1; i <= 1000; i++) histogram.record(i * 1000);
+
+  EXPECT_EQ(histogram.count(), 1000u);
+  EXPECT_EQ(histogram.min(), 1000u);
+  EXPECT_EQ(histogram.max(), 1000000u);
+
+  // Relative error is bounded by the sub-bucket resolution (1/64)
+  auto const p50 = histogram.value_at_percentile(50.);
+  auto const p99 = histogram.value_at_percentile(99.);
+  EXPECT_NEAR(double(p50), 500000., 500000. / 64.);
+  EXPECT_NEAR(double(p99), 990000., 990000. / 64.);
+}
+
+TEST_F(statistics_tests, histogram_merge) {
+  cyan::histogram a, b;
+  a.record(10);
+  b.record(20);
+  b.record(30);
+
+  a.merge(b);
+  EXPECT_EQ(a.count(), 3u);
+  EXPECT_EQ(a.min(), 10u);
+  EXPECT_EQ(a.max(), 30u);
+  EXPECT_DOUBLE_EQ(a.mean(), 20.);
+}
+
+TEST_F(statistics_tests, handler_thread_latencies) {
+  constexpr std::uint64_t count = 100;
+  cyan::dispatch::handler_thread thread;
+
+  for (std::uint64_t i = 0; i < count - 1; i++) {
+    thread.post([] { std::this_thread::sleep_for(10us); });
+  }
+  thread.post_awaitable([] {}).get();
+
+  auto stats = thread.get_latency_statistics();
+  // The last task's latencies are recorded once it returns
+  EXPECT_GE(stats.run_time.count(), count - 1);
+  EXPECT_GE(stats.queue_wait.count(), count - 1);
+  EXPECT_GE(stats.run_time.value_at_percentile(50.), 10000u);
+  EXPECT_GE(stats.end_to_end.max(), stats.run_time.max());
+}
+
+TEST_F(statistics_tests, thread_pool_merge) {
+  cyan::dispatch::thread_pool pool{ 2 };
+
+  for (auto i = 0; i < 10; i++) pool.post_awaitable([] {}).get();
+
+  EXPECT_GE(pool.get_latency_statistics().run_time.count(), 9u);
+}
+
+TEST_F(statistics_tests, handler_thread_counters) {
+  constexpr std::uint64_t count = 50;
+  cyan::dispatch::handler_thread thread;
+
+  for (std::uint64_t i = 0; i < count - 1; i++) {
+    thread.post([] { std::this_thread::sleep_for(100us); });
+  }
+  thread.post_awaitable([] {}).get();
+
+  auto stats = thread.get_statistics();
+  EXPECT_EQ(stats.enqueued, count);
+  EXPECT_EQ(stats.dequeued, count);
+  EXPECT_GE(stats.executed, count - 1);
+  EXPECT_EQ(stats.queue_depth(), 0u);
+  EXPECT_GE(stats.loop_iterations, 1u);
+  EXPECT_GE(stats.busy_time, (count - 1) * 100us);
+  EXPECT_GT(stats.utilization(), 0.);
+  EXPECT_LE(stats.utilization(), 1.);
+}
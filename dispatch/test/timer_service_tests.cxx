@@ -0,0 +1,175 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class timer_service_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(timer_service_tests, post_at) {
+  cyan::dispatch::thread_pool pool{ 2 };
+  auto const start = std::chrono::steady_clock::now();
+  std::promise<std::chrono::steady_clock::time_point> fired;
+
+  pool.post_at([&] { fired.set_value(std::chrono::steady_clock::now()); }, start + 30ms);
+
+  auto const elapsed = fired.get_future().get() - start;
+  EXPECT_GE(elapsed, 29ms);
+  EXPECT_LT(elapsed, 500ms);
+}
+
+TEST_F(timer_service_tests, post_at_cancel) {
+  cyan::dispatch::thread_pool pool{ 1 };
+  std::atomic<bool> fired{ false };
+
+  auto handle = pool.post_at([&] { fired = true; }, std::chrono::steady_clock::now() + 20ms);
+  handle.cancel();
+  EXPECT_TRUE(handle.is_cancelled());
+
+  std::this_thread::sleep_for(60ms);
+  EXPECT_FALSE(fired);
+}
+
+TEST_F(timer_service_tests, delayed_post) {
+  cyan::dispatch::thread_pool pool{ 2 };
+  auto const start = std::chrono::steady_clock::now();
+
+  auto result = pool.post_awaitable([] { return 7; }, 20ms);
+
+  EXPECT_EQ(result.get(), 7);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 19ms);
+}
+
+TEST_F(timer_service_tests, post_every) {
+  cyan::dispatch::thread_pool pool{ 2 };
+  std::atomic<int> ticks{ 0 };
+
+  auto handle = pool.post_every(10ms, [&] { ++ticks; });
+  std::this_thread::sleep_for(105ms);
+  handle.cancel();
+  auto const count = ticks.load();
+
+  // Drift free: roughly one tick per period, never more
+  EXPECT_GE(count, 5);
+  EXPECT_LE(count, 10);
+
+  std::this_thread::sleep_for(40ms);
+  EXPECT_LE(ticks.load(), count + 1);
+}
+
+TEST_F(timer_service_tests, no_overlap) {
+  cyan::dispatch::thread_pool pool{ 4 };
+  std::atomic<int> running{ 0 };
+  std::atomic<bool> overlapped{ false };
+
+  auto handle = pool.post_every(2ms, [&] {
+    if (++running > 1) overlapped = true;
+    std::this_thread::sleep_for(5ms);
+    --running;
+  }, cyan::dispatch::overrun_policy::catch_up);
+
+  std::this_thread::sleep_for(60ms);
+  handle.cancel();
+  std::this_thread::sleep_for(30ms);
+
+  EXPECT_FALSE(overlapped);
+}
+
+TEST_F(timer_service_tests, overrun_policy) {
+  using namespace cyan::dispatch;
+  auto const start = std::chrono::steady_clock::now();
+
+  detail::periodic_task task;
+  task.period = 10ms;
+  task.next = start + 10ms;
+
+  // Three ticks late: skip lands on the next grid point after now
+  task.policy = overrun_policy::skip;
+  task.advance(start + 35ms);
+  EXPECT_EQ(task.next, start + 40ms);
+
+  // catch_up walks the grid one tick at a time
+  task.next = start + 10ms;
+  task.policy = overrun_policy::catch_up;
+  task.advance(start + 35ms);
+  EXPECT_EQ(task.next, start + 20ms);
+}
+
+TEST_F(timer_service_tests, post_every_rejects_non_positive_period) {
+  cyan::dispatch::thread_pool pool{ 1 };
+
+  EXPECT_THROW(pool.post_every(0ms, [] {}), std::invalid_argument);
+  EXPECT_THROW(pool.post_every(-5ms, [] {}, cyan::dispatch::overrun_policy::catch_up), std::invalid_argument);
+}
+
+TEST_F(timer_service_tests, cancel_removes_request) {
+  using namespace cyan::dispatch;
+  auto service = std::make_shared<detail::timer_service>("timer-test");
+
+  std::vector<std::shared_ptr<detail::timer_state>> states;
+  std::atomic<int> fired{ 0 };
+  for (auto i = 0; i < 100; i++) {
+    auto& state = states.emplace_back(std::make_shared<detail::timer_state>());
+    service->schedule(std::chrono::steady_clock::now() + 1h, state, [&fired] { ++fired; });
+  }
+  EXPECT_TRUE(service->is_pending());
+
+  // As timer_handle::cancel does
+  for (auto& state : states) {
+    state->cancelled = true;
+    service->cancel(state);
+  }
+  EXPECT_FALSE(service->is_pending());
+  EXPECT_EQ(fired.load(), 0);
+}
+
+TEST_F(timer_service_tests, stop_while_firing) {
+  std::atomic<int> runs{ 0 };
+
+  for (int i = 0; i < 20; i++) {
+    cyan::dispatch::thread_pool pool{ 2 };
+    for (int j = 0; j < 4; j++) {
+      auto handle = pool.post_every(1ms, [&] { runs++; });
+      (void) handle;
+    }
+    pool.post_at([&] { runs++; }, std::chrono::steady_clock::now() + 2ms);
+    std::this_thread::sleep_for(3ms);
+    pool.stop();
+  }
+
+  EXPECT_GT(runs.load(), 0);
+}
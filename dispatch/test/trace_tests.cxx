@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <sstream>
+
+#include <cyan/trace.h>
+#include <cyan/dispatch.h>
+
+class trace_tests : public ::testing::Test {
+public:
+  void SetUp() {
+    cyan::trace::clear();
+  }
+
+  void TearDown() {
+    cyan::trace::disable();
+    cyan::trace::clear();
+  }
+};
+
+TEST_F(trace_tests, disabled_records_nothing) {
+  cyan::dispatch::handler_thread thread;
+  thread.post_awaitable([] {}).get();
+
+  std::ostringstream os;
+  cyan::trace::write_chrome_trace(os);
+  EXPECT_EQ(os.str().find("callable_message::process"), std::string::npos);
+}
+
+TEST_F(trace_tests, post_to_run_flow) {
+  cyan::trace::enable();
+  cyan::trace::set_thread_name("poster");
+
+  cyan::dispatch::handler_thread thread;
+  thread.post_awaitable([] {}).get();
+  // The slice is closed when process() returns; a second round trip
+  // guarantees the first one was recorded.
+  thread.post_awaitable([] {}).get();
+
+  std::ostringstream os;
+  cyan::trace::write_chrome_trace(os);
+  auto const json = os.str();
+
+  EXPECT_NE(json.find("\"name\":\"callable_message::process\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"s\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"f\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"poster\""), std::string::npos);
+}
+
+TEST_F(trace_tests, exited_threads_release_rings) {
+  // Named while disabled: no ring, nothing in the dump
+  std::thread{ [] { cyan::trace::set_thread_name("untraced"); } }.join();
+
+  cyan::trace::enable(64);
+  for (int i = 0; i < 40; i++) {
+    std::thread{ [] {
+      cyan::trace::set_thread_name("short-lived");
+      cyan::trace::instant("tick", "test");
+    } }.join();
+  }
+
+  std::ostringstream os;
+  cyan::trace::write_chrome_trace(os);
+  auto const json = os.str();
+
+  EXPECT_EQ(json.find("\"untraced\""), std::string::npos);
+  std::size_t named = 0;
+  for (auto at = json.find("\"short-lived\""); at != std::string::npos; at = json.find("\"short-lived\"", at + 1)) {
+    named++;
+  }
+  EXPECT_GT(named, 0u);
+  EXPECT_LE(named, 16u);
+}
+
+TEST_F(trace_tests, every_flow_ends) {
+  cyan::trace::enable();
+  {
+    cyan::dispatch::handler_thread thread;
+    thread.post_awaitable([] {}).get();
+    thread.stop();
+    thread.join();
+    // Dropped by the stopped thread
+    thread.post([] {});
+  }
+
+  std::ostringstream os;
+  cyan::trace::write_chrome_trace(os);
+  auto const json = os.str();
+
+  auto const count = [&](std::string const& needle) {
+    std::size_t n = 0;
+    for (auto at = json.find(needle); at != std::string::npos; at = json.find(needle, at + 1)) n++;
+    return n;
+  };
+  EXPECT_EQ(count("\"ph\":\"s\""), 2u);
+  EXPECT_EQ(count("\"ph\":\"f\""), 2u);
+  EXPECT_NE(json.find("\"name\":\"message::dropped\""), std::string::npos);
+}
+
+TEST_F(trace_tests, dump_while_recording) {
+  cyan::trace::enable(256);
+  std::atomic<bool> done{ false };
+
+  std::thread writer{ [&] {
+    while (!done.load()) {
+      cyan::trace::instant("a", "a");
+      cyan::trace::instant("b", "b");
+    }
+  } };
+
+  // Events are copied whole or not at all
+  for (int i = 0; i < 50; i++) {
+    std::ostringstream os;
+    cyan::trace::write_chrome_trace(os);
+    auto const json = os.str();
+    EXPECT_EQ(json.find("\"name\":\"a\",\"cat\":\"b\""), std::string::npos);
+    EXPECT_EQ(json.find("\"name\":\"b\",\"cat\":\"a\""), std::string::npos);
+  }
+
+  done = true;
+  writer.join();
+}
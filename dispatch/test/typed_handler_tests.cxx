@@ -0,0 +1,129 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+namespace {
+
+struct large_payload {
+  std::array<char, 256> data;
+};
+
+class recording_handler : public cyan::dispatch::typed_handler<int, std::string, std::unique_ptr<int>, large_payload> {
+public:
+  void on_message(int&& value) override {
+    ints.push_back(value);
+  }
+
+  void on_message(std::string&& value) override {
+    strings.push_back(std::move(value));
+  }
+
+  void on_message(std::unique_ptr<int>&& value) override {
+    pointers.push_back(*value);
+  }
+
+  void on_message(large_payload&& value) override {
+    large.push_back(value.data[0]);
+    done.set_value();
+  }
+
+  void on_error(std::exception& e) override {
+    errors.push_back(e.what());
+  }
+
+  std::vector<int> ints;
+  std::vector<std::string> strings;
+  std::vector<int> pointers;
+  std::vector<char> large;
+  std::vector<std::string> errors;
+  std::promise<void> done;
+};
+
+} // <anonymous>
+
+class typed_handler_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(typed_handler_tests, dispatch_by_type) {
+  recording_handler handler;
+  auto done = handler.done.get_future();
+
+  {
+    cyan::dispatch::typed_handler_thread<int, std::string, std::unique_ptr<int>, large_payload> thread{ handler };
+
+    thread.send(1);
+    thread.send(std::string{ "two" });
+    thread.send(std::make_unique<int>(3));
+    thread.send(2);
+
+    large_payload payload;
+    payload.data[0] = 'x';
+    thread.send(payload);
+
+    done.get();
+  }
+
+  EXPECT_EQ(handler.ints, (std::vector<int>{ 1, 2 }));
+  EXPECT_EQ(handler.strings, (std::vector<std::string>{ "two" }));
+  EXPECT_EQ(handler.pointers, (std::vector<int>{ 3 }));
+  EXPECT_EQ(handler.large, (std::vector<char>{ 'x' }));
+}
+
+TEST_F(typed_handler_tests, delayed_send) {
+  recording_handler handler;
+  auto done = handler.done.get_future();
+  cyan::dispatch::typed_handler_thread<int, std::string, std::unique_ptr<int>, large_payload> thread{ handler };
+
+  thread.send(large_payload{}, 1ms);
+  EXPECT_EQ(done.wait_for(5s), std::future_status::ready);
+}
+
+TEST_F(typed_handler_tests, untyped_send) {
+  recording_handler handler;
+  cyan::dispatch::typed_handler_thread<int, std::string, std::unique_ptr<int>, large_payload> thread{ handler };
+
+  // A payload sent through the base class skips the type check
+  cyan::dispatch::handler_thread& base = thread;
+  base.send(1.5);
+  thread.send(4);
+  thread.post_awaitable([] {}).get();
+
+  ASSERT_EQ(handler.errors.size(), 1u);
+  EXPECT_NE(handler.errors[0].find("untyped payload"), std::string::npos);
+  EXPECT_EQ(handler.ints, (std::vector<int>{ 4 }));
+}
@@ -0,0 +1,137 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <set>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cyan/dispatch.h>
+using namespace std::chrono_literals;
+
+class work_stealing_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(work_stealing_tests, standalone_thread_keeps_order) {
+  cyan::dispatch::handler_thread thread;
+  std::vector<int> order;
+  std::promise<void> done;
+
+  thread.post([&] {
+    thread.post([&] { order.push_back(1); });
+    thread.post([&] { order.push_back(2); done.set_value(); });
+  });
+  done.get_future().get();
+
+  EXPECT_EQ(order, (std::vector<int>{ 1, 2 }));
+}
+
+TEST_F(work_stealing_tests, last_post_runs_next) {
+  cyan::dispatch::thread_pool pool{ 1 };
+  std::vector<int> order;
+  std::promise<void> done;
+
+  pool.post([&] {
+    pool.post([&] { order.push_back(1); done.set_value(); });
+    pool.post([&] { order.push_back(2); });
+  });
+  done.get_future().get();
+
+  EXPECT_EQ(order, (std::vector<int>{ 2, 1 }));
+}
+
+TEST_F(work_stealing_tests, chain_stays_on_worker) {
+  cyan::dispatch::thread_pool pool{ 4 };
+  std::set<std::thread::id> ids;
+  std::promise<void> done;
+
+  std::function<void(int)> step = [&](int remaining) {
+    ids.insert(std::this_thread::get_id());
+    if (remaining) {
+      pool.post([&, remaining] { step(remaining - 1); });
+    } else {
+      done.set_value();
+    }
+  };
+
+  // Kept under max_lifo_runs: past that the slot is flushed and may be stolen
+  pool.post([&] { step(16); });
+  done.get_future().get();
+
+  EXPECT_EQ(ids.size(), 1u);
+}
+
+TEST_F(work_stealing_tests, backlog_is_stolen) {
+  constexpr int count = 50;
+  cyan::dispatch::thread_pool pool{ 2 };
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  std::atomic<int> remaining{ count };
+  std::promise<void> done;
+
+  pool.post([&] {
+    for (int i = 0; i < count; i++) {
+      pool.post([&] {
+        std::this_thread::sleep_for(1ms);
+        {
+          std::lock_guard<std::mutex> lock{ mutex };
+          ids.insert(std::this_thread::get_id());
+        }
+        if (--remaining == 0) done.set_value();
+      });
+    }
+  });
+  done.get_future().get();
+
+  EXPECT_EQ(ids.size(), 2u);
+  EXPECT_GT(pool.get_statistics().stolen, 0u);
+  EXPECT_EQ(pool.get_statistics().queue_depth(), 0u);
+}
+
+TEST_F(work_stealing_tests, awaitable_post_from_worker) {
+  cyan::dispatch::thread_pool pool{ 2 };
+
+  auto result = pool.post_awaitable([&] {
+    return pool.post_awaitable([] { return 42; }).get();
+  });
+  ASSERT_EQ(result.wait_for(1s), std::future_status::ready);
+  EXPECT_EQ(result.get(), 42);
+
+  // Work already in the LIFO slot is handed over too
+  auto chained = pool.post_awaitable([&] {
+    std::promise<int> value;
+    auto future = value.get_future();
+    pool.post([&] { value.set_value(7); });
+    return pool.post_awaitable([&] { return future.get(); }).get();
+  });
+  ASSERT_EQ(chained.wait_for(1s), std::future_status::ready);
+  EXPECT_EQ(chained.get(), 7);
+}
@@ -50,12 +50,21 @@ std::shared_ptr<event::loop> get_main_loop() {
   return loop;
 }
 
-template class basic_loop<default_backend_traits>;
-template class basic_async<default_backend_traits>;
-template class basic_idle<default_backend_traits>;
-template class basic_timer<default_backend_traits>;
-template class basic_timer_wheel<default_backend_traits>;
-template class basic_io<default_backend_traits>;
+template class basic_loop<backend_traits<backend::libev>>;
+template class basic_async<backend_traits<backend::libev>>;
+template class basic_idle<backend_traits<backend::libev>>;
+template class basic_timer<backend_traits<backend::libev>>;
+template class basic_timer_wheel<backend_traits<backend::libev>>;
+template class basic_io<backend_traits<backend::libev>>;
+
+#ifdef CYAN_EVENT_HAVE_EPOLL
+template class basic_loop<backend_traits<backend::epoll>>;
+template class basic_async<backend_traits<backend::epoll>>;
+template class basic_idle<backend_traits<backend::epoll>>;
+template class basic_timer<backend_traits<backend::epoll>>;
+template class basic_timer_wheel<backend_traits<backend::epoll>>;
+template class basic_io<backend_traits<backend::epoll>>;
+#endif // CYAN_EVENT_HAVE_EPOLL
 
 } // v1
 } // cyan::event
@@ -78,5 +87,17 @@ std::shared_ptr<event::loop> get_event_loop() {
   return loop;
 }
 
+#ifdef CYAN_EVENT_HAVE_IO_URING
+std::shared_ptr<event::io_ring> get_io_ring() {
+  static thread_local std::shared_ptr<event::io_ring> ring;
+
+  if (!ring) {
+    ring = std::make_shared<event::io_ring>(get_event_loop());
+  }
+
+  return ring;
+}
+#endif // CYAN_EVENT_HAVE_IO_URING
+
 } // v1
 } // cyan::this_thread
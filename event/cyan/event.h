@@ -24,6 +24,7 @@
 #pragma once
 
 #include <cyan/event/backend_libev.h>
+#include <cyan/event/backend_epoll.h>
 #include <cyan/event/basic_loop.h>
 #include <cyan/event/basic_async.h>
 #include <cyan/event/basic_timer.h>
@@ -31,11 +32,16 @@
 #include <cyan/event/basic_signal.h>
 #include <cyan/event/basic_idle.h>
 #include <cyan/event/basic_io.h>
+#include <cyan/event/basic_io_ring.h>
 
 namespace cyan::event {
 inline namespace v1 {
 
+#if defined(CYAN_EVENT_BACKEND_EPOLL) && defined(CYAN_EVENT_HAVE_EPOLL)
+using default_backend_traits = backend_traits<backend::epoll>;
+#else
 using default_backend_traits = backend_traits<backend::libev>;
+#endif
 
 using loop = basic_loop<default_backend_traits>;
 using async = basic_async<default_backend_traits>;
@@ -44,6 +50,9 @@ using timer_wheel = basic_timer_wheel<default_backend_traits>;
 using signal = basic_signal<default_backend_traits>;
 using idle = basic_idle<default_backend_traits>;
 using io = basic_io<default_backend_traits>;
+#ifdef CYAN_EVENT_HAVE_IO_URING
+using io_ring = basic_io_ring<default_backend_traits>;
+#endif // CYAN_EVENT_HAVE_IO_URING
 
 std::shared_ptr<loop> get_main_loop();
 
@@ -54,6 +63,9 @@ namespace cyan::this_thread {
 inline namespace v1 {
 
 std::shared_ptr<event::loop> get_event_loop();
+#ifdef CYAN_EVENT_HAVE_IO_URING
+std::shared_ptr<event::io_ring> get_io_ring();
+#endif // CYAN_EVENT_HAVE_IO_URING
 
 }
 }
@@ -23,9 +23,12 @@
  **/
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <chrono>
 
+#include <cyan/event/loop_monitor.h>
+
 namespace cyan::event {
 
 struct native_handle_types {
@@ -59,6 +62,13 @@ struct backend_traits {
 
     static void stop(native_handle_type) noexcept {
     }
+
+    static std::size_t iterate(native_handle_type, std::chrono::nanoseconds) noexcept {
+      return 0;
+    }
+
+    static void set_monitor(native_handle_type, detail::loop_monitor*) noexcept {
+    }
   };
 
   struct async {
@@ -84,6 +94,10 @@ struct backend_traits {
     static void set_callback(native_handle_type, callback_type const&&) noexcept {
     }
 
+    template<auto Method, typename U>
+    static void set_callback(native_handle_type, U*) noexcept {
+    }
+
     static bool is_active(native_handle_type) noexcept {
       return false;
     }
@@ -117,12 +131,19 @@ struct backend_traits {
     static void set_timeout(native_handle_type, std::chrono::duration<U, V> const&) noexcept {
     }
 
-    static std::chrono::milliseconds get_timeout(native_handle_type) noexcept {
+    static void arm(typename loop::native_handle_type, native_handle_type, std::chrono::nanoseconds const&) noexcept {
+    }
+
+    static std::chrono::nanoseconds get_timeout(native_handle_type) noexcept {
     }
 
     static void set_callback(native_handle_type, callback_type const&&) noexcept {
     }
 
+    template<auto Method, typename U>
+    static void set_callback(native_handle_type, U*) noexcept {
+    }
+
     static bool is_active(native_handle_type) noexcept {
       return false;
     }
@@ -159,6 +180,10 @@ struct backend_traits {
     static void set_callback(native_handle_type, callback_type const&&) noexcept {
     }
 
+    template<auto Method, typename U>
+    static void set_callback(native_handle_type, U*) noexcept {
+    }
+
     static bool is_active(native_handle_type) noexcept {
       return false;
     }
@@ -188,6 +213,10 @@ struct backend_traits {
     static void set_callback(native_handle_type, callback_type const&&) noexcept {
     }
 
+    template<auto Method, typename U>
+    static void set_callback(native_handle_type, U*) noexcept {
+    }
+
     static bool is_active(native_handle_type) noexcept {
       return false;
     }
@@ -228,6 +257,10 @@ struct backend_traits {
     static void set_callback(native_handle_type, callback_type const&&) noexcept {
     }
 
+    template<auto Method, typename U>
+    static void set_callback(native_handle_type, U*) noexcept {
+    }
+
     static bool is_active(native_handle_type) noexcept {
       return false;
     }
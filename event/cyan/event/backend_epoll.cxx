@@ -0,0 +1,836 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/event/backend_epoll.h>
+
+#ifdef CYAN_EVENT_HAVE_EPOLL
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <csignal>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <typeinfo>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+namespace cyan::event {
+
+namespace detail::epoll {
+
+using clock = std::chrono::steady_clock;
+
+enum class kind : std::uint8_t {
+  async,
+  timer,
+  signal,
+  idle,
+  io
+};
+
+struct watcher {
+  explicit watcher(kind type) noexcept : type{ type } {}
+
+  loop_state* loop = nullptr;
+  kind const type;
+  bool active = false;
+  bool pending = false;
+  // Set when a member function is bound instead of a callback
+  member_callback_type member_callback = nullptr;
+  void* object = nullptr;
+  // Type of the callback otherwise, to tell callbacks apart in reports
+  std::type_info const* callable = nullptr;
+};
+
+struct async_watcher : public watcher {
+  async_watcher() noexcept : watcher{ kind::async } {}
+
+  std::atomic<bool> sent{ false };
+  std::function<void()> callback;
+};
+
+struct timer_watcher : public watcher {
+  timer_watcher() noexcept : watcher{ kind::timer } {}
+
+  clock::time_point at;
+  std::chrono::nanoseconds repeat{ 0 };
+  std::size_t heap_index = 0;
+  std::function<void()> callback;
+};
+
+struct signal_watcher : public watcher {
+  signal_watcher() noexcept : watcher{ kind::signal } {}
+
+  std::int32_t signum = SIGINT;
+  std::function<void()> callback;
+};
+
+struct idle_watcher : public watcher {
+  idle_watcher() noexcept : watcher{ kind::idle } {}
+
+  std::function<void()> callback;
+};
+
+struct io_watcher : public watcher {
+  io_watcher() noexcept : watcher{ kind::io } {}
+
+  std::int32_t fd = -1;
+  std::int32_t events = 0;
+  std::function<void(std::int32_t)> callback;
+};
+
+struct pending_event {
+  watcher* target;
+  std::int32_t revents;
+};
+
+struct loop_state {
+  int epfd = -1;
+  int wakefd = -1;
+  int timerfd = -1;
+  std::atomic<bool> stopping{ false };
+  std::atomic<bool> woken{ false };
+  loop_monitor* monitor = nullptr;
+  clock::time_point armed = clock::time_point::max();
+  // Min-heap on expiry
+  std::vector<timer_watcher*> timers;
+  std::vector<async_watcher*> asyncs;
+  std::vector<signal_watcher*> signals;
+  std::vector<idle_watcher*> idles;
+  // Callbacks of the iteration being dispatched
+  std::vector<pending_event> pending;
+  std::array<::epoll_event, 256> events;
+};
+
+namespace {
+
+using io_traits = backend_traits<backend::epoll>::io;
+
+void wake(loop_state* loop) noexcept {
+  if (loop->woken.exchange(true)) return;
+  std::uint64_t one = 1;
+  [[maybe_unused]] auto rc = ::write(loop->wakefd, &one, sizeof(one));
+}
+
+void push(loop_state* loop, watcher* target, std::int32_t revents = 0) {
+  target->pending = true;
+  loop->pending.push_back({ target, revents });
+}
+
+// Signal dispositions are process wide, and a signal may be delivered to any
+// thread that does not block it. As in libev, one handler marks the signal
+// caught and wakes the loop watching it, so no thread has to block anything.
+// A signal is watched by one loop at a time.
+struct signal_slot {
+  std::atomic<loop_state*> loop{ nullptr };
+  std::atomic<bool> caught{ false };
+};
+
+std::array<signal_slot, NSIG> signal_slots;
+
+void on_signal(int signum) noexcept {
+  auto const saved = errno;
+  auto& slot = signal_slots[signum];
+  slot.caught.store(true);
+  if (auto* loop = slot.loop.load()) wake(loop);
+  errno = saved;
+}
+
+void collect_signals(loop_state* loop) {
+  for (int signum = 1; signum < NSIG; signum++) {
+    auto& slot = signal_slots[signum];
+    if (slot.loop.load() != loop || !slot.caught.exchange(false)) continue;
+    for (auto* signal : loop->signals) {
+      if (signal->signum == signum) push(loop, signal);
+    }
+  }
+}
+
+// A watcher stopped while its callback is queued must not be called, nor
+// touched if it is destroyed
+void forget(watcher* target) noexcept {
+  if (!target->pending) return;
+  target->pending = false;
+  for (auto& event : target->loop->pending) {
+    if (event.target == target) event.target = nullptr;
+  }
+}
+
+template<typename W>
+void erase(std::vector<W*>& watchers, W* target) noexcept {
+  watchers.erase(std::remove(watchers.begin(), watchers.end(), target), watchers.end());
+}
+
+void sift_up(std::vector<timer_watcher*>& heap, std::size_t i) noexcept {
+  auto* timer = heap[i];
+  while (i) {
+    auto const parent = (i - 1) / 2;
+    if (heap[parent]->at <= timer->at) break;
+    heap[i] = heap[parent];
+    heap[i]->heap_index = i;
+    i = parent;
+  }
+  heap[i] = timer;
+  timer->heap_index = i;
+}
+
+void sift_down(std::vector<timer_watcher*>& heap, std::size_t i) noexcept {
+  auto* timer = heap[i];
+  for (;;) {
+    auto child = 2 * i + 1;
+    if (child >= heap.size()) break;
+    if (child + 1 < heap.size() && heap[child + 1]->at < heap[child]->at) child++;
+    if (timer->at <= heap[child]->at) break;
+    heap[i] = heap[child];
+    heap[i]->heap_index = i;
+    i = child;
+  }
+  heap[i] = timer;
+  timer->heap_index = i;
+}
+
+void schedule(loop_state* loop, timer_watcher* timer) {
+  if (timer->active) {
+    sift_up(loop->timers, timer->heap_index);
+    sift_down(loop->timers, timer->heap_index);
+    return;
+  }
+
+  timer->loop = loop;
+  timer->active = true;
+  timer->heap_index = loop->timers.size();
+  loop->timers.push_back(timer);
+  sift_up(loop->timers, timer->heap_index);
+}
+
+void unschedule(timer_watcher* timer) noexcept {
+  auto& heap = timer->loop->timers;
+  auto const i = timer->heap_index;
+  timer->active = false;
+  heap[i] = heap.back();
+  heap[i]->heap_index = i;
+  heap.pop_back();
+  if (i < heap.size()) {
+    sift_up(heap, i);
+    sift_down(heap, heap[i]->heap_index);
+  }
+}
+
+void arm_timerfd(loop_state* loop) noexcept {
+  if (loop->timers.empty() || loop->timers.front()->at == loop->armed) return;
+
+  loop->armed = loop->timers.front()->at;
+  auto const since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(loop->armed.time_since_epoch());
+  ::itimerspec spec{};
+  spec.it_value.tv_sec = since_epoch.count() / 1000000000;
+  spec.it_value.tv_nsec = since_epoch.count() % 1000000000;
+  // An expiry at the epoch itself would disarm the timerfd
+  if (!spec.it_value.tv_sec && !spec.it_value.tv_nsec) spec.it_value.tv_nsec = 1;
+  ::timerfd_settime(loop->timerfd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+std::uint32_t to_epoll(std::int32_t events) noexcept {
+  std::uint32_t result = 0;
+  if (events & io_traits::event_read) result |= EPOLLIN | EPOLLRDHUP;
+  if (events & io_traits::event_write) result |= EPOLLOUT;
+  if (events & io_traits::event_edge) result |= EPOLLET;
+  return result;
+}
+
+std::int32_t from_epoll(std::uint32_t events, std::int32_t wanted) noexcept {
+  std::int32_t result = 0;
+  if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) result |= io_traits::event_read;
+  if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) result |= io_traits::event_write;
+  result &= wanted;
+  if (events & EPOLLERR) result |= io_traits::event_error;
+  return result;
+}
+
+void collect(loop_state* loop, int count) {
+  for (int i = 0; i < count; i++) {
+    auto const& event = loop->events[i];
+    if (event.data.ptr == &loop->wakefd) {
+      std::uint64_t value;
+      [[maybe_unused]] auto rc = ::read(loop->wakefd, &value, sizeof(value));
+      loop->woken.store(false);
+      for (auto* async : loop->asyncs) {
+        if (async->sent.exchange(false)) push(loop, async);
+      }
+      if (!loop->signals.empty()) collect_signals(loop);
+    } else if (event.data.ptr == &loop->timerfd) {
+      std::uint64_t expirations;
+      [[maybe_unused]] auto rc = ::read(loop->timerfd, &expirations, sizeof(expirations));
+      loop->armed = clock::time_point::max();
+    } else {
+      auto* io = static_cast<io_watcher*>(event.data.ptr);
+      if (auto const revents = from_epoll(event.events, io->events)) push(loop, io, revents);
+    }
+  }
+
+  // Due timers are expired even when the timerfd has not been read yet
+  if (!loop->timers.empty()) {
+    auto const now = clock::now();
+    while (!loop->timers.empty() && loop->timers.front()->at <= now) {
+      auto* timer = loop->timers.front();
+      if (timer->repeat.count() > 0) {
+        timer->at += timer->repeat;
+        if (timer->at <= now) timer->at = now + timer->repeat;
+        sift_down(loop->timers, 0);
+      } else {
+        unschedule(timer);
+      }
+      push(loop, timer);
+    }
+  }
+
+  if (loop->pending.empty()) {
+    for (auto* idle : loop->idles) push(loop, idle);
+  }
+}
+
+void invoke(pending_event const& event) noexcept {
+  if (event.target->member_callback) {
+    event.target->member_callback(event.target->object, event.revents);
+    return;
+  }
+
+  switch (event.target->type) {
+  case kind::async:
+    if (auto& callback = static_cast<async_watcher*>(event.target)->callback) callback();
+    break;
+  case kind::timer:
+    if (auto& callback = static_cast<timer_watcher*>(event.target)->callback) callback();
+    break;
+  case kind::signal:
+    if (auto& callback = static_cast<signal_watcher*>(event.target)->callback) callback();
+    break;
+  case kind::idle:
+    if (auto& callback = static_cast<idle_watcher*>(event.target)->callback) callback();
+    break;
+  case kind::io:
+    if (auto& callback = static_cast<io_watcher*>(event.target)->callback) callback(event.revents);
+    break;
+  }
+}
+
+std::size_t dispatch(loop_state* loop) noexcept {
+  std::size_t count = 0;
+
+  // Indexed, as nothing is appended while dispatching but entries of
+  // stopped watchers are cleared
+  for (std::size_t i = 0; i < loop->pending.size(); i++) {
+    auto const event = loop->pending[i];
+    if (!event.target) continue;
+    event.target->pending = false;
+    count++;
+
+    if (!loop->monitor) {
+      invoke(event);
+      continue;
+    }
+
+    auto const begin = loop->monitor->callback_begin(event.target,
+          reinterpret_cast<void const*>(event.target->member_callback), event.target->callable);
+    invoke(event);
+    loop->monitor->callback_done(begin);
+  }
+  loop->pending.clear();
+  return count;
+}
+
+} // namespace
+
+// One pass: waits up to `timeout` milliseconds for events, forever if it is
+// negative and not at all while idle watchers are active, then runs the
+// callbacks that became due and returns their count
+std::size_t iterate(loop_state* loop, int timeout) {
+  arm_timerfd(loop);
+
+  if (!loop->idles.empty()) timeout = 0;
+  if (loop->monitor) loop->monitor->poll_begin();
+  auto count = ::epoll_wait(loop->epfd, loop->events.data(), static_cast<int>(loop->events.size()), timeout);
+  if (loop->monitor) loop->monitor->poll_end();
+  if (count < 0) count = 0;
+
+  collect(loop, count);
+  return dispatch(loop);
+}
+
+} // detail::epoll
+
+using namespace detail::epoll;
+
+backend_traits<backend::epoll>::loop::native_handle_type
+backend_traits<backend::epoll>::loop::allocate() {
+  auto loop = new loop_state;
+  loop->epfd = ::epoll_create1(EPOLL_CLOEXEC);
+  loop->wakefd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  loop->timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  assert(loop->epfd >= 0 && loop->wakefd >= 0 && loop->timerfd >= 0 && "failed to allocate loop handle");
+
+  ::epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.ptr = &loop->wakefd;
+  ::epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wakefd, &event);
+  event.data.ptr = &loop->timerfd;
+  ::epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->timerfd, &event);
+
+  return loop;
+}
+
+void
+backend_traits<backend::epoll>::loop::deallocate(native_handle_type loop) {
+  for (auto fd : { loop->timerfd, loop->wakefd, loop->epfd }) {
+    if (fd >= 0) ::close(fd);
+  }
+  delete loop;
+}
+
+void
+backend_traits<backend::epoll>::loop::start(native_handle_type loop) noexcept {
+  // Like ev_run, a stop requested before the loop started is discarded
+  loop->stopping.store(false, std::memory_order_relaxed);
+  while (!loop->stopping.load(std::memory_order_acquire)) detail::epoll::iterate(loop, -1);
+}
+
+void
+backend_traits<backend::epoll>::loop::stop(native_handle_type loop) noexcept {
+  loop->stopping.store(true, std::memory_order_release);
+  wake(loop);
+}
+
+std::size_t
+backend_traits<backend::epoll>::loop::iterate(native_handle_type loop, std::chrono::nanoseconds timeout) noexcept {
+  if (timeout == std::chrono::nanoseconds::max()) {
+    return detail::epoll::iterate(loop, -1);
+  }
+
+  // epoll_wait counts in milliseconds; rounded up, so as not to return early
+  auto const ms = std::chrono::ceil<std::chrono::milliseconds>(std::max(timeout, std::chrono::nanoseconds::zero()));
+  return detail::epoll::iterate(loop, static_cast<int>(std::min<std::chrono::milliseconds::rep>(ms.count(),
+        std::numeric_limits<int>::max())));
+}
+
+void
+backend_traits<backend::epoll>::loop::set_monitor(native_handle_type loop, detail::loop_monitor* monitor) noexcept {
+  loop->monitor = monitor;
+}
+
+backend_traits<backend::epoll>::async::native_handle_type
+backend_traits<backend::epoll>::async::allocate() {
+  return new async_watcher;
+}
+
+void
+backend_traits<backend::epoll>::async::deallocate(native_handle_type native_handle) {
+  delete native_handle;
+}
+
+void
+backend_traits<backend::epoll>::async::start(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle) noexcept {
+  if (native_handle->active) return;
+  native_handle->loop = native_loop_handle;
+  native_handle->active = true;
+  native_loop_handle->asyncs.push_back(native_handle);
+  // A send that raced with start is delivered
+  if (native_handle->sent.load()) {
+    native_handle->sent.store(false);
+    send(native_loop_handle, native_handle);
+  }
+}
+
+void
+backend_traits<backend::epoll>::async::stop(typename loop::native_handle_type,
+      native_handle_type native_handle) noexcept {
+  if (!native_handle->active) return;
+  native_handle->active = false;
+  erase(native_handle->loop->asyncs, native_handle);
+  forget(native_handle);
+}
+
+void
+backend_traits<backend::epoll>::async::send(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle) noexcept {
+  if (!native_handle->sent.exchange(true)) wake(native_loop_handle);
+}
+
+bool
+backend_traits<backend::epoll>::async::is_active(native_handle_type native_handle) noexcept {
+  return native_handle->active;
+}
+
+bool
+backend_traits<backend::epoll>::async::is_pending(native_handle_type native_handle) noexcept {
+  return native_handle->sent.load(std::memory_order_relaxed);
+}
+
+void
+backend_traits<backend::epoll>::async::set_callback(native_handle_type native_handle,
+      callback_type&& callback) noexcept {
+  native_handle->callback = std::move(callback);
+  native_handle->member_callback = nullptr;
+  native_handle->callable = native_handle->callback ? &native_handle->callback.target_type() : nullptr;
+}
+
+void
+backend_traits<backend::epoll>::async::bind(native_handle_type native_handle, void* object,
+      member_callback_type callback) noexcept {
+  native_handle->callback = nullptr;
+  native_handle->member_callback = callback;
+  native_handle->callable = nullptr;
+  native_handle->object = object;
+}
+
+backend_traits<backend::epoll>::timer::native_handle_type
+backend_traits<backend::epoll>::timer::allocate() {
+  return new timer_watcher;
+}
+
+void
+backend_traits<backend::epoll>::timer::deallocate(native_handle_type native_handle) {
+  delete native_handle;
+}
+
+void
+backend_traits<backend::epoll>::timer::start(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle) noexcept {
+  // Same as ev_timer_again: (re)starts a repeating timer, stops a one-shot
+  if (native_handle->repeat.count() <= 0) {
+    stop(native_loop_handle, native_handle);
+    return;
+  }
+  native_handle->at = clock::now() + native_handle->repeat;
+  schedule(native_loop_handle, native_handle);
+}
+
+void
+backend_traits<backend::epoll>::timer::reset(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle) noexcept {
+  start(native_loop_handle, native_handle);
+}
+
+void
+backend_traits<backend::epoll>::timer::stop(typename loop::native_handle_type,
+      native_handle_type native_handle) noexcept {
+  if (native_handle->active) unschedule(native_handle);
+  if (native_handle->loop) forget(native_handle);
+}
+
+void
+backend_traits<backend::epoll>::timer::arm(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle, std::chrono::nanoseconds const& after) noexcept {
+  native_handle->repeat = std::chrono::nanoseconds::zero();
+  native_handle->at = clock::now() + std::max(after, std::chrono::nanoseconds::zero());
+  schedule(native_loop_handle, native_handle);
+}
+
+bool
+backend_traits<backend::epoll>::timer::is_active(native_handle_type native_handle) noexcept {
+  return native_handle->active;
+}
+
+bool
+backend_traits<backend::epoll>::timer::is_pending(native_handle_type native_handle) noexcept {
+  return native_handle->pending;
+}
+
+std::chrono::nanoseconds
+backend_traits<backend::epoll>::timer::get_timeout(native_handle_type native_handle) noexcept {
+  return native_handle->repeat;
+}
+
+void
+backend_traits<backend::epoll>::timer::set_repeat(native_handle_type native_handle,
+      std::chrono::nanoseconds const& repeat) noexcept {
+  native_handle->repeat = repeat;
+}
+
+void
+backend_traits<backend::epoll>::timer::set_callback(native_handle_type native_handle,
+      callback_type&& callback) noexcept {
+  native_handle->callback = std::move(callback);
+  native_handle->member_callback = nullptr;
+  native_handle->callable = native_handle->callback ? &native_handle->callback.target_type() : nullptr;
+}
+
+void
+backend_traits<backend::epoll>::timer::bind(native_handle_type native_handle, void* object,
+      member_callback_type callback) noexcept {
+  native_handle->callback = nullptr;
+  native_handle->member_callback = callback;
+  native_handle->callable = nullptr;
+  native_handle->object = object;
+}
+
+backend_traits<backend::epoll>::signal::native_handle_type
+backend_traits<backend::epoll>::signal::allocate() {
+  return new signal_watcher;
+}
+
+void
+backend_traits<backend::epoll>::signal::deallocate(native_handle_type native_handle) {
+  delete native_handle;
+}
+
+void
+backend_traits<backend::epoll>::signal::start(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle) noexcept {
+  if (native_handle->active) return;
+  native_handle->loop = native_loop_handle;
+  native_handle->active = true;
+  native_loop_handle->signals.push_back(native_handle);
+
+  auto& slot = signal_slots[native_handle->signum];
+  loop_state* watching = nullptr;
+  if (!slot.loop.compare_exchange_strong(watching, native_loop_handle)) {
+    assert(watching == native_loop_handle && "signal: already watched by another loop");
+    return;
+  }
+
+  struct sigaction action{};
+  action.sa_handler = on_signal;
+  action.sa_flags = SA_RESTART;
+  ::sigfillset(&action.sa_mask);
+  ::sigaction(native_handle->signum, &action, nullptr);
+}
+
+void
+backend_traits<backend::epoll>::signal::stop(typename loop::native_handle_type,
+      native_handle_type native_handle) noexcept {
+  if (!native_handle->active) return;
+  auto* loop = native_handle->loop;
+  native_handle->active = false;
+  erase(loop->signals, native_handle);
+  forget(native_handle);
+
+  auto const watched = std::any_of(loop->signals.begin(), loop->signals.end(),
+        [signum = native_handle->signum] (auto* signal) { return signal->signum == signum; });
+  auto& slot = signal_slots[native_handle->signum];
+  if (watched || slot.loop.load() != loop) return;
+
+  struct sigaction action{};
+  action.sa_handler = SIG_DFL;
+  ::sigemptyset(&action.sa_mask);
+  ::sigaction(native_handle->signum, &action, nullptr);
+  slot.caught.store(false);
+  slot.loop.store(nullptr);
+}
+
+void
+backend_traits<backend::epoll>::signal::set_number(native_handle_type native_handle,
+      std::int32_t signum) noexcept {
+  native_handle->signum = signum;
+}
+
+std::int32_t
+backend_traits<backend::epoll>::signal::get_number(native_handle_type native_handle) noexcept {
+  return native_handle->signum;
+}
+
+bool
+backend_traits<backend::epoll>::signal::is_active(native_handle_type native_handle) noexcept {
+  return native_handle->active;
+}
+
+bool
+backend_traits<backend::epoll>::signal::is_pending(native_handle_type native_handle) noexcept {
+  return native_handle->pending;
+}
+
+void
+backend_traits<backend::epoll>::signal::set_callback(native_handle_type native_handle,
+      callback_type&& callback) noexcept {
+  native_handle->callback = std::move(callback);
+  native_handle->member_callback = nullptr;
+  native_handle->callable = native_handle->callback ? &native_handle->callback.target_type() : nullptr;
+}
+
+void
+backend_traits<backend::epoll>::signal::bind(native_handle_type native_handle, void* object,
+      member_callback_type callback) noexcept {
+  native_handle->callback = nullptr;
+  native_handle->member_callback = callback;
+  native_handle->callable = nullptr;
+  native_handle->object = object;
+}
+
+backend_traits<backend::epoll>::idle::native_handle_type
+backend_traits<backend::epoll>::idle::allocate() {
+  return new idle_watcher;
+}
+
+void
+backend_traits<backend::epoll>::idle::deallocate(native_handle_type native_handle) {
+  delete native_handle;
+}
+
+void
+backend_traits<backend::epoll>::idle::start(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle) noexcept {
+  if (native_handle->active) return;
+  native_handle->loop = native_loop_handle;
+  native_handle->active = true;
+  native_loop_handle->idles.push_back(native_handle);
+}
+
+void
+backend_traits<backend::epoll>::idle::stop(typename loop::native_handle_type,
+      native_handle_type native_handle) noexcept {
+  if (!native_handle->active) return;
+  native_handle->active = false;
+  erase(native_handle->loop->idles, native_handle);
+  forget(native_handle);
+}
+
+bool
+backend_traits<backend::epoll>::idle::is_active(native_handle_type native_handle) noexcept {
+  return native_handle->active;
+}
+
+bool
+backend_traits<backend::epoll>::idle::is_pending(native_handle_type native_handle) noexcept {
+  return native_handle->pending;
+}
+
+void
+backend_traits<backend::epoll>::idle::set_callback(native_handle_type native_handle,
+      callback_type&& callback) noexcept {
+  native_handle->callback = std::move(callback);
+  native_handle->member_callback = nullptr;
+  native_handle->callable = native_handle->callback ? &native_handle->callback.target_type() : nullptr;
+}
+
+void
+backend_traits<backend::epoll>::idle::bind(native_handle_type native_handle, void* object,
+      member_callback_type callback) noexcept {
+  native_handle->callback = nullptr;
+  native_handle->member_callback = callback;
+  native_handle->callable = nullptr;
+  native_handle->object = object;
+}
+
+backend_traits<backend::epoll>::io::native_handle_type
+backend_traits<backend::epoll>::io::allocate() {
+  return new io_watcher;
+}
+
+void
+backend_traits<backend::epoll>::io::deallocate(native_handle_type native_handle) {
+  delete native_handle;
+}
+
+void
+backend_traits<backend::epoll>::io::start(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle) noexcept {
+  if (native_handle->active) return;
+  native_handle->loop = native_loop_handle;
+  native_handle->active = true;
+
+  ::epoll_event event{};
+  event.events = to_epoll(native_handle->events);
+  event.data.ptr = native_handle;
+  if (::epoll_ctl(native_loop_handle->epfd, EPOLL_CTL_ADD, native_handle->fd, &event) < 0 && errno == EEXIST) {
+    ::epoll_ctl(native_loop_handle->epfd, EPOLL_CTL_MOD, native_handle->fd, &event);
+  }
+}
+
+void
+backend_traits<backend::epoll>::io::stop(typename loop::native_handle_type,
+      native_handle_type native_handle) noexcept {
+  if (!native_handle->active) return;
+  native_handle->active = false;
+  // Fails harmlessly when the fd was closed first, which removes it
+  ::epoll_ctl(native_handle->loop->epfd, EPOLL_CTL_DEL, native_handle->fd, nullptr);
+  forget(native_handle);
+}
+
+bool
+backend_traits<backend::epoll>::io::is_active(native_handle_type native_handle) noexcept {
+  return native_handle->active;
+}
+
+bool
+backend_traits<backend::epoll>::io::is_pending(native_handle_type native_handle) noexcept {
+  return native_handle->pending;
+}
+
+void
+backend_traits<backend::epoll>::io::set_file_descriptor(native_handle_type native_handle, std::int32_t fd) noexcept {
+  if (native_handle->active) {
+    auto* loop = native_handle->loop;
+    stop(loop, native_handle);
+    native_handle->fd = fd;
+    start(loop, native_handle);
+  } else {
+    native_handle->fd = fd;
+  }
+}
+
+std::int32_t
+backend_traits<backend::epoll>::io::get_file_descriptor(native_handle_type native_handle) noexcept {
+  return native_handle->fd;
+}
+
+void
+backend_traits<backend::epoll>::io::set_event_flags(native_handle_type native_handle, event_flags ev) noexcept {
+  native_handle->events = ev;
+  if (!native_handle->active) return;
+
+  ::epoll_event event{};
+  event.events = to_epoll(ev);
+  event.data.ptr = native_handle;
+  ::epoll_ctl(native_handle->loop->epfd, EPOLL_CTL_MOD, native_handle->fd, &event);
+}
+
+backend_traits<backend::epoll>::io::event_flags
+backend_traits<backend::epoll>::io::get_event_flags(native_handle_type native_handle) noexcept {
+  return native_handle->events;
+}
+
+void
+backend_traits<backend::epoll>::io::set_callback(native_handle_type native_handle,
+      callback_type&& callback) noexcept {
+  native_handle->callback = std::move(callback);
+  native_handle->member_callback = nullptr;
+  native_handle->callable = native_handle->callback ? &native_handle->callback.target_type() : nullptr;
+}
+
+void
+backend_traits<backend::epoll>::io::bind(native_handle_type native_handle, void* object,
+      member_callback_type callback) noexcept {
+  native_handle->callback = nullptr;
+  native_handle->member_callback = callback;
+  native_handle->callable = nullptr;
+  native_handle->object = object;
+}
+
+} // cyan::event
+
+#endif // CYAN_EVENT_HAVE_EPOLL
@@ -0,0 +1,226 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include <cyan/config.h>
+#include <cyan/event/backend.h>
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_EVENTFD_H) && \
+    defined(HAVE_SYS_TIMERFD_H) && defined(HAVE_SYS_SIGNALFD_H)
+#define CYAN_EVENT_HAVE_EPOLL 1
+#endif
+
+#ifdef CYAN_EVENT_HAVE_EPOLL
+
+namespace cyan::event {
+
+namespace backend {
+
+struct epoll {};
+
+} // backend
+
+namespace detail::epoll {
+
+struct loop_state;
+struct async_watcher;
+struct timer_watcher;
+struct signal_watcher;
+struct idle_watcher;
+struct io_watcher;
+
+using member_callback_type = void (*)(void* object, std::int32_t revents);
+
+} // detail::epoll
+
+// Linux-native backend: io watchers sit directly in one epoll set, timers on
+// a heap behind a single timerfd, and asyncs and signals share an eventfd.
+// Events are collected with batched epoll_wait calls and dispatched in
+// order; a watcher stopped mid-batch is skipped. An fd can be watched by one
+// io watcher at a time, and a signal by one loop at a time.
+template<>
+struct backend_traits<backend::epoll> {
+  struct loop {
+    using native_handle_type = detail::epoll::loop_state*;
+
+    static native_handle_type allocate();
+    static void deallocate(native_handle_type loop);
+    static void start(native_handle_type loop) noexcept;
+    static void stop(native_handle_type loop) noexcept;
+    // One pass, waiting up to `timeout` for events, without limit if it is
+    // nanoseconds::max(); returns the callbacks run
+    static std::size_t iterate(native_handle_type loop, std::chrono::nanoseconds timeout) noexcept;
+    static void set_monitor(native_handle_type loop, detail::loop_monitor* monitor) noexcept;
+  };
+
+  struct async {
+  public:
+    using native_handle_type = detail::epoll::async_watcher*;
+    using callback_type = std::function<void()>;
+
+    static native_handle_type allocate();
+    static void deallocate(native_handle_type native_handle);
+    static void start(typename loop::native_handle_type loop, native_handle_type native_handle) noexcept;
+    static void stop(typename loop::native_handle_type loop, native_handle_type native_handle) noexcept;
+    static void send(typename loop::native_handle_type loop, native_handle_type native_handle) noexcept;
+    static bool is_active(native_handle_type native_handle) noexcept;
+    static bool is_pending(native_handle_type) noexcept;
+    static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
+
+    // Binds `Method` of `object`, called directly from the dispatch loop
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      bind(native_handle, object, [] (void* target, std::int32_t) { (static_cast<T*>(target)->*Method)(); });
+    }
+
+  private:
+    static void bind(native_handle_type native_handle, void* object,
+          detail::epoll::member_callback_type callback) noexcept;
+  };
+
+  struct timer {
+  public:
+    using native_handle_type = detail::epoll::timer_watcher*;
+    using callback_type = std::function<void()>;
+
+    static native_handle_type allocate();
+    static void deallocate(native_handle_type native_handle);
+    static void start(typename loop::native_handle_type loop, native_handle_type native_handle) noexcept;
+    static void reset(typename loop::native_handle_type loop, native_handle_type native_handle) noexcept;
+    static void stop(typename loop::native_handle_type loop, native_handle_type native_handle) noexcept;
+    static bool is_active(native_handle_type native_handle) noexcept;
+    static bool is_pending(native_handle_type) noexcept;
+
+    template<typename U, typename V>
+    static void set_timeout(native_handle_type native_handle, std::chrono::duration<U, V> const& t) noexcept {
+      set_repeat(native_handle, std::chrono::duration_cast<std::chrono::nanoseconds>(t));
+    }
+
+    static void arm(typename loop::native_handle_type loop, native_handle_type native_handle,
+          std::chrono::nanoseconds const& after) noexcept;
+    static std::chrono::nanoseconds get_timeout(native_handle_type native_handle) noexcept;
+    static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
+
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      bind(native_handle, object, [] (void* target, std::int32_t) { (static_cast<T*>(target)->*Method)(); });
+    }
+
+  private:
+    static void bind(native_handle_type native_handle, void* object,
+          detail::epoll::member_callback_type callback) noexcept;
+    static void set_repeat(native_handle_type native_handle, std::chrono::nanoseconds const& repeat) noexcept;
+  };
+
+  struct signal {
+  public:
+    using native_handle_type = detail::epoll::signal_watcher*;
+    using callback_type = std::function<void()>;
+
+    static native_handle_type allocate();
+    static void deallocate(native_handle_type native_handle);
+    static void start(typename loop::native_handle_type native_loop_handle, native_handle_type native_handle) noexcept;
+    static void stop(typename loop::native_handle_type native_loop_handle, native_handle_type native_handle) noexcept;
+    static void set_number(native_handle_type native_handle, std::int32_t signum) noexcept;
+    static std::int32_t get_number(native_handle_type native_handle) noexcept;
+    static bool is_active(native_handle_type native_handle) noexcept;
+    static bool is_pending(native_handle_type) noexcept;
+    static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
+
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      bind(native_handle, object, [] (void* target, std::int32_t) { (static_cast<T*>(target)->*Method)(); });
+    }
+
+  private:
+    static void bind(native_handle_type native_handle, void* object,
+          detail::epoll::member_callback_type callback) noexcept;
+  };
+
+  struct idle {
+  public:
+    using native_handle_type = detail::epoll::idle_watcher*;
+    using callback_type = std::function<void()>;
+
+    static native_handle_type allocate();
+    static void deallocate(native_handle_type native_handle);
+    static void start(typename loop::native_handle_type native_loop_handle, native_handle_type native_handle) noexcept;
+    static void stop(typename loop::native_handle_type native_loop_handle, native_handle_type native_handle) noexcept;
+    static bool is_active(native_handle_type native_handle) noexcept;
+    static bool is_pending(native_handle_type) noexcept;
+    static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
+
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      bind(native_handle, object, [] (void* target, std::int32_t) { (static_cast<T*>(target)->*Method)(); });
+    }
+
+  private:
+    static void bind(native_handle_type native_handle, void* object,
+          detail::epoll::member_callback_type callback) noexcept;
+  };
+
+  struct io {
+  public:
+    using event_flags = std::int32_t;
+    using native_handle_type = detail::epoll::io_watcher*;
+    using callback_type = std::function<void(event_flags)>;
+
+    constexpr static event_flags event_read = 0x01;
+    constexpr static event_flags event_write = 0x02;
+    constexpr static event_flags event_error = 0x04;
+    // Requested with read and/or write: the watcher is notified once per
+    // readiness change and must drain the fd until it would block
+    constexpr static event_flags event_edge = 0x08;
+
+    static native_handle_type allocate();
+    static void deallocate(native_handle_type native_handle);
+    static void start(typename loop::native_handle_type native_loop_handle, native_handle_type native_handle) noexcept;
+    static void stop(typename loop::native_handle_type native_loop_handle, native_handle_type native_handle) noexcept;
+    static bool is_active(native_handle_type native_handle) noexcept;
+    static bool is_pending(native_handle_type) noexcept;
+    static void set_file_descriptor(native_handle_type native_handle, std::int32_t fd) noexcept;
+    static std::int32_t get_file_descriptor(native_handle_type native_handle) noexcept;
+    static void set_event_flags(native_handle_type native_handle, event_flags ev) noexcept;
+    static event_flags get_event_flags(native_handle_type native_handle) noexcept;
+    static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
+
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      bind(native_handle, object, [] (void* target, std::int32_t revents) { (static_cast<T*>(target)->*Method)(revents); });
+    }
+
+  private:
+    static void bind(native_handle_type native_handle, void* object,
+          detail::epoll::member_callback_type callback) noexcept;
+  };
+};
+
+} // cyan::event
+
+#endif // CYAN_EVENT_HAVE_EPOLL
@@ -23,21 +23,59 @@
  **/
 #include <cassert>
 #include <mutex>
+#include <typeinfo>
+#include <type_traits>
 
 #include <cyan/event/backend_libev.h>
 
 namespace cyan::event {
 
+namespace {
+
+// Callbacks are stored next to the libev watcher, which remains the native
+// handle. Its `data` is the object of callbacks bound to one, and the type
+// of the others, for the loop monitor.
+template<typename Watcher, typename Callback>
+struct watcher : public Watcher {
+  Callback callback;
+};
+
+template<typename Traits>
+using watcher_t = watcher<std::remove_pointer_t<typename Traits::native_handle_type>, typename Traits::callback_type>;
+
+} // <anonymous>
+
+namespace detail::libev {
+
+// Kept in the loop's user data
+struct loop_data {
+  loop_monitor* monitor = nullptr;
+  // Callbacks run since `iterate` last reset it, bar the deadline's
+  std::size_t invoked = 0;
+  // Bounds the wait of a pass given a timeout
+  ::ev_timer deadline;
+};
+
+inline loop_data* get_loop_data(struct ::ev_loop* loop) noexcept {
+  return static_cast<loop_data*>(::ev_userdata(loop));
+}
+
+} // detail::libev
+
 backend_traits<backend::libev>::loop::native_handle_type
 backend_traits<backend::libev>::loop::allocate() {
   auto native_handle = ev_loop_new((EVBACKEND_ALL & ~EVBACKEND_SELECT) | EVFLAG_NOENV);
   assert(native_handle != nullptr && "failed to allocate loop handle");
   ::ev_ref(native_handle);
+  auto data = new detail::libev::loop_data;
+  ev_timer_init(&data->deadline, [] (struct ::ev_loop*, ::ev_timer*, int) {}, 0., 0.);
+  ::ev_set_userdata(native_handle, data);
   return native_handle;
 }
 
 void
 backend_traits<backend::libev>::loop::deallocate(native_handle_type native_handle) {
+  delete detail::libev::get_loop_data(native_handle);
   ::ev_loop_destroy(native_handle);
 }
 
@@ -51,9 +89,54 @@ backend_traits<backend::libev>::loop::stop(native_handle_type native_handle) noe
   ::ev_break(native_handle, EVBREAK_ALL);
 }
 
+std::size_t
+backend_traits<backend::libev>::loop::iterate(native_handle_type native_handle,
+      std::chrono::nanoseconds timeout) noexcept {
+  auto data = detail::libev::get_loop_data(native_handle);
+  data->invoked = 0;
+
+  if (timeout <= std::chrono::nanoseconds::zero()) {
+    ::ev_run(native_handle, EVRUN_NOWAIT);
+  } else if (timeout == std::chrono::nanoseconds::max()) {
+    ::ev_run(native_handle, EVRUN_ONCE);
+  } else {
+    // EVRUN_ONCE waits for any event; the deadline timer makes one due in time
+    ::ev_now_update(native_handle);
+    ev_timer_set(&data->deadline, std::chrono::duration<double>(timeout).count(), 0.);
+    ::ev_timer_start(native_handle, &data->deadline);
+    ::ev_run(native_handle, EVRUN_ONCE);
+    ::ev_timer_stop(native_handle, &data->deadline);
+  }
+
+  return data->invoked;
+}
+
+// libev's release and acquire hooks bracket its wait for events, and
+// callbacks are timed as they are invoked (see EV_CB_INVOKE below)
+void
+backend_traits<backend::libev>::loop::set_monitor(native_handle_type native_handle,
+      detail::loop_monitor* monitor) noexcept {
+  detail::libev::get_loop_data(native_handle)->monitor = monitor;
+  if (monitor) {
+    ::ev_set_loop_release_cb(native_handle, poll_begin, poll_end);
+  } else {
+    ::ev_set_loop_release_cb(native_handle, nullptr, nullptr);
+  }
+}
+
+void
+backend_traits<backend::libev>::loop::poll_begin(native_handle_type native_handle) noexcept {
+  detail::libev::get_loop_data(native_handle)->monitor->poll_begin();
+}
+
+void
+backend_traits<backend::libev>::loop::poll_end(native_handle_type native_handle) noexcept {
+  detail::libev::get_loop_data(native_handle)->monitor->poll_end();
+}
+
 backend_traits<backend::libev>::async::native_handle_type
 backend_traits<backend::libev>::async::allocate() {
-  auto native_handle = new struct ::ev_async;
+  auto native_handle = new watcher_t<async>;
   native_handle->data = nullptr;
   ev_async_init(native_handle, async_callback);
   return native_handle;
@@ -61,8 +144,7 @@ backend_traits<backend::libev>::async::allocate() {
   
 void
 backend_traits<backend::libev>::async::deallocate(native_handle_type native_handle) {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  delete native_handle;
+  delete static_cast<watcher_t<async>*>(native_handle);
 }
   
 void
@@ -96,26 +178,21 @@ backend_traits<backend::libev>::async::is_pending(native_handle_type native_hand
 void
 backend_traits<backend::libev>::async::set_callback(native_handle_type native_handle,
       callback_type && callback) noexcept {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  native_handle->data = nullptr;
-
-  if (callback) {
-    native_handle->data = new callback_type(std::forward<callback_type>(callback));
-  }
+  auto& stored = static_cast<watcher_t<async>*>(native_handle)->callback;
+  stored = std::move(callback);
+  native_handle->data = stored ? const_cast<std::type_info*>(&stored.target_type()) : nullptr;
+  ev_set_cb(native_handle, async_callback);
 }
 
 void
 backend_traits<backend::libev>::async::async_callback(typename loop::native_handle_type,
-      native_handle_type async, int) noexcept {
-  if (async->data) {
-    auto* callback = static_cast<callback_type*>(async->data);
-    (*callback)();
-  }
+      native_handle_type native_handle, int) noexcept {
+  if (auto& callback = static_cast<watcher_t<async>*>(native_handle)->callback) callback();
 }
 
 backend_traits<backend::libev>::timer::native_handle_type
 backend_traits<backend::libev>::timer::allocate() {
-  auto native_handle = new struct ::ev_timer;
+  auto native_handle = new watcher_t<timer>;
   ev_timer_init(native_handle, timer_callback, 0., 0.);
   native_handle->data = nullptr;
   return native_handle;
@@ -123,8 +200,7 @@ backend_traits<backend::libev>::timer::allocate() {
 
 void
 backend_traits<backend::libev>::timer::deallocate(native_handle_type native_handle) {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  delete native_handle;
+  delete static_cast<watcher_t<timer>*>(native_handle);
 }
 
 void
@@ -145,10 +221,22 @@ backend_traits<backend::libev>::timer::stop(typename loop::native_handle_type na
   ::ev_timer_stop(native_loop_handle, native_handle);
 }
 
-std::chrono::milliseconds
+void
+backend_traits<backend::libev>::timer::arm(typename loop::native_handle_type native_loop_handle,
+      native_handle_type native_handle, std::chrono::nanoseconds const& after) noexcept {
+  // libev measures from the time cached at the start of the iteration, which
+  // can be well behind when arming from inside a long callback
+  auto const stale = ::ev_time() - ::ev_now(native_loop_handle);
+  auto const after_s = std::chrono::duration<double>(after).count() + stale;
+
+  ::ev_timer_stop(native_loop_handle, native_handle);
+  ev_timer_set(native_handle, after_s > 0. ? after_s : 0., 0.);
+  ::ev_timer_start(native_loop_handle, native_handle);
+}
+
+std::chrono::nanoseconds
 backend_traits<backend::libev>::timer::get_timeout(native_handle_type native_handle) noexcept {
-  double msecs = native_handle->repeat * 1000.;
-  return std::chrono::milliseconds(int(msecs));
+  return std::chrono::round<std::chrono::nanoseconds>(std::chrono::duration<double>(native_handle->repeat));
 }
 
 bool
@@ -169,26 +257,21 @@ backend_traits<backend::libev>::timer::set_timeout(native_handle_type native_han
 void
 backend_traits<backend::libev>::timer::set_callback(native_handle_type native_handle,
       callback_type && callback) noexcept {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  native_handle->data = nullptr;
-
-  if (callback) {
-    native_handle->data = new callback_type(std::forward<callback_type>(callback));
-  }
+  auto& stored = static_cast<watcher_t<timer>*>(native_handle)->callback;
+  stored = std::move(callback);
+  native_handle->data = stored ? const_cast<std::type_info*>(&stored.target_type()) : nullptr;
+  ev_set_cb(native_handle, timer_callback);
 }
 
 void
 backend_traits<backend::libev>::timer::timer_callback(typename loop::native_handle_type,
-      native_handle_type timer, int) noexcept {
-  if (timer->data) {
-    auto callback = static_cast<callback_type*>(timer->data);
-    (*callback)();
-  }
+      native_handle_type native_handle, int) noexcept {
+  if (auto& callback = static_cast<watcher_t<timer>*>(native_handle)->callback) callback();
 }
 
 backend_traits<backend::libev>::signal::native_handle_type
 backend_traits<backend::libev>::signal::allocate() {
-  auto native_handle = new struct ::ev_signal;
+  auto native_handle = new watcher_t<signal>;
   // initialize with SIGINT by default
   ev_signal_init(native_handle, signal_callback, SIGINT);
   native_handle->data = nullptr;
@@ -197,8 +280,7 @@ backend_traits<backend::libev>::signal::allocate() {
 
 void
 backend_traits<backend::libev>::signal::deallocate(native_handle_type native_handle) {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  delete native_handle;
+  delete static_cast<watcher_t<signal>*>(native_handle);
 }
 
 void
@@ -216,7 +298,7 @@ backend_traits<backend::libev>::signal::stop(typename loop::native_handle_type n
 void
 backend_traits<backend::libev>::signal::set_number(native_handle_type native_handle,
       std::int32_t signum) noexcept {
-  ev_signal_init(native_handle, signal_callback, signum);
+  ev_signal_set(native_handle, signum);
 }
 
 std::int32_t
@@ -237,26 +319,21 @@ backend_traits<backend::libev>::signal::is_pending(native_handle_type native_han
 void
 backend_traits<backend::libev>::signal::set_callback(native_handle_type native_handle,
       callback_type && callback) noexcept {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  native_handle->data = nullptr;
-
-  if (callback) {
-    native_handle->data = new callback_type(std::forward<callback_type>(callback));
-  }
+  auto& stored = static_cast<watcher_t<signal>*>(native_handle)->callback;
+  stored = std::move(callback);
+  native_handle->data = stored ? const_cast<std::type_info*>(&stored.target_type()) : nullptr;
+  ev_set_cb(native_handle, signal_callback);
 }
 
 void
 backend_traits<backend::libev>::signal::signal_callback(typename loop::native_handle_type,
       native_handle_type native_handle, int) noexcept {
-  if (native_handle->data) {
-    auto callback = static_cast<callback_type*>(native_handle->data);
-    (*callback)();
-  }
+  if (auto& callback = static_cast<watcher_t<signal>*>(native_handle)->callback) callback();
 }
 
 backend_traits<backend::libev>::idle::native_handle_type
 backend_traits<backend::libev>::idle::allocate() {
-  auto native_handle = new struct ::ev_idle;
+  auto native_handle = new watcher_t<idle>;
   ev_idle_init(native_handle, idle_callback);
   native_handle->data = nullptr;
   return native_handle;
@@ -264,8 +341,7 @@ backend_traits<backend::libev>::idle::allocate() {
 
 void
 backend_traits<backend::libev>::idle::deallocate(native_handle_type native_handle) {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  delete native_handle;
+  delete static_cast<watcher_t<idle>*>(native_handle);
 }
 
 void
@@ -293,26 +369,21 @@ backend_traits<backend::libev>::idle::is_pending(native_handle_type native_handl
 void
 backend_traits<backend::libev>::idle::set_callback(native_handle_type native_handle,
       callback_type && callback) noexcept {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  native_handle->data = nullptr;
-
-  if (callback) {
-    native_handle->data = new callback_type(std::forward<callback_type>(callback));
-  }
+  auto& stored = static_cast<watcher_t<idle>*>(native_handle)->callback;
+  stored = std::move(callback);
+  native_handle->data = stored ? const_cast<std::type_info*>(&stored.target_type()) : nullptr;
+  ev_set_cb(native_handle, idle_callback);
 }
 
 void
 backend_traits<backend::libev>::idle::idle_callback(typename loop::native_handle_type,
       native_handle_type native_handle, int) noexcept {
-  if (native_handle->data) {
-    auto callback = static_cast<callback_type*>(native_handle->data);
-    (*callback)();
-  }
+  if (auto& callback = static_cast<watcher_t<idle>*>(native_handle)->callback) callback();
 }
 
 backend_traits<backend::libev>::io::native_handle_type
 backend_traits<backend::libev>::io::allocate() {
-  auto native_handle = new struct ::ev_io;
+  auto native_handle = new watcher_t<io>;
   ev_io_init(native_handle, io_callback, -1, 0);
   native_handle->data = nullptr;
   return native_handle;
@@ -320,8 +391,7 @@ backend_traits<backend::libev>::io::allocate() {
 
 void
 backend_traits<backend::libev>::io::deallocate(native_handle_type native_handle) {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  delete native_handle;
+  delete static_cast<watcher_t<io>*>(native_handle);
 }
 
 void
@@ -369,26 +439,65 @@ backend_traits<backend::libev>::io::get_event_flags(native_handle_type native_ha
 void
 backend_traits<backend::libev>::io::set_callback(native_handle_type native_handle,
       callback_type && callback) noexcept {
-  if (native_handle->data) delete static_cast<callback_type*>(native_handle->data);
-  native_handle->data = nullptr;
-  if (callback) {
-    native_handle->data = new callback_type(std::forward<callback_type>(callback));
-  }
+  auto& stored = static_cast<watcher_t<io>*>(native_handle)->callback;
+  stored = std::move(callback);
+  native_handle->data = stored ? const_cast<std::type_info*>(&stored.target_type()) : nullptr;
+  ev_set_cb(native_handle, io_callback);
 }
 
 void
 backend_traits<backend::libev>::io::io_callback(typename loop::native_handle_type,
       native_handle_type native_handle, int revents) noexcept {
-  if (native_handle->data) {
-    auto callback = static_cast<callback_type*>(native_handle->data);
-    (*callback)(revents);
+  if (auto& callback = static_cast<watcher_t<io>*>(native_handle)->callback) callback(revents);
+}
+
+namespace detail::libev {
+
+// Invokes a pending watcher's callback, counting it for `iterate` and
+// timing it for an instrumented loop. libev's own watchers, which it runs
+// at the highest priority, and the deadline of a pass are left out. The
+// callback may free its watcher, which is only kept as an identifier.
+inline void invoke(struct ::ev_loop* loop, ::ev_watcher* watcher, int revents) noexcept {
+  auto const callback = watcher->cb;
+  auto data = get_loop_data(loop);
+
+  if (ev_priority(watcher) == EV_MAXPRI || watcher == reinterpret_cast<::ev_watcher*>(&data->deadline)) {
+    callback(loop, watcher, revents);
+    return;
+  }
+
+  data->invoked++;
+  if (!data->monitor) {
+    callback(loop, watcher, revents);
+    return;
   }
+
+  // Callables share the entry point of their kind of watcher and are told
+  // apart by type
+  using traits = backend_traits<backend::libev>;
+  auto const function = reinterpret_cast<void const*>(callback);
+  auto const shared = function == reinterpret_cast<void const*>(&traits::async::async_callback)
+        || function == reinterpret_cast<void const*>(&traits::timer::timer_callback)
+        || function == reinterpret_cast<void const*>(&traits::signal::signal_callback)
+        || function == reinterpret_cast<void const*>(&traits::idle::idle_callback)
+        || function == reinterpret_cast<void const*>(&traits::io::io_callback);
+
+  auto const begin = shared
+        ? data->monitor->callback_begin(watcher, nullptr, static_cast<std::type_info const*>(watcher->data))
+        : data->monitor->callback_begin(watcher, function, nullptr);
+  callback(loop, watcher, revents);
+  data->monitor->callback_done(begin);
 }
 
+} // detail::libev
+
 }
 
 #define EV_CONFIG_H <cyan/config.h>
 
+#undef EV_CB_INVOKE
+#define EV_CB_INVOKE(watcher, revents) cyan::event::detail::libev::invoke(EV_A_ (watcher), (revents))
+
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wall"
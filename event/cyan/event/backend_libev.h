@@ -47,6 +47,14 @@ struct backend_traits<backend::libev> {
     static void deallocate(native_handle_type loop);
     static void start(native_handle_type loop) noexcept;
     static void stop(native_handle_type loop) noexcept;
+    // One pass, waiting up to `timeout` for events, without limit if it is
+    // nanoseconds::max(); returns the callbacks run
+    static std::size_t iterate(native_handle_type loop, std::chrono::nanoseconds timeout) noexcept;
+    static void set_monitor(native_handle_type loop, detail::loop_monitor* monitor) noexcept;
+
+  private:
+    static void poll_begin(native_handle_type loop) noexcept;
+    static void poll_end(native_handle_type loop) noexcept;
   };
 
   struct async {
@@ -64,8 +72,24 @@ struct backend_traits<backend::libev> {
     static bool is_pending(native_handle_type) noexcept;
     static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
   
-  private:
+    // Binds `Method` of `object` as the libev callback itself: nothing is
+    // stored and dispatching takes a single indirect call
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      set_callback(native_handle, nullptr);
+      native_handle->data = object;
+      ev_set_cb(native_handle, (&member_callback<Method, T>));
+    }
+
+    // Entry point shared by the callbacks set as callables; bound methods
+    // each have their own (see member_callback)
     static void async_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept;
+
+  private:
+    template<auto Method, typename T>
+    static void member_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept {
+      (static_cast<T*>(native_handle->data)->*Method)();
+    }
   };
 
   struct timer {
@@ -83,17 +107,32 @@ struct backend_traits<backend::libev> {
 
     template<typename U, typename V>
     static void set_timeout(native_handle_type native_handle, std::chrono::duration<U, V> const& t) noexcept {
-      auto timeout_msec = std::chrono::duration_cast<std::chrono::milliseconds>(t);
-      double timeout_s = double(timeout_msec.count()) / 1000.;
-      set_timeout(native_handle, timeout_s);
+      set_timeout(native_handle, std::chrono::duration<double>(t).count());
     }
 
-    static std::chrono::milliseconds get_timeout(native_handle_type native_handle) noexcept;
+    static void arm(typename loop::native_handle_type loop, native_handle_type native_handle,
+          std::chrono::nanoseconds const& after) noexcept;
+    static std::chrono::nanoseconds get_timeout(native_handle_type native_handle) noexcept;
     static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
 
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      set_callback(native_handle, nullptr);
+      native_handle->data = object;
+      ev_set_cb(native_handle, (&member_callback<Method, T>));
+    }
+
   private:
     static void set_timeout(native_handle_type native_handle, double secs) noexcept;
+
+  public:
     static void timer_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept;
+
+  private:
+    template<auto Method, typename T>
+    static void member_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept {
+      (static_cast<T*>(native_handle->data)->*Method)();
+    }
   };
 
   struct signal {
@@ -111,8 +150,20 @@ struct backend_traits<backend::libev> {
     static bool is_pending(native_handle_type) noexcept;
     static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
 
-  private:
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      set_callback(native_handle, nullptr);
+      native_handle->data = object;
+      ev_set_cb(native_handle, (&member_callback<Method, T>));
+    }
+
     static void signal_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept;
+
+  private:
+    template<auto Method, typename T>
+    static void member_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept {
+      (static_cast<T*>(native_handle->data)->*Method)();
+    }
   };
 
   struct idle {
@@ -128,8 +179,20 @@ struct backend_traits<backend::libev> {
     static bool is_pending(native_handle_type) noexcept;
     static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
 
-  private:
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      set_callback(native_handle, nullptr);
+      native_handle->data = object;
+      ev_set_cb(native_handle, (&member_callback<Method, T>));
+    }
+
     static void idle_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept;
+
+  private:
+    template<auto Method, typename T>
+    static void member_callback(typename loop::native_handle_type, native_handle_type native_handle, int) noexcept {
+      (static_cast<T*>(native_handle->data)->*Method)();
+    }
   };
 
   struct io {
@@ -154,8 +217,20 @@ struct backend_traits<backend::libev> {
     static event_flags get_event_flags(native_handle_type native_handle) noexcept;
     static void set_callback(native_handle_type native_handle, callback_type&&) noexcept;
 
-  private:
+    template<auto Method, typename T>
+    static void set_callback(native_handle_type native_handle, T* object) noexcept {
+      set_callback(native_handle, nullptr);
+      native_handle->data = object;
+      ev_set_cb(native_handle, (&member_callback<Method, T>));
+    }
+
     static void io_callback(typename loop::native_handle_type, native_handle_type native_handle, int revents) noexcept;
+
+  private:
+    template<auto Method, typename T>
+    static void member_callback(typename loop::native_handle_type, native_handle_type native_handle, int revents) noexcept {
+      (static_cast<T*>(native_handle->data)->*Method)(static_cast<event_flags>(revents));
+    }
   };
 
 };
@@ -54,10 +54,23 @@ public:
 
   void set_callback(callback_type&&) noexcept;
 
+  template<auto Method, typename T>
+  void set_callback(T* object) noexcept {
+    callback_ = nullptr;
+    member_callback_ = [] (void* target) { (static_cast<T*>(target)->*Method)(); };
+    object_ = object;
+  }
+
 private:
+  void dispatch();
+
   std::unique_ptr<typename std::remove_pointer<native_handle_type>::type,
         void (*)(native_handle_type)> native_handle_;
   std::atomic<std::uint32_t> count_;
+  // The backend is bound to `dispatch`, which owns the user's callback
+  callback_type callback_;
+  void (*member_callback_)(void*) = nullptr;
+  void* object_ = nullptr;
 };
 
 } // v1
@@ -35,11 +35,19 @@ template<typename BackendTraits>
 basic_async<BackendTraits>::basic_async(std::weak_ptr<loop_type> const& loop) : base{ loop },
       native_handle_{ backend_traits_type::allocate(), backend_traits_type::deallocate } {
   count_.store(0, std::memory_order_release);
+  backend_traits_type::template set_callback<&basic_async::dispatch>(native_handle_.get(), this);
 }
 
 template<typename BackendTraits>
 basic_async<BackendTraits>::basic_async(basic_async&& other) noexcept : base{ std::move(other) },
-      native_handle_{ std::move(other.native_handle_) } {
+      native_handle_{ std::move(other.native_handle_) },
+      callback_{ std::move(other.callback_) },
+      member_callback_{ other.member_callback_ },
+      object_{ other.object_ } {
+  count_.store(other.count_.load(std::memory_order_acquire), std::memory_order_release);
+  if (native_handle_) {
+    backend_traits_type::template set_callback<&basic_async::dispatch>(native_handle_.get(), this);
+  }
 }
 
 template<typename BackendTraits>
@@ -51,6 +59,13 @@ template<typename BackendTraits>
 basic_async<BackendTraits>& basic_async<BackendTraits>::operator =(basic_async&& other) noexcept {
   base::operator =(std::move(other));
   native_handle_ = std::move(other.native_handle_);
+  callback_ = std::move(other.callback_);
+  member_callback_ = other.member_callback_;
+  object_ = other.object_;
+  count_.store(other.count_.load(std::memory_order_acquire), std::memory_order_release);
+  if (native_handle_) {
+    backend_traits_type::template set_callback<&basic_async::dispatch>(native_handle_.get(), this);
+  }
   return *this;
 }
 
@@ -74,16 +89,22 @@ void basic_async<BackendTraits>::send() noexcept {
 
 template<typename BackendTraits>
 void basic_async<BackendTraits>::set_callback(callback_type&& callback) noexcept {
-  if (callback) {
-    backend_traits_type::set_callback(native_handle_.get(), [this, callback = std::forward<callback_type>(callback)] () mutable {
-      callback();
+  callback_ = std::move(callback);
+  member_callback_ = nullptr;
+}
 
-      if (count_.fetch_sub(1, std::memory_order_acq_rel) > 1) {
-        send();
-      }
-    });
+template<typename BackendTraits>
+void basic_async<BackendTraits>::dispatch() {
+  if (member_callback_) {
+    member_callback_(object_);
+  } else if (callback_) {
+    callback_();
   } else {
-    backend_traits_type::set_callback(native_handle_.get(), nullptr);
+    return;
+  }
+
+  if (count_.fetch_sub(1, std::memory_order_acq_rel) > 1) {
+    send();
   }
 }
 
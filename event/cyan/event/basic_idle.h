@@ -65,6 +65,11 @@ public:
     backend_traits_type::set_callback(native_handle_.get(), std::forward<callback_type>(callback));
   }
 
+  template<auto Method, typename T>
+  void set_callback(T* object) noexcept {
+    backend_traits_type::template set_callback<Method>(native_handle_.get(), object);
+  }
+
 private:
   std::unique_ptr<typename std::remove_pointer<native_handle_type>::type,
         void (*)(native_handle_type)> native_handle_;
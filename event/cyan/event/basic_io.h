@@ -59,6 +59,13 @@ public:
   std::int32_t get_file_descriptor() const noexcept;
   void set_callback(callback_type&& callback) noexcept;
 
+  // Binds `Method` of `object` without storing a callable; rebind after
+  // moving either of them
+  template<auto Method, typename T>
+  void set_callback(T* object) noexcept {
+    backend_traits_type::template set_callback<Method>(native_handle_.get(), object);
+  }
+
 private:
   std::unique_ptr<typename std::remove_pointer<native_handle_type>::type,
       void (*)(native_handle_type)> native_handle_;
@@ -0,0 +1,77 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <memory>
+
+#include <cyan/event/io_uring.h>
+#include <cyan/event/basic_io.h>
+
+#ifdef CYAN_EVENT_HAVE_IO_URING
+
+namespace cyan::event {
+inline namespace v1 {
+
+// Completion-based I/O for a loop: an io_uring instance whose completions
+// are processed on the loop's thread as its descriptor turns readable. The
+// watcher is only active while operations are pending, so an idle ring does
+// not keep the loop running.
+template<typename BackendTraits>
+class basic_io_ring : public detail::ring {
+public:
+  using io_type = basic_io<BackendTraits>;
+  using loop_type = typename io_type::loop_type;
+
+  explicit basic_io_ring(std::weak_ptr<loop_type> const& loop, std::uint32_t entries = default_entries,
+        std::uint32_t files = default_files) : detail::ring{ entries, files }, watcher_{ loop } {
+    watcher_.set_file_descriptor(native_handle());
+    watcher_.set_event_flags(io_type::event_read);
+    watcher_.template set_callback<&basic_io_ring::on_readable>(this);
+  }
+
+  ~basic_io_ring() {
+    watcher_.stop();
+  }
+
+protected:
+  void on_pending_changed(bool pending) override {
+    if (pending) {
+      watcher_.start();
+    } else {
+      watcher_.stop();
+    }
+  }
+
+private:
+  void on_readable(typename io_type::event_flags) {
+    process();
+  }
+
+  io_type watcher_;
+};
+
+} // v1
+} // cyan::event
+
+#endif // CYAN_EVENT_HAVE_IO_URING
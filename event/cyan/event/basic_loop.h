@@ -23,19 +23,52 @@
  **/
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <thread>
+#include <cstdint>
+#include <functional>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <cyan/event/loop_monitor.h>
+#include <cyan/event/task_queue.h>
 #include <cyan/noncopyable.h>
 
 namespace cyan::event {
 inline namespace v1 {
 
+namespace detail {
+
+// Written by the loop's owner thread alone, with detail::increment; read
+// from any thread.
+struct loop_counters {
+  std::atomic<std::uint64_t> timer_wakeups{ 0 };
+  std::atomic<std::uint64_t> timers_expired{ 0 };
+  std::atomic<std::uint64_t> timer_wakeups_saved{ 0 };
+};
+
+// Tells the core it is in a spin-wait
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+} // detail
+
 template<typename BackendTraits>
 class basic_loop : public cyan::noncopyable {
 public:
   using backend_traits_type = typename BackendTraits::loop;
   using native_handle_type = typename backend_traits_type::native_handle_type;
+  using task_type = detail::task_queue::task_type;
+  using slow_callback_handler_type = detail::loop_monitor::slow_callback_handler_type;
 
   basic_loop();
   explicit basic_loop(basic_loop&& other) noexcept;
@@ -46,13 +79,80 @@ public:
   native_handle_type native_handle() const noexcept;
 
   void start() noexcept;
+  // Runs the loop without sleeping: the backend is polled with a zero
+  // timeout, spinning while nothing is ready. After `idle_budget` with no
+  // events the loop takes one blocking wait, then goes back to spinning;
+  // the default budget never blocks.
+  void start_busy_poll(std::chrono::nanoseconds idle_budget = std::chrono::nanoseconds::max()) noexcept;
   void stop() noexcept;
+
+  // For driving the loop from another main loop or scheduler: each call
+  // runs one pass and returns the number of events it processed.
+  // `run_once` waits up to `timeout` for events, indefinitely by default,
+  // like EVRUN_ONCE; `poll` does not wait at all, like EVRUN_NOWAIT.
+  std::size_t run_once(std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) noexcept;
+  std::size_t poll() noexcept;
+
+  // Run passes until `deadline`, or until `stop` is called, and return the
+  // events processed by all of them
+  template<typename Clock, typename Duration>
+  std::size_t run_until(std::chrono::time_point<Clock, Duration> const& deadline) noexcept {
+    std::size_t count = 0;
+
+    stopping_.store(false, std::memory_order_relaxed);
+    while (!stopping_.load(std::memory_order_acquire)) {
+      auto const now = Clock::now();
+      if (now >= deadline) {
+        break;
+      }
+
+      count += run_once(std::chrono::ceil<std::chrono::nanoseconds>(deadline - now));
+    }
+
+    return count;
+  }
+
+  template<typename Rep, typename Period>
+  std::size_t run_for(std::chrono::duration<Rep, Period> const& duration) noexcept {
+    return run_until(std::chrono::steady_clock::now() + duration);
+  }
   std::thread::id get_owner_thread_id() const noexcept;
 
+  // Queues `task` to run on the loop. Safe to call from any thread; a
+  // single wakeup covers every task posted before the loop gets to them.
+  void post(task_type&& task);
+  // Runs `task` right away when called on the owner thread, else posts it
+  void dispatch(task_type&& task);
+
+  loop_metrics get_metrics() const noexcept;
+  // Instrumentation is off by default. While on, the backend times its
+  // waits for events and every callback it runs. Meant for the owner
+  // thread, or before the loop starts, like the handler below.
+  void set_instrumentation(bool enabled) noexcept;
+  // Instrumented callbacks that run for longer than `threshold` are
+  // counted and reported to `handler`, on the loop's thread, as they return.
+  // A watchdog thread also reports them, once, while they still run; the
+  // handler may then be called from both threads at once.
+  void set_slow_callback_handler(std::chrono::nanoseconds threshold, slow_callback_handler_type&& handler = nullptr);
+  // Called on the owner thread by a timer wheel that woke up and fired
+  // `expired` requests, `coalesced` of them ahead of their latest expiry
+  void on_timer_wakeup(std::size_t expired, std::size_t coalesced) noexcept;
+
 private:
+  using wakeup_traits_type = typename BackendTraits::async;
+  using wakeup_handle_type = typename wakeup_traits_type::native_handle_type;
+
+  void run_posted();
+
   std::unique_ptr<typename std::remove_pointer<native_handle_type>::type,
       void (*)(native_handle_type)> native_handle_;
   std::thread::id owner_thread_;
+  std::atomic<bool> stopping_{ false };
+  detail::loop_counters counters_;
+  std::unique_ptr<detail::task_queue> tasks_;
+  std::unique_ptr<typename std::remove_pointer<wakeup_handle_type>::type,
+      void (*)(wakeup_handle_type)> wakeup_;
+  std::unique_ptr<detail::loop_monitor> monitor_;
 };
 
 } // v1
@@ -34,21 +34,46 @@ inline namespace v1 {
 template<typename T>
 basic_loop<T>::basic_loop()
       : native_handle_{ backend_traits_type::allocate(), backend_traits_type::deallocate },
-      owner_thread_{ std::this_thread::get_id() } {
+      owner_thread_{ std::this_thread::get_id() },
+      tasks_{ std::make_unique<detail::task_queue>() },
+      wakeup_{ wakeup_traits_type::allocate(), wakeup_traits_type::deallocate },
+      monitor_{ std::make_unique<detail::loop_monitor>() } {
+  wakeup_traits_type::template set_callback<&basic_loop::run_posted>(wakeup_.get(), this);
+  wakeup_traits_type::start(native_handle_.get(), wakeup_.get());
 }
 
 template<typename T>
 basic_loop<T>::~basic_loop() {
+  if (wakeup_) {
+    wakeup_traits_type::stop(native_handle_.get(), wakeup_.get());
+  }
   stop();
 }
 
 template<typename T>
-basic_loop<T>::basic_loop(basic_loop&& other) noexcept : native_handle_{ std::move(other.native_handle_) } {
+basic_loop<T>::basic_loop(basic_loop&& other) noexcept : native_handle_{ std::move(other.native_handle_) },
+      owner_thread_{ other.owner_thread_ },
+      tasks_{ std::move(other.tasks_) },
+      wakeup_{ std::move(other.wakeup_) },
+      monitor_{ std::move(other.monitor_) } {
+  if (wakeup_) {
+    wakeup_traits_type::template set_callback<&basic_loop::run_posted>(wakeup_.get(), this);
+  }
 }
 
 template<typename T>
 basic_loop<T>& basic_loop<T>::operator =(basic_loop&& other) noexcept {
+  if (wakeup_) {
+    wakeup_traits_type::stop(native_handle_.get(), wakeup_.get());
+  }
+  wakeup_ = std::move(other.wakeup_);
   native_handle_ = std::move(other.native_handle_);
+  owner_thread_ = other.owner_thread_;
+  tasks_ = std::move(other.tasks_);
+  monitor_ = std::move(other.monitor_);
+  if (wakeup_) {
+    wakeup_traits_type::template set_callback<&basic_loop::run_posted>(wakeup_.get(), this);
+  }
   return *this;
 }
 
@@ -62,8 +87,48 @@ void basic_loop<T>::start() noexcept {
   backend_traits_type::start(native_handle_.get());
 }
 
+template<typename T>
+void basic_loop<T>::start_busy_poll(std::chrono::nanoseconds idle_budget) noexcept {
+  using clock = std::chrono::steady_clock;
+
+  // Like `start`, a stop requested before the loop started is discarded
+  stopping_.store(false, std::memory_order_relaxed);
+
+  auto idle = false;
+  clock::time_point idle_since;
+  while (!stopping_.load(std::memory_order_acquire)) {
+    if (poll() > 0) {
+      idle = false;
+      continue;
+    }
+
+    auto const now = clock::now();
+    if (!idle) {
+      idle = true;
+      idle_since = now;
+    } else if (now - idle_since >= idle_budget) {
+      run_once();
+      idle = false;
+      continue;
+    }
+
+    detail::cpu_relax();
+  }
+}
+
+template<typename T>
+std::size_t basic_loop<T>::run_once(std::chrono::nanoseconds timeout) noexcept {
+  return backend_traits_type::iterate(native_handle_.get(), timeout);
+}
+
+template<typename T>
+std::size_t basic_loop<T>::poll() noexcept {
+  return backend_traits_type::iterate(native_handle_.get(), std::chrono::nanoseconds::zero());
+}
+
 template<typename T>
 void basic_loop<T>::stop() noexcept {
+  stopping_.store(true, std::memory_order_release);
   backend_traits_type::stop(native_handle_.get());
 }
 
@@ -72,5 +137,58 @@ std::thread::id basic_loop<T>::get_owner_thread_id() const noexcept {
   return owner_thread_;
 }
 
+template<typename T>
+void basic_loop<T>::post(task_type&& task) {
+  if (tasks_->push(std::move(task))) {
+    wakeup_traits_type::send(native_handle_.get(), wakeup_.get());
+  }
+}
+
+template<typename T>
+void basic_loop<T>::dispatch(task_type&& task) {
+  if (std::this_thread::get_id() == owner_thread_) {
+    task();
+  } else {
+    post(std::move(task));
+  }
+}
+
+template<typename T>
+void basic_loop<T>::run_posted() {
+  tasks_->drain();
+
+  if (tasks_->pending()) {
+    wakeup_traits_type::send(native_handle_.get(), wakeup_.get());
+  }
+}
+
+template<typename T>
+loop_metrics basic_loop<T>::get_metrics() const noexcept {
+  loop_metrics metrics;
+  metrics.timer_wakeups = counters_.timer_wakeups.load(std::memory_order_relaxed);
+  metrics.timers_expired = counters_.timers_expired.load(std::memory_order_relaxed);
+  metrics.timer_wakeups_saved = counters_.timer_wakeups_saved.load(std::memory_order_relaxed);
+  monitor_->snapshot(metrics);
+  return metrics;
+}
+
+template<typename T>
+void basic_loop<T>::set_instrumentation(bool enabled) noexcept {
+  backend_traits_type::set_monitor(native_handle_.get(), enabled ? monitor_.get() : nullptr);
+}
+
+template<typename T>
+void basic_loop<T>::set_slow_callback_handler(std::chrono::nanoseconds threshold,
+      slow_callback_handler_type&& handler) {
+  monitor_->set_slow_callback_handler(threshold, std::move(handler));
+}
+
+template<typename T>
+void basic_loop<T>::on_timer_wakeup(std::size_t expired, std::size_t coalesced) noexcept {
+  detail::increment(counters_.timer_wakeups);
+  detail::increment(counters_.timers_expired, expired);
+  detail::increment(counters_.timer_wakeups_saved, coalesced);
+}
+
 } // v1
 } // cyan::event
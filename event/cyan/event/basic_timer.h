@@ -75,14 +75,41 @@ public:
     backend_traits_type::set_timeout(native_handle_.get(), t);
   }
 
-  std::chrono::milliseconds get_timeout() const noexcept {
+  std::chrono::nanoseconds get_timeout() const noexcept {
     return backend_traits_type::get_timeout(native_handle_.get());
   }
 
+  // Starts the timer for a single expiry `after` from now, replacing any
+  // pending one. With a non-zero slack the expiry is rounded up to a multiple
+  // of it on the steady clock, so timers sharing a slack share wakeups.
+  template<typename U, typename V>
+  void arm(std::chrono::duration<U, V> const& after,
+        std::chrono::nanoseconds const& slack = std::chrono::nanoseconds::zero()) {
+    auto const now = std::chrono::steady_clock::now();
+    auto expiry = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(after);
+    if (slack.count() > 0) {
+      auto const since_epoch = expiry.time_since_epoch();
+      auto const slack_ticks = std::chrono::duration_cast<std::chrono::steady_clock::duration>(slack);
+      expiry = std::chrono::steady_clock::time_point{
+            (since_epoch + slack_ticks - std::chrono::steady_clock::duration(1)) / slack_ticks * slack_ticks };
+    }
+
+    if (auto loop = base::loop_ref_.lock()) {
+      backend_traits_type::arm(loop->native_handle(), native_handle_.get(), expiry - now);
+    } else {
+      throw std::runtime_error{ "loop is dead" };
+    }
+  }
+
   void set_callback(callback_type&& callback) {
     backend_traits_type::set_callback(native_handle_.get(), std::forward<callback_type>(callback));
   }
 
+  template<auto Method, typename T>
+  void set_callback(T* object) noexcept {
+    backend_traits_type::template set_callback<Method>(native_handle_.get(), object);
+  }
+
 private:
   std::unique_ptr<typename std::remove_pointer<native_handle_type>::type,
       void (*)(native_handle_type)> native_handle_;
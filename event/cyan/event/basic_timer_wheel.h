@@ -23,14 +23,18 @@
  **/
 #pragma once
 
-#include <map>
+#include <bit>
+#include <array>
+#include <algorithm>
 #include <chrono>
 #include <memory>
+#include <vector>
+#include <cstdint>
+#include <limits>
 #include <utility>
-#include <unordered_map>
-#include <functional>
 #include <stdexcept>
 
+#include <cyan/trace.h>
 #include <cyan/utility.h>
 #include <cyan/noncopyable.h>
 #include <cyan/event/basic_timer.h>
@@ -38,6 +42,27 @@
 namespace cyan::event {
 inline namespace v1 {
 
+// Hierarchical timing wheel: four levels of 256 slots, each slot an
+// intrusive list of requests. Posting, cancelling and resetting are O(1):
+// slots are unordered, arming takes the earliest expiry of the first
+// non-empty slot, and the requests due at a wakeup are sorted so that
+// requests sharing a tick still fire in expiry order. Requests due further
+// out than the first level are cascaded down as the wheel turns. A request costs one allocation, and ids are checked against
+// a generation so that stale ones are rejected.
+//
+// The wheel is tickless: its timer is armed for the earliest pending expiry
+// and requests fire at their exact expiry, so the resolution only sizes the
+// slots and an idle wheel never wakes up.
+//
+// A request may be given a slack, making it due anywhere from its expiry to
+// its expiry plus the slack. The timer is armed for the earliest latest
+// expiry, and each wakeup also fires the requests whose window has opened,
+// so that nearby requests share one wakeup instead of taking one each.
+// Coalescing looks ahead no further than the first level of the wheel.
+//
+// Each level keeps a bitmap of the slots that may hold requests, so that a
+// late wakeup skips the ticks with nothing to fire or cascade rather than
+// walking every one of them.
 template<typename BackendTraits>
 class basic_timer_wheel : public cyan::noncopyable {
 public:
@@ -47,15 +72,61 @@ public:
   constexpr static auto default_resolution = std::chrono::milliseconds(100);
 
 private:
-	struct request {
+  constexpr static std::uint32_t slot_bits = 8;
+  constexpr static std::uint32_t slots = 1u << slot_bits;
+  constexpr static std::uint32_t levels = 4;
+  constexpr static std::uint64_t max_distance = (std::uint64_t(1) << (slot_bits * levels)) - 1;
+
+  struct link {
+    link* prev = this;
+    link* next = this;
+
+    bool is_linked() const noexcept {
+      return next != this;
+    }
+
+    void unlink() noexcept {
+      prev->next = next;
+      next->prev = prev;
+      prev = next = this;
+    }
+
+    void push_back(link* node) noexcept {
+      insert_after(prev, node);
+    }
+
+    static void insert_after(link* pos, link* node) noexcept {
+      node->prev = pos;
+      node->next = pos->next;
+      pos->next->prev = node;
+      pos->next = node;
+    }
+
+    // Moves every node of `other` to the back of this list
+    void splice(link& other) noexcept {
+      if (!other.is_linked()) return;
+      other.next->prev = prev;
+      other.prev->next = this;
+      prev->next = other.next;
+      prev = other.prev;
+      other.prev = other.next = &other;
+    }
+  };
+
+  struct request : public link {
     virtual ~request() noexcept = default;
+    virtual void process() = 0;
+
+    std::chrono::steady_clock::time_point latest() const noexcept {
+      return when + slack;
+    }
 
     request_id_type id;
-    bool is_cancelled;
-    std::chrono::milliseconds timeout;
-    std::chrono::steady_clock::time_point expiry;
-    virtual void process() = 0;
-	};
+    std::uint64_t expiry;
+    std::chrono::steady_clock::time_point when;
+    std::chrono::steady_clock::duration timeout;
+    std::chrono::steady_clock::duration slack;
+  };
 
   template<typename C>
   struct request_impl : public request {
@@ -69,53 +140,226 @@ private:
     C callable_;
   };
 
-  template<typename Callable>
-  std::shared_ptr<request> make_request(Callable&& c) {
-    return std::shared_ptr<request>{ new request_impl<Callable>{ std::forward<Callable>(c) }};
-  }
-
   struct basic_timer_wheel_impl {
-    basic_timer_wheel_impl(std::weak_ptr<loop_type> const& loop) : timer{ loop },
-          request_id_{ 0 } {
+    basic_timer_wheel_impl(std::weak_ptr<loop_type> const& loop) : timer{ loop }, loop{ loop },
+          resolution{ default_resolution }, max_slack{ std::chrono::steady_clock::duration::zero() },
+          epoch{ std::chrono::steady_clock::now() },
+          armed{ std::chrono::steady_clock::time_point::max() }, next_tick{ 0 },
+          cascaded{ std::numeric_limits<std::uint64_t>::max() }, count{ 0 } {
     }
 
-    request_id_type get_next_request_id() noexcept {
-      auto id = request_id_;
-      request_id_ = (request_id_ + 1) & std::numeric_limits<request_id_type>::max();
-      return id;
+    ~basic_timer_wheel_impl() {
+      for (auto* req : requests) delete req;
     }
 
-    template<typename R, typename D>
-    static std::chrono::steady_clock::time_point
-    get_absolute_expiry(std::chrono::duration<R, D> const& timeout) noexcept {
-      auto const now = std::chrono::steady_clock::now();
-      return now + timeout;
+    // Last tick whose expiries have all passed at `now`
+    std::uint64_t tick_at(std::chrono::steady_clock::time_point const& now) const noexcept {
+      return static_cast<std::uint64_t>((now - epoch) / resolution);
     }
 
-    std::unordered_map<request_id_type, std::shared_ptr<request>> requests;
-    std::multimap<std::chrono::steady_clock::time_point, std::shared_ptr<request>> time_hiearchy;
-    timer_type timer;
+    // First tick at or after `expiry`
+    std::uint64_t tick_of(std::chrono::steady_clock::time_point const& expiry) const noexcept {
+      if (expiry <= epoch) return 0;
+      auto const elapsed = expiry - epoch;
+      return static_cast<std::uint64_t>((elapsed + resolution - std::chrono::steady_clock::duration(1)) / resolution);
+    }
 
-  private:
-    request_id_type request_id_;
+    void schedule(request* req) noexcept {
+      auto expiry = std::max(req->expiry, next_tick);
+      auto const distance = std::min(expiry - next_tick, max_distance);
+      expiry = next_tick + distance;
+
+      std::uint32_t level = 0;
+      while (level + 1 < levels && distance >= (std::uint64_t(1) << (slot_bits * (level + 1)))) level++;
+      auto const index = static_cast<std::uint32_t>((expiry >> (slot_bits * level)) & (slots - 1));
+      wheel[level][index].push_back(req);
+      occupied[level][index / 64] |= std::uint64_t(1) << (index % 64);
+    }
+
+    // First position from `from` on, within one turn of `level`, whose slot
+    // holds requests; from + slots if none. Bits are only set when
+    // scheduling, so stale ones are cleared as they are found.
+    std::uint64_t find_occupied(std::uint32_t level, std::uint64_t from) noexcept {
+      auto const end = from + slots;
+      for (auto i = from; i < end;) {
+        auto const index = static_cast<std::uint32_t>(i & (slots - 1));
+        auto const bits = occupied[level][index / 64] >> (index % 64);
+        if (!bits) {
+          i += 64 - index % 64;
+          continue;
+        }
+
+        i += static_cast<std::uint32_t>(std::countr_zero(bits));
+        if (i >= end) break;
+        auto const hit = static_cast<std::uint32_t>(i & (slots - 1));
+        if (wheel[level][hit].is_linked()) return i;
+        occupied[level][hit / 64] &= ~(std::uint64_t(1) << (hit % 64));
+        i++;
+      }
+      return end;
+    }
+
+    // Next tick with requests to fire on the first level, or with a cascade
+    // that brings requests down from an upper one
+    std::uint64_t next_busy_tick() noexcept {
+      if (!(next_tick & (slots - 1)) && cascaded != next_tick) return next_tick;
+
+      auto tick = find_occupied(0, next_tick);
+      if (tick == next_tick + slots) tick = std::numeric_limits<std::uint64_t>::max();
+
+      for (std::uint32_t level = 1; level < levels; level++) {
+        auto const base = next_tick >> (slot_bits * level);
+        auto const position = find_occupied(level, base + 1);
+        if (position <= base + slots) tick = std::min(tick, position << (slot_bits * level));
+      }
+      return tick;
+    }
+
+    static bool is_before(link const* lhs, link const* rhs) noexcept {
+      return static_cast<request const*>(lhs)->latest() < static_cast<request const*>(rhs)->latest();
+    }
+
+    // Stable merge sort of a list by latest expiry; due requests mostly
+    // arrive in order already, which costs one pass
+    static void sort(link& list) noexcept {
+      auto* node = list.next;
+      while (node->next != &list && !is_before(node->next, node)) node = node->next;
+      if (node->next == &list) return;
+
+      // Move the back half to its own list
+      auto* middle = list.next;
+      for (auto* fast = list.next->next; fast != &list && fast->next != &list; fast = fast->next->next) {
+        middle = middle->next;
+      }
+      link back;
+      back.next = middle->next;
+      back.prev = list.prev;
+      back.next->prev = &back;
+      back.prev->next = &back;
+      middle->next = &list;
+      list.prev = middle;
+
+      sort(list);
+      sort(back);
+
+      // Each node of the back half goes before the first greater one
+      auto* pos = list.next;
+      while (back.is_linked()) {
+        auto* next = back.next;
+        while (pos != &list && !is_before(next, pos)) pos = pos->next;
+        next->unlink();
+        link::insert_after(pos->prev, next);
+      }
+    }
+
+    // Earliest latest expiry of a slot's requests
+    static std::chrono::steady_clock::time_point earliest(link const& slot) noexcept {
+      auto expiry = std::chrono::steady_clock::time_point::max();
+      for (auto const* node = slot.next; node != &slot; node = node->next) {
+        expiry = std::min(expiry, static_cast<request const*>(node)->latest());
+      }
+      return expiry;
+    }
+
+    // Re-schedules the requests of a slot relative to the current tick;
+    // returns the slot index so the caller knows whether the level wrapped
+    std::uint32_t cascade_level(std::uint32_t level) noexcept {
+      auto const index = static_cast<std::uint32_t>((next_tick >> (slot_bits * level)) & (slots - 1));
+      link pending;
+      pending.splice(wheel[level][index]);
+      while (pending.is_linked()) {
+        auto* req = static_cast<request*>(pending.next);
+        req->unlink();
+        schedule(req);
+      }
+      return index;
+    }
+
+    // Cascades every level that wraps at the current tick, highest last;
+    // once per tick, as later requests in those slots belong to the next turn
+    void cascade() noexcept {
+      if ((next_tick & (slots - 1)) || cascaded == next_tick) return;
+      cascaded = next_tick;
+      for (std::uint32_t level = 1; level < levels && !cascade_level(level); level++) {}
+    }
+
+    // Latest expiry of the earliest request when it is on the first level;
+    // otherwise the start of the tick at which the next cascade may bring
+    // one down
+    std::chrono::steady_clock::time_point next_expiry() noexcept {
+      cascade();
+
+      auto const tick = next_busy_tick();
+      if (tick == std::numeric_limits<std::uint64_t>::max()) return std::chrono::steady_clock::time_point::max();
+
+      // The first level holds the next turn only, so an occupied slot there
+      // belongs to this tick
+      auto const& slot = wheel[0][tick & (slots - 1)];
+      if (tick < next_tick + slots && slot.is_linked()) return earliest(slot);
+      return epoch + resolution * (tick - 1);
+    }
+
+    request_id_type acquire_id(request* req) {
+      std::uint32_t index;
+      if (!free.empty()) {
+        index = free.back();
+        free.pop_back();
+        requests[index] = req;
+      } else {
+        index = static_cast<std::uint32_t>(requests.size());
+        requests.push_back(req);
+        generations.push_back(0);
+      }
+      count++;
+      return (static_cast<request_id_type>(generations[index]) << 32) | index;
+    }
+
+    void release_id(request_id_type id) noexcept {
+      auto const index = static_cast<std::uint32_t>(id);
+      requests[index] = nullptr;
+      generations[index]++;
+      free.push_back(index);
+      count--;
+    }
+
+    request* find(request_id_type id) const noexcept {
+      auto const index = static_cast<std::uint32_t>(id);
+      if (index >= requests.size() || generations[index] != static_cast<std::uint32_t>(id >> 32)) return nullptr;
+      return requests[index];
+    }
+
+    timer_type timer;
+    std::weak_ptr<loop_type> loop;
+    std::chrono::steady_clock::duration resolution;
+    std::chrono::steady_clock::duration max_slack;
+    std::chrono::steady_clock::time_point const epoch;
+    std::chrono::steady_clock::time_point armed;
+    std::uint64_t next_tick;
+    std::uint64_t cascaded;
+    std::size_t count;
+    std::array<std::array<link, slots>, levels> wheel;
+    std::array<std::array<std::uint64_t, slots / 64>, levels> occupied{};
+    std::vector<request*> requests;
+    std::vector<std::uint32_t> generations;
+    std::vector<std::uint32_t> free;
   };
 
 public:
   basic_timer_wheel(std::weak_ptr<loop_type> const& loop)
         : impl_{ std::make_unique<basic_timer_wheel_impl>(loop) } {
-    impl_->timer.set_timeout(default_resolution);
-    impl_->timer.set_callback([this] { bookkeeper(); });
+    impl_->timer.template set_callback<&basic_timer_wheel::bookkeeper>(this);
   }
 
   template<typename R, typename D>
   basic_timer_wheel(std::weak_ptr<loop_type> const& loop,
         std::chrono::duration<R, D> const& res)
         : basic_timer_wheel(loop) {
-    impl_->timer.set_timeout(res);
+    impl_->resolution = std::max<std::chrono::steady_clock::duration>(
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(res), std::chrono::steady_clock::duration(1));
   }
 
   explicit basic_timer_wheel(basic_timer_wheel&& other) noexcept : impl_{ std::move(other.impl_) } {
-    impl_->timer.set_callback([this] { bookkeeper(); });
+    impl_->timer.template set_callback<&basic_timer_wheel::bookkeeper>(this);
     other.impl_ = nullptr;
   }
 
@@ -125,51 +369,70 @@ public:
 
   basic_timer_wheel& operator =(basic_timer_wheel&& other) noexcept {
     impl_ = std::move(other.impl_);
-    impl_->timer.set_callback([this] { bookkeeper(); });
+    impl_->timer.template set_callback<&basic_timer_wheel::bookkeeper>(this);
     other.impl_ = nullptr;
     return *this;
   }
 
   void start() noexcept {
-    if (impl_->requests.size() && !impl_->timer.is_active()) impl_->timer.start();
+    if (impl_->count && !impl_->timer.is_active()) arm();
   }
 
   void stop() noexcept {
-		impl_->timer.stop();
+    impl_->armed = std::chrono::steady_clock::time_point::max();
+    impl_->timer.stop();
   }
 
   template<typename Callable, typename R, typename D>
-  request_id_type post(Callable&& cb, std::chrono::duration<R, D> const& timeout) {
-    auto req = make_request(std::forward<Callable>(cb));
-    req->id = impl_->get_next_request_id();
-    req->is_cancelled = false;
-    req->timeout = std::chrono::duration_cast<std::chrono::milliseconds>(timeout);
-    req->expiry = impl_->get_absolute_expiry(timeout);
-
-    impl_->requests.emplace(std::make_pair(req->id, req));
-    impl_->time_hiearchy.emplace(std::make_pair(req->expiry, req));
-
-    start();
+  request_id_type post(Callable&& cb, std::chrono::duration<R, D> const& timeout,
+        std::chrono::steady_clock::duration const& slack = std::chrono::steady_clock::duration::zero()) {
+    return post_at(std::forward<Callable>(cb), std::chrono::steady_clock::now() + timeout, slack);
+  }
 
-    return req->id;
+  // Fires once `expiry` has passed, and no later than `expiry + slack`
+  // unless the loop is busy. A later reset() restarts the request with the
+  // delay it had when posted.
+  template<typename Callable>
+  request_id_type post_at(Callable&& cb, std::chrono::steady_clock::time_point const& expiry,
+        std::chrono::steady_clock::duration const& slack = std::chrono::steady_clock::duration::zero()) {
+    // Nothing to catch up on in an empty wheel
+    if (!impl_->count) impl_->next_tick = impl_->tick_at(std::chrono::steady_clock::now());
+
+    auto req = std::make_unique<request_impl<Callable>>(std::forward<Callable>(cb));
+    req->timeout = expiry - std::chrono::steady_clock::now();
+    req->when = expiry;
+    req->slack = std::max(slack, std::chrono::steady_clock::duration::zero());
+    req->expiry = impl_->tick_of(req->latest());
+    req->id = impl_->acquire_id(req.get());
+    impl_->max_slack = std::max(impl_->max_slack, req->slack);
+    impl_->schedule(req.get());
+    if (req->latest() < impl_->armed) arm();
+
+    return req.release()->id;
   }
 
   void cancel(request_id_type request_id) {
-    auto it = impl_->requests.find(request_id);
-    if (it != impl_->requests.end()) {
-      it->second->is_cancelled = true;
-    } else {
-      throw std::out_of_range{ "timer_wheel::cancel: request id not found" };
-    }
+    auto* req = impl_->find(request_id);
+    if (!req) throw std::out_of_range{ "timer_wheel::cancel: request id not found" };
+
+    // A request being processed is no longer linked; it is freed after its
+    // callback returns
+    if (!req->is_linked()) return;
+    req->unlink();
+    impl_->release_id(req->id);
+    delete req;
   }
 
   void reset(request_id_type request_id) {
-    auto it = impl_->requests.find(request_id);
-    if (it != impl_->requests.end()) {
-      it->second->expiry = impl_->get_absolute_expiry(it->second->timeout);
-    } else {
-      throw std::out_of_range{ "timer_wheel::reset: request id not found" };
-    }
+    auto* req = impl_->find(request_id);
+    if (!req) throw std::out_of_range{ "timer_wheel::reset: request id not found" };
+    if (!req->is_linked()) return;
+
+    req->unlink();
+    req->when = std::chrono::steady_clock::now() + req->timeout;
+    req->expiry = impl_->tick_of(req->latest());
+    impl_->schedule(req);
+    if (req->latest() < impl_->armed) arm();
   }
 
   bool is_active() const noexcept {
@@ -177,32 +440,88 @@ public:
   }
 
   bool is_pending() const noexcept {
-    return !impl_->requests.empty();
+    return impl_->count != 0;
   }
 
 private:
+  void arm() noexcept {
+    if (!impl_->count) {
+      stop();
+      return;
+    }
+
+    impl_->armed = impl_->next_expiry();
+    impl_->timer.arm(std::max(impl_->armed - std::chrono::steady_clock::now(),
+          std::chrono::steady_clock::duration::zero()));
+  }
+
+  std::size_t process(link& expired) noexcept {
+    basic_timer_wheel_impl::sort(expired);
+
+    std::size_t processed = 0;
+    for (; expired.is_linked(); processed++) {
+      auto* req = static_cast<request*>(expired.next);
+      req->unlink();
+      {
+        cyan::trace::scope scope{ "timer_wheel::bookkeeper", "event" };
+        req->process();
+      }
+      impl_->release_id(req->id);
+      delete req;
+    }
+    return processed;
+  }
+
   void bookkeeper() noexcept {
     auto const now = std::chrono::steady_clock::now();
+    auto const tick = impl_->tick_at(now);
+    std::size_t expired_count = 0;
+    std::size_t coalesced = 0;
+    // Posts from the callbacks below are covered by arming once at the end
+    impl_->armed = std::chrono::steady_clock::time_point::min();
+
+    while (impl_->count && impl_->next_tick <= tick) {
+      impl_->cascade();
+
+      link expired;
+      expired.splice(impl_->wheel[0][impl_->next_tick & (slots - 1)]);
+      // Requests posted from the callbacks below land on a later tick
+      impl_->next_tick++;
+      expired_count += process(expired);
+
+      // Skip the ticks with nothing to fire or cascade
+      if (impl_->count) impl_->next_tick = std::min(impl_->next_busy_tick(), tick + 1);
+    }
 
-    for (auto i = impl_->time_hiearchy.begin(); i != impl_->time_hiearchy.end();) {
-      auto& entry = *i;
-      if (entry.second->expiry != entry.first) {
-        auto rep = entry.second;
-        i = impl_->time_hiearchy.erase(i);
-        i = impl_->time_hiearchy.emplace(std::make_pair(rep->expiry, rep));
-      } else if ((entry.first - now).count() <= 0) {
-        if (!entry.second->is_cancelled) {
-          entry.second->process();
+    // Requests of the tick in progress that are due by `now`, and ones
+    // further out whose slack window has opened; ones posted by their
+    // callbacks wait for the next wakeup
+    if (impl_->count) {
+      impl_->cascade();
+
+      link expired;
+      auto const horizon = now + impl_->max_slack;
+      for (auto t = impl_->next_tick; t < impl_->next_tick + slots; t++) {
+        if (t && impl_->epoch + impl_->resolution * (t - 1) > horizon) break;
+
+        auto& slot = impl_->wheel[0][t & (slots - 1)];
+        for (auto* node = slot.next; node != &slot;) {
+          auto* req = static_cast<request*>(node);
+          node = node->next;
+          if (req->when <= now) {
+            if (req->latest() > now) coalesced++;
+            req->unlink();
+            expired.push_back(req);
+          }
         }
-
-        impl_->requests.erase(entry.second->id);
-        i = impl_->time_hiearchy.erase(i);
-      } else {
-        break;
       }
+      expired_count += process(expired);
     }
 
-    if (impl_->time_hiearchy.empty()) stop();
+    if (auto loop = impl_->loop.lock()) loop->on_timer_wakeup(expired_count, coalesced);
+
+    // Unless a callback stopped the wheel
+    if (impl_->armed != std::chrono::steady_clock::time_point::max()) arm();
   }
 
   std::unique_ptr<basic_timer_wheel_impl> impl_;
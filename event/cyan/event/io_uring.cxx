@@ -0,0 +1,559 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/event/io_uring.h>
+
+#ifdef CYAN_EVENT_HAVE_IO_URING
+
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+namespace cyan::event {
+inline namespace v1 {
+
+namespace detail {
+
+namespace {
+
+std::int32_t io_uring_setup(std::uint32_t entries, ::io_uring_params* params) noexcept {
+  return static_cast<std::int32_t>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+std::int32_t io_uring_enter(std::int32_t fd, std::uint32_t to_submit, std::uint32_t min_complete,
+      std::uint32_t flags) noexcept {
+  return static_cast<std::int32_t>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+        nullptr, 0));
+}
+
+std::int32_t io_uring_register(std::int32_t fd, std::uint32_t opcode, void const* arg,
+      std::uint32_t count) noexcept {
+  return static_cast<std::int32_t>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+[[noreturn]] void throw_errno(std::int32_t error, char const* what) {
+  throw std::system_error{ error, std::system_category(), what };
+}
+
+template<typename T>
+T load_acquire(T const* p) noexcept {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template<typename T>
+void store_release(T* p, T value) noexcept {
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+struct mapping {
+  void* data = MAP_FAILED;
+  std::size_t size = 0;
+
+  mapping() noexcept = default;
+  mapping(mapping&& other) noexcept : data{ other.data }, size{ other.size } {
+    other.data = MAP_FAILED;
+  }
+  mapping(mapping const&) = delete;
+  mapping& operator =(mapping const&) = delete;
+
+  ~mapping() {
+    if (data != MAP_FAILED) ::munmap(data, size);
+  }
+
+  void map(std::size_t bytes, std::int32_t fd, std::uint64_t offset) {
+    size = bytes;
+    data = fd < 0 ?
+        ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0) :
+        ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (data == MAP_FAILED) throw_errno(errno, "io_uring mmap");
+  }
+
+  template<typename T>
+  T* at(std::uint32_t offset) const noexcept {
+    return reinterpret_cast<T*>(static_cast<char*>(data) + offset);
+  }
+};
+
+struct buffer_group {
+  mapping ring;
+  std::unique_ptr<std::uint8_t[]> storage;
+  std::uint32_t size = 0;
+  std::uint16_t count = 0;
+  std::uint16_t tail = 0;
+
+  // The ring's tail overlays the first entry's reserved field; the entries
+  // are addressed directly since the header's flexible array member is laid
+  // out differently when compiled as C++
+  ::io_uring_buf* entries() const noexcept {
+    return static_cast<::io_uring_buf*>(ring.data);
+  }
+
+  std::uint8_t* data(std::uint16_t id) const noexcept {
+    return storage.get() + std::size_t(id) * size;
+  }
+
+  void provide(std::uint16_t id) noexcept {
+    auto& entry = entries()[tail & (count - 1)];
+    entry.addr = reinterpret_cast<std::uint64_t>(data(id));
+    entry.len = size;
+    entry.bid = id;
+    store_release(&entries()->resv, ++tail);
+  }
+};
+
+struct operation {
+  operation() noexcept = default;
+  explicit operation(ring::completion_type&& completion) noexcept : completion{ std::move(completion) } {}
+
+  ring::completion_type completion;
+  ring::receive_completion_type receive_completion;
+  std::uint32_t generation = 1;
+  std::uint16_t group = 0;
+  bool live = false;
+};
+
+} // <anonymous>
+
+struct ring_state {
+  std::int32_t fd = -1;
+  mapping sq;
+  mapping cq;
+  mapping sqes;
+
+  std::uint32_t* sq_head = nullptr;
+  std::uint32_t* sq_tail = nullptr;
+  std::uint32_t* sq_flags = nullptr;
+  std::uint32_t sq_mask = 0;
+  std::uint32_t sq_entries = 0;
+  std::uint32_t sq_local_tail = 0;
+
+  std::uint32_t* cq_head = nullptr;
+  std::uint32_t* cq_tail = nullptr;
+  std::uint32_t cq_mask = 0;
+  ::io_uring_cqe* cqes = nullptr;
+
+  std::vector<operation> operations;
+  std::vector<std::uint32_t> free;
+  std::size_t live = 0;
+
+  std::uint32_t files = 0;
+  std::vector<std::int32_t> file_slots;
+  std::vector<std::int32_t> free_slots;
+
+  std::unordered_map<std::uint16_t, buffer_group> groups;
+  std::uint32_t processing = 0;
+
+  ~ring_state() {
+    if (fd >= 0) ::close(fd);
+  }
+
+  std::uint32_t queued() const noexcept {
+    return sq_local_tail - *sq_tail;
+  }
+
+  ::io_uring_sqe* next_entry(ring& owner) {
+    if (sq_local_tail - load_acquire(sq_head) == sq_entries) owner.submit();
+
+    auto entry = sqes.at<::io_uring_sqe>(0) + (sq_local_tail++ & sq_mask);
+    *entry = ::io_uring_sqe{};
+    return entry;
+  }
+
+  void set_file(::io_uring_sqe* entry, std::int32_t target) const noexcept {
+    if (target >= 0 && std::size_t(target) < file_slots.size() && file_slots[target] >= 0) {
+      entry->fd = file_slots[target];
+      entry->flags |= IOSQE_FIXED_FILE;
+    } else {
+      entry->fd = target;
+    }
+  }
+
+  std::uint64_t acquire(operation&& op) {
+    std::uint32_t index;
+    if (free.empty()) {
+      index = static_cast<std::uint32_t>(operations.size());
+      operations.emplace_back();
+    } else {
+      index = free.back();
+      free.pop_back();
+    }
+
+    auto& slot = operations[index];
+    auto generation = slot.generation;
+    slot = std::move(op);
+    slot.generation = generation;
+    slot.live = true;
+    return (std::uint64_t(generation) << 32) | index;
+  }
+
+  std::uint64_t commit(ring& owner, ::io_uring_sqe* entry, operation&& op) {
+    auto id = acquire(std::move(op));
+    entry->user_data = id;
+    if (++live == 1) owner.on_pending_changed(true);
+    if (!processing) owner.submit();
+    return id;
+  }
+
+  operation* find(std::uint64_t id) noexcept {
+    auto index = static_cast<std::uint32_t>(id);
+    if (index >= operations.size()) return nullptr;
+
+    auto& slot = operations[index];
+    if (!slot.live || slot.generation != static_cast<std::uint32_t>(id >> 32)) return nullptr;
+    return &slot;
+  }
+
+  void release(ring& owner, std::uint32_t index) {
+    auto& slot = operations[index];
+    slot.completion = nullptr;
+    slot.receive_completion = nullptr;
+    slot.live = false;
+    if (++slot.generation == 0) slot.generation = 1;
+    free.push_back(index);
+    if (--live == 0) owner.on_pending_changed(false);
+  }
+};
+
+ring::ring(std::uint32_t entries, std::uint32_t files) : state_{ std::make_unique<ring_state>() } {
+  ::io_uring_params params{};
+  params.flags = IORING_SETUP_CLAMP;
+
+  state_->fd = io_uring_setup(entries, &params);
+  if (state_->fd < 0) throw_errno(errno, "io_uring_setup");
+
+  if (!(params.features & IORING_FEAT_NODROP)) {
+    throw_errno(ENOSYS, "io_uring_setup");
+  }
+
+  std::size_t sq_bytes = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+  std::size_t cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) sq_bytes = cq_bytes = std::max(sq_bytes, cq_bytes);
+
+  auto& state = *state_;
+  state.sq.map(sq_bytes, state.fd, IORING_OFF_SQ_RING);
+  state.cq.map(cq_bytes, state.fd, IORING_OFF_CQ_RING);
+  state.sqes.map(params.sq_entries * sizeof(::io_uring_sqe), state.fd, IORING_OFF_SQES);
+
+  state.sq_head = state.sq.at<std::uint32_t>(params.sq_off.head);
+  state.sq_tail = state.sq.at<std::uint32_t>(params.sq_off.tail);
+  state.sq_flags = state.sq.at<std::uint32_t>(params.sq_off.flags);
+  state.sq_mask = *state.sq.at<std::uint32_t>(params.sq_off.ring_mask);
+  state.sq_entries = *state.sq.at<std::uint32_t>(params.sq_off.ring_entries);
+  state.sq_local_tail = *state.sq_tail;
+
+  auto array = state.sq.at<std::uint32_t>(params.sq_off.array);
+  for (std::uint32_t i = 0; i < state.sq_entries; ++i) array[i] = i;
+
+  state.cq_head = state.cq.at<std::uint32_t>(params.cq_off.head);
+  state.cq_tail = state.cq.at<std::uint32_t>(params.cq_off.tail);
+  state.cq_mask = *state.cq.at<std::uint32_t>(params.cq_off.ring_mask);
+  state.cqes = state.cq.at<::io_uring_cqe>(params.cq_off.cqes);
+
+  state.files = files;
+}
+
+ring::~ring() = default;
+
+std::int32_t ring::native_handle() const noexcept {
+  return state_->fd;
+}
+
+ring::operation_id_type ring::receive(std::int32_t fd, void* data, std::size_t size, std::int32_t flags,
+      completion_type&& completion) {
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_RECV;
+  state_->set_file(entry, fd);
+  entry->addr = reinterpret_cast<std::uint64_t>(data);
+  entry->len = static_cast<std::uint32_t>(size);
+  entry->msg_flags = static_cast<std::uint32_t>(flags);
+  return state_->commit(*this, entry, operation{ std::move(completion) });
+}
+
+ring::operation_id_type ring::send(std::int32_t fd, void const* data, std::size_t size, std::int32_t flags,
+      completion_type&& completion) {
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_SEND;
+  state_->set_file(entry, fd);
+  entry->addr = reinterpret_cast<std::uint64_t>(data);
+  entry->len = static_cast<std::uint32_t>(size);
+  entry->msg_flags = static_cast<std::uint32_t>(flags);
+  return state_->commit(*this, entry, operation{ std::move(completion) });
+}
+
+ring::operation_id_type ring::accept(std::int32_t fd, ::sockaddr* address, std::uint32_t* length,
+      completion_type&& completion) {
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_ACCEPT;
+  state_->set_file(entry, fd);
+  entry->addr = reinterpret_cast<std::uint64_t>(address);
+  entry->addr2 = reinterpret_cast<std::uint64_t>(length);
+  entry->accept_flags = SOCK_CLOEXEC;
+  return state_->commit(*this, entry, operation{ std::move(completion) });
+}
+
+ring::operation_id_type ring::connect(std::int32_t fd, ::sockaddr const* address, std::uint32_t length,
+      completion_type&& completion) {
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_CONNECT;
+  state_->set_file(entry, fd);
+  entry->addr = reinterpret_cast<std::uint64_t>(address);
+  entry->off = length;
+  return state_->commit(*this, entry, operation{ std::move(completion) });
+}
+
+ring::operation_id_type ring::multishot_accept(std::int32_t fd, completion_type&& completion) {
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_ACCEPT;
+  entry->ioprio = IORING_ACCEPT_MULTISHOT;
+  state_->set_file(entry, fd);
+  entry->accept_flags = SOCK_CLOEXEC;
+  return state_->commit(*this, entry, operation{ std::move(completion) });
+}
+
+ring::operation_id_type ring::multishot_receive(std::int32_t fd, std::uint16_t group,
+      receive_completion_type&& completion) {
+  if (!state_->groups.count(group)) throw std::out_of_range{ "unknown buffer group" };
+
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_RECV;
+  entry->ioprio = IORING_RECV_MULTISHOT;
+  entry->flags = IOSQE_BUFFER_SELECT;
+  entry->buf_group = group;
+  state_->set_file(entry, fd);
+
+  operation op;
+  op.receive_completion = std::move(completion);
+  op.group = group;
+  return state_->commit(*this, entry, std::move(op));
+}
+
+void ring::cancel(operation_id_type id) {
+  if (!state_->find(id)) return;
+
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_ASYNC_CANCEL;
+  entry->fd = -1;
+  entry->addr = id;
+  if (!state_->processing) submit();
+}
+
+void ring::cancel_all(std::int32_t fd) {
+  auto entry = state_->next_entry(*this);
+  entry->opcode = IORING_OP_ASYNC_CANCEL;
+  entry->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+  state_->set_file(entry, fd);
+  if (entry->flags & IOSQE_FIXED_FILE) {
+    entry->flags &= ~IOSQE_FIXED_FILE;
+    entry->cancel_flags |= IORING_ASYNC_CANCEL_FD_FIXED;
+  }
+  if (!state_->processing) submit();
+}
+
+void ring::register_buffers(std::uint16_t group, std::uint16_t count, std::uint32_t size) {
+  if (count == 0 || (count & (count - 1))) throw std::invalid_argument{ "buffer count must be a power of two" };
+  if (state_->groups.count(group)) throw std::invalid_argument{ "buffer group already registered" };
+
+  buffer_group buffers;
+  buffers.ring.map(count * sizeof(::io_uring_buf), -1, 0);
+  buffers.storage = std::make_unique<std::uint8_t[]>(std::size_t(count) * size);
+  buffers.size = size;
+  buffers.count = count;
+
+  ::io_uring_buf_reg reg{};
+  reg.ring_addr = reinterpret_cast<std::uint64_t>(buffers.ring.data);
+  reg.ring_entries = count;
+  reg.bgid = group;
+  if (io_uring_register(state_->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    throw_errno(errno, "io_uring_register");
+  }
+
+  for (std::uint16_t id = 0; id < count; ++id) buffers.provide(id);
+  state_->groups.emplace(group, std::move(buffers));
+}
+
+void ring::unregister_buffers(std::uint16_t group) {
+  auto it = state_->groups.find(group);
+  if (it == state_->groups.end()) return;
+
+  ::io_uring_buf_reg reg{};
+  reg.bgid = group;
+  io_uring_register(state_->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+  state_->groups.erase(it);
+}
+
+void ring::register_file(std::int32_t fd) {
+  auto& state = *state_;
+  if (fd < 0 || is_registered(fd)) return;
+
+  if (state.free_slots.empty()) {
+    if (state.files == 0) throw std::length_error{ "file table is full" };
+
+    std::vector<std::int32_t> table(state.files, -1);
+    if (io_uring_register(state.fd, IORING_REGISTER_FILES, table.data(), state.files) < 0) {
+      throw_errno(errno, "io_uring_register");
+    }
+    for (auto slot = std::int32_t(state.files); slot-- > 0;) state.free_slots.push_back(slot);
+    state.files = 0;
+  }
+
+  ::io_uring_files_update update{};
+  update.offset = static_cast<std::uint32_t>(state.free_slots.back());
+  update.fds = reinterpret_cast<std::uint64_t>(&fd);
+  if (io_uring_register(state.fd, IORING_REGISTER_FILES_UPDATE, &update, 1) < 0) {
+    throw_errno(errno, "io_uring_register");
+  }
+
+  if (state.file_slots.size() <= std::size_t(fd)) state.file_slots.resize(fd + 1, -1);
+  state.file_slots[fd] = state.free_slots.back();
+  state.free_slots.pop_back();
+}
+
+void ring::unregister_file(std::int32_t fd) {
+  auto& state = *state_;
+  if (!is_registered(fd)) return;
+
+  std::int32_t none = -1;
+  ::io_uring_files_update update{};
+  update.offset = static_cast<std::uint32_t>(state.file_slots[fd]);
+  update.fds = reinterpret_cast<std::uint64_t>(&none);
+  io_uring_register(state.fd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+
+  state.free_slots.push_back(state.file_slots[fd]);
+  state.file_slots[fd] = -1;
+}
+
+bool ring::is_registered(std::int32_t fd) const noexcept {
+  return fd >= 0 && std::size_t(fd) < state_->file_slots.size() && state_->file_slots[fd] >= 0;
+}
+
+std::size_t ring::submit() {
+  auto& state = *state_;
+  std::uint32_t count = state.queued();
+  if (count == 0) return 0;
+
+  store_release(state.sq_tail, state.sq_local_tail);
+
+  std::int32_t submitted;
+  do {
+    submitted = io_uring_enter(state.fd, count, 0, 0);
+  } while (submitted < 0 && errno == EINTR);
+
+  if (submitted < 0) throw_errno(errno, "io_uring_enter");
+  return static_cast<std::size_t>(submitted);
+}
+
+std::size_t ring::process() {
+  auto& state = *state_;
+  std::size_t processed = 0;
+
+  struct guard {
+    std::uint32_t& processing;
+
+    ~guard() {
+      --processing;
+    }
+  } batch{ ++state.processing };
+
+  for (;;) {
+    std::uint32_t head = *state.cq_head;
+    std::uint32_t tail = load_acquire(state.cq_tail);
+
+    if (head == tail) {
+      if (!(load_acquire(state.sq_flags) & IORING_SQ_CQ_OVERFLOW)) break;
+      io_uring_enter(state.fd, 0, 0, IORING_ENTER_GETEVENTS);
+      continue;
+    }
+
+    for (; head != tail; ++head) {
+      auto const& cqe = state.cqes[head & state.cq_mask];
+      std::uint64_t id = cqe.user_data;
+      std::int32_t result = cqe.res;
+      std::uint32_t flags = cqe.flags;
+      store_release(state.cq_head, head + 1);
+
+      if (id == invalid_operation) continue;
+
+      auto op = state.find(id);
+      if (!op) continue;
+      ++processed;
+
+      auto index = static_cast<std::uint32_t>(id);
+      bool more = has_more(flags);
+
+      if (op->receive_completion) {
+        auto completion = std::move(op->receive_completion);
+        auto group = op->group;
+        auto buffers = state.groups.find(group);
+        if (!more) state.release(*this, index);
+
+        if ((flags & IORING_CQE_F_BUFFER) && buffers != state.groups.end()) {
+          auto buffer = static_cast<std::uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+          completion(result, buffers->second.data(buffer), flags);
+          if ((buffers = state.groups.find(group)) != state.groups.end()) buffers->second.provide(buffer);
+        } else {
+          completion(result, nullptr, flags);
+        }
+
+        if (more && (op = state.find(id))) op->receive_completion = std::move(completion);
+      } else {
+        auto completion = std::move(op->completion);
+        if (!more) state.release(*this, index);
+
+        if (completion) completion(result, flags);
+
+        if (more && (op = state.find(id))) op->completion = std::move(completion);
+      }
+    }
+  }
+
+  if (state.processing == 1) submit();
+  return processed;
+}
+
+std::size_t ring::pending() const noexcept {
+  return state_->live;
+}
+
+void ring::on_pending_changed(bool) {
+}
+
+bool ring::has_more(std::uint32_t flags) noexcept {
+  return flags & IORING_CQE_F_MORE;
+}
+
+} // detail
+
+} // v1
+} // cyan::event
+
+#endif // CYAN_EVENT_HAVE_IO_URING
@@ -0,0 +1,127 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <cyan/config.h>
+#include <cyan/noncopyable.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#define CYAN_EVENT_HAVE_IO_URING 1
+#endif
+
+#ifdef CYAN_EVENT_HAVE_IO_URING
+
+struct sockaddr;
+
+namespace cyan::event {
+inline namespace v1 {
+
+namespace detail {
+
+struct ring_state;
+
+// A Linux io_uring instance driven through the raw system calls. Operations
+// are queued as submission entries and identified by a generation-checked
+// id; each one completes by invoking its callback from `process` with the
+// kernel's result, a negated errno on failure. Multishot operations keep
+// their id and complete repeatedly until a completion arrives without the
+// `more` flag.
+//
+// Entries queued from inside `process` are submitted together once the
+// batch has been reaped; outside of it every operation is submitted as it
+// is queued. Descriptors registered with `register_file` are used through
+// the ring's fixed file table, which spares the kernel a descriptor lookup
+// per operation. Receives may pick their buffer from a provided buffer
+// group, which is replenished once the completion callback returns.
+class ring : public cyan::noncopyable {
+public:
+  using operation_id_type = std::uint64_t;
+  using completion_type = std::function<void(std::int32_t result, std::uint32_t flags)>;
+  using receive_completion_type = std::function<void(std::int32_t result, void const* data, std::uint32_t flags)>;
+
+  constexpr static operation_id_type invalid_operation = 0;
+  constexpr static std::uint32_t default_entries = 256;
+  constexpr static std::uint32_t default_files = 1024;
+
+  explicit ring(std::uint32_t entries = default_entries, std::uint32_t files = default_files);
+  virtual ~ring();
+
+  // Readable while completions are waiting to be processed
+  std::int32_t native_handle() const noexcept;
+
+  operation_id_type receive(std::int32_t fd, void* data, std::size_t size, std::int32_t flags,
+        completion_type&& completion);
+  operation_id_type send(std::int32_t fd, void const* data, std::size_t size, std::int32_t flags,
+        completion_type&& completion);
+  operation_id_type accept(std::int32_t fd, ::sockaddr* address, std::uint32_t* length,
+        completion_type&& completion);
+  operation_id_type connect(std::int32_t fd, ::sockaddr const* address, std::uint32_t length,
+        completion_type&& completion);
+
+  // Completes once per accepted connection with the new descriptor
+  operation_id_type multishot_accept(std::int32_t fd, completion_type&& completion);
+  // Completes once per received chunk, which is only valid during the call
+  operation_id_type multishot_receive(std::int32_t fd, std::uint16_t group, receive_completion_type&& completion);
+
+  // Completes the operation early with -ECANCELED; unknown or completed ids
+  // are ignored
+  void cancel(operation_id_type id);
+  void cancel_all(std::int32_t fd);
+
+  // Registers `count` buffers of `size` bytes as buffer group `group`;
+  // `count` must be a power of two
+  void register_buffers(std::uint16_t group, std::uint16_t count, std::uint32_t size);
+  void unregister_buffers(std::uint16_t group);
+
+  void register_file(std::int32_t fd);
+  void unregister_file(std::int32_t fd);
+  bool is_registered(std::int32_t fd) const noexcept;
+
+  std::size_t submit();
+  std::size_t process();
+  std::size_t pending() const noexcept;
+
+  static bool has_more(std::uint32_t flags) noexcept;
+
+protected:
+  // Called as the first operation is queued and as the last one completes
+  virtual void on_pending_changed(bool pending);
+
+private:
+  friend struct ring_state;
+
+  std::unique_ptr<ring_state> state_;
+};
+
+} // detail
+
+} // v1
+} // cyan::event
+
+#endif // CYAN_EVENT_HAVE_IO_URING
@@ -0,0 +1,160 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <algorithm>
+
+#include <cyan/event/loop_monitor.h>
+
+namespace cyan::event {
+inline namespace v1 {
+
+namespace detail {
+
+loop_monitor::~loop_monitor() {
+  {
+    std::lock_guard<std::mutex> lock{ handler_mutex_ };
+    stopping_ = true;
+  }
+  watchdog_cv_.notify_all();
+  if (watchdog_.joinable()) watchdog_.join();
+}
+
+void loop_monitor::poll_begin() noexcept {
+  increment(iterations_);
+  iteration_events_ = 0;
+  polled_ = clock::now();
+}
+
+void loop_monitor::poll_end() noexcept {
+  auto const blocked = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - polled_);
+  increment(blocked_ns_, static_cast<std::uint64_t>(blocked.count()));
+}
+
+loop_monitor::clock::time_point loop_monitor::callback_begin(void const* watcher, void const* function,
+      std::type_info const* callable) noexcept {
+  auto const begin = clock::now();
+  // Ordered after running_since_ was cleared, for the watchdog
+  std::atomic_thread_fence(std::memory_order_release);
+  running_watcher_.store(watcher, std::memory_order_relaxed);
+  running_function_.store(function, std::memory_order_relaxed);
+  running_callable_.store(callable, std::memory_order_relaxed);
+  running_since_.store(begin.time_since_epoch().count(), std::memory_order_release);
+  return begin;
+}
+
+void loop_monitor::callback_done(clock::time_point begin) noexcept {
+  auto const duration = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin);
+  auto const ns = static_cast<std::uint64_t>(duration.count());
+  running_since_.store(0, std::memory_order_relaxed);
+
+  increment(events_);
+  increment(callback_ns_, ns);
+  raise(max_callback_ns_, ns);
+  raise(max_events_per_iteration_, ++iteration_events_);
+
+  if (duration <= threshold_) {
+    return;
+  }
+
+  increment(slow_callbacks_);
+  report({ running_watcher_.load(std::memory_order_relaxed), running_function_.load(std::memory_order_relaxed),
+        running_callable_.load(std::memory_order_relaxed), duration, false }, handler_);
+}
+
+void loop_monitor::set_slow_callback_handler(std::chrono::nanoseconds threshold,
+      slow_callback_handler_type&& handler) {
+  {
+    std::lock_guard<std::mutex> lock{ handler_mutex_ };
+    threshold_ = threshold;
+    handler_ = std::move(handler);
+  }
+  watchdog_cv_.notify_all();
+
+  if (threshold != std::chrono::nanoseconds::max() && !watchdog_.joinable()) {
+    watchdog_ = std::thread{ [this] { watch(); } };
+  }
+}
+
+void loop_monitor::report(slow_callback const& slow, slow_callback_handler_type const& handler) {
+  {
+    std::lock_guard<std::mutex> lock{ last_slow_callback_mutex_ };
+    last_slow_callback_ = slow;
+  }
+
+  if (handler) {
+    handler(slow);
+  }
+}
+
+// Polls the callback in progress a few times per threshold, reporting each
+// one at most once, so that a callback that never returns is still seen
+void loop_monitor::watch() {
+  clock::rep reported = 0;
+  std::unique_lock<std::mutex> lock{ handler_mutex_ };
+
+  while (!stopping_) {
+    if (threshold_ == std::chrono::nanoseconds::max()) {
+      watchdog_cv_.wait(lock);
+      continue;
+    }
+
+    auto const period = std::clamp<std::chrono::nanoseconds>(threshold_ / 4,
+          std::chrono::microseconds(100), std::chrono::milliseconds(100));
+    watchdog_cv_.wait_for(lock, period);
+    if (stopping_) break;
+
+    // Checked again after the identifiers, which the next callback may
+    // already have overwritten
+    auto const since = running_since_.load(std::memory_order_acquire);
+    if (!since || since == reported) continue;
+    slow_callback slow{ running_watcher_.load(std::memory_order_relaxed),
+          running_function_.load(std::memory_order_relaxed), running_callable_.load(std::memory_order_relaxed),
+          clock::now() - clock::time_point{ clock::duration{ since } }, true };
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (running_since_.load(std::memory_order_relaxed) != since || slow.duration <= threshold_) continue;
+
+    reported = since;
+    auto handler = handler_;
+    lock.unlock();
+    report(slow, handler);
+    lock.lock();
+  }
+}
+
+void loop_monitor::snapshot(loop_metrics& metrics) const {
+  metrics.iterations = iterations_.load(std::memory_order_relaxed);
+  metrics.blocked_time = std::chrono::nanoseconds{ blocked_ns_.load(std::memory_order_relaxed) };
+  metrics.callback_time = std::chrono::nanoseconds{ callback_ns_.load(std::memory_order_relaxed) };
+  metrics.events = events_.load(std::memory_order_relaxed);
+  metrics.max_events_per_iteration = max_events_per_iteration_.load(std::memory_order_relaxed);
+  metrics.max_callback_duration = std::chrono::nanoseconds{ max_callback_ns_.load(std::memory_order_relaxed) };
+  metrics.slow_callbacks = slow_callbacks_.load(std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock{ last_slow_callback_mutex_ };
+  metrics.last_slow_callback = last_slow_callback_;
+}
+
+} // detail
+
+} // v1
+} // cyan::event
@@ -0,0 +1,155 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <typeinfo>
+#include <condition_variable>
+
+#include <cyan/noncopyable.h>
+
+namespace cyan::event {
+inline namespace v1 {
+
+// A callback that ran past the loop's slow-callback threshold.
+//  - watcher: native handle of the watcher whose callback it was.
+//  - function: for callbacks bound with set_callback<&T::method>, the
+//    backend's entry point, which is specific to, and names, the method.
+//  - callable: for the others, the type of the callable given to
+//    set_callback, e.g. the lambda.
+//  - duration: how long the callback ran, or has run so far if it is
+//    still in progress.
+//  - in_progress: reported by the watchdog while the callback still runs.
+struct slow_callback {
+  void const* watcher = nullptr;
+  void const* function = nullptr;
+  std::type_info const* callable = nullptr;
+  std::chrono::nanoseconds duration{ 0 };
+  bool in_progress = false;
+};
+
+// Counters of a loop.
+//  - timer_wakeups: wakeups taken by the timer wheels on the loop.
+//  - timers_expired: requests fired on those wakeups.
+//  - timer_wakeups_saved: requests that fired early within their slack, on
+//    a wakeup taken for another request, instead of taking their own.
+// The rest are kept while the loop is instrumented.
+//  - iterations: passes through the backend's wait for events.
+//  - blocked_time: time spent in that wait.
+//  - callback_time: time spent in watcher callbacks.
+//  - events: callbacks run; max_events_per_iteration is the most in a pass.
+//  - max_callback_duration: the longest callback.
+//  - slow_callbacks: callbacks past the slow-callback threshold, the last
+//    of which is last_slow_callback.
+struct loop_metrics {
+  std::uint64_t timer_wakeups = 0;
+  std::uint64_t timers_expired = 0;
+  std::uint64_t timer_wakeups_saved = 0;
+
+  std::uint64_t iterations = 0;
+  std::chrono::nanoseconds blocked_time{ 0 };
+  std::chrono::nanoseconds callback_time{ 0 };
+  std::uint64_t events = 0;
+  std::uint64_t max_events_per_iteration = 0;
+  std::chrono::nanoseconds max_callback_duration{ 0 };
+  std::uint64_t slow_callbacks = 0;
+  slow_callback last_slow_callback;
+};
+
+namespace detail {
+
+// For counters written by one thread alone and read from any
+inline void increment(std::atomic<std::uint64_t>& counter, std::uint64_t by = 1) noexcept {
+  counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+// Fed by a loop backend from the loop's thread while the loop is
+// instrumented; read from any thread
+class loop_monitor : public cyan::noncopyable {
+public:
+  using clock = std::chrono::steady_clock;
+  using slow_callback_handler_type = std::function<void(slow_callback const&)>;
+
+  ~loop_monitor();
+
+  // Around the backend's wait for events
+  void poll_begin() noexcept;
+  void poll_end() noexcept;
+  // Around a callback; the watcher is only kept as an identifier, since the
+  // callback may free it
+  clock::time_point callback_begin(void const* watcher, void const* function, std::type_info const* callable) noexcept;
+  void callback_done(clock::time_point begin) noexcept;
+
+  // A finite threshold starts a watchdog thread that reports callbacks
+  // still running past it
+  void set_slow_callback_handler(std::chrono::nanoseconds threshold, slow_callback_handler_type&& handler);
+  void snapshot(loop_metrics& metrics) const;
+
+private:
+  void watch();
+  void report(slow_callback const& slow, slow_callback_handler_type const& handler);
+
+  static void raise(std::atomic<std::uint64_t>& counter, std::uint64_t to) noexcept {
+    if (to > counter.load(std::memory_order_relaxed)) counter.store(to, std::memory_order_relaxed);
+  }
+
+  std::atomic<std::uint64_t> iterations_{ 0 };
+  std::atomic<std::uint64_t> blocked_ns_{ 0 };
+  std::atomic<std::uint64_t> callback_ns_{ 0 };
+  std::atomic<std::uint64_t> events_{ 0 };
+  std::atomic<std::uint64_t> max_events_per_iteration_{ 0 };
+  std::atomic<std::uint64_t> max_callback_ns_{ 0 };
+  std::atomic<std::uint64_t> slow_callbacks_{ 0 };
+
+  clock::time_point polled_;
+  std::uint64_t iteration_events_ = 0;
+  // The callback in progress, for the watchdog; running_since_ is zero
+  // between callbacks
+  std::atomic<void const*> running_watcher_{ nullptr };
+  std::atomic<void const*> running_function_{ nullptr };
+  std::atomic<std::type_info const*> running_callable_{ nullptr };
+  std::atomic<clock::rep> running_since_{ 0 };
+
+  // Written on the owner thread under handler_mutex_, which the watchdog
+  // holds to read them
+  std::chrono::nanoseconds threshold_ = std::chrono::nanoseconds::max();
+  slow_callback_handler_type handler_;
+  std::mutex handler_mutex_;
+  std::condition_variable watchdog_cv_;
+  bool stopping_ = false;
+  std::thread watchdog_;
+
+  mutable std::mutex last_slow_callback_mutex_;
+  slow_callback last_slow_callback_;
+};
+
+} // detail
+
+} // v1
+} // cyan::event
@@ -0,0 +1,127 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <cyan/event/task_queue.h>
+
+#include <memory>
+
+namespace cyan::event {
+inline namespace v1 {
+
+namespace detail {
+
+task_queue::task_queue() noexcept : head_{ &stub_ }, tail_{ &stub_ } {
+}
+
+task_queue::~task_queue() {
+  while (auto n = pop()) {
+    delete n;
+  }
+}
+
+bool task_queue::push(task_type&& task) {
+  auto n = new node;
+  n->task = std::move(task);
+  link(n);
+  return !notified_.exchange(true);
+}
+
+std::size_t task_queue::drain() {
+  // Tasks queued by the ones run here wait for the next drain, so a task
+  // that keeps posting itself cannot starve the loop
+  auto last = head_.load();
+  std::size_t count = 0;
+
+  for (auto n = pop(); n; n = pop()) {
+    std::unique_ptr<node> done{ n };
+    done->task();
+    ++count;
+
+    if (n == last) {
+      break;
+    }
+  }
+
+  // Producers that found the flag set skipped their wakeup; if any of them
+  // got a task in, the flag stays set and `pending` reports it
+  notified_.exchange(false);
+  if (!idle()) {
+    notified_.store(true);
+  }
+
+  return count;
+}
+
+bool task_queue::pending() const noexcept {
+  return notified_.load(std::memory_order_relaxed);
+}
+
+void task_queue::link(node* n) noexcept {
+  n->next.store(nullptr, std::memory_order_relaxed);
+  auto prev = head_.exchange(n);
+  prev->next.store(n, std::memory_order_release);
+}
+
+task_queue::node* task_queue::pop() noexcept {
+  auto tail = tail_;
+  auto next = tail->next.load(std::memory_order_acquire);
+
+  if (tail == &stub_) {
+    if (!next) {
+      return nullptr;
+    }
+
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+
+  // The last node can only be handed out once the stub sits behind it;
+  // if a producer got in first, its link is not complete yet
+  if (tail != head_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+
+  link(&stub_);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+
+  return nullptr;
+}
+
+bool task_queue::idle() const noexcept {
+  return tail_ == &stub_ && head_.load() == &stub_;
+}
+
+} // detail
+
+} // v1
+} // cyan::event
@@ -0,0 +1,77 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+#include <cyan/noncopyable.h>
+
+namespace cyan::event {
+inline namespace v1 {
+
+namespace detail {
+
+// Intrusive multi-producer single-consumer queue of tasks. Any thread may
+// push; a push links its node with one exchange and never waits on other
+// producers. Only the owning loop drains the queue.
+//
+// The queue also tracks whether its consumer has been notified: `push`
+// asks for a wakeup only on the first task after the consumer last went
+// idle, so tasks posted while a drain is underway do not send their own.
+class task_queue : public cyan::noncopyable {
+public:
+  using task_type = std::function<void()>;
+
+  task_queue() noexcept;
+  ~task_queue();
+
+  // Returns true when the consumer must be woken up to drain the queue
+  bool push(task_type&& task);
+  // Runs the tasks queued so far; returns how many ran
+  std::size_t drain();
+  // True after a drain that left tasks behind without a wakeup coming
+  bool pending() const noexcept;
+
+private:
+  struct node {
+    std::atomic<node*> next{ nullptr };
+    task_type task;
+  };
+
+  void link(node* n) noexcept;
+  node* pop() noexcept;
+  bool idle() const noexcept;
+
+  std::atomic<node*> head_;
+  node* tail_;
+  node stub_;
+  std::atomic<bool> notified_{ false };
+};
+
+} // detail
+
+} // v1
+} // cyan::event
@@ -0,0 +1,222 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <csignal>
+#include <future>
+#include <thread>
+
+#include <unistd.h>
+#include <pthread.h>
+
+#include <cyan/event.h>
+using namespace std::chrono_literals;
+
+#ifdef CYAN_EVENT_HAVE_EPOLL
+
+namespace {
+
+using traits = cyan::event::backend_traits<cyan::event::backend::epoll>;
+using loop_type = cyan::event::basic_loop<traits>;
+
+}
+
+class epoll_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(epoll_tests, async) {
+  auto loop = std::make_shared<loop_type>();
+  cyan::event::basic_async<traits> async{ loop };
+  async.set_callback([&loop] { loop->stop(); });
+  async.start();
+
+  std::thread thread{ [&async] { async.send(); } };
+  loop->start();
+  thread.join();
+  EXPECT_FALSE(async.is_pending());
+}
+
+TEST_F(epoll_tests, timer) {
+  using clock = std::chrono::steady_clock;
+
+  auto loop = std::make_shared<loop_type>();
+  cyan::event::basic_timer<traits> timer{ loop };
+  clock::time_point end;
+  timer.set_callback([&end, &loop] {
+    end = clock::now();
+    loop->stop();
+  });
+
+  // Sub-millisecond expiries go through the timerfd unrounded
+  auto const begin = clock::now();
+  timer.arm(300us);
+  EXPECT_TRUE(timer.is_active());
+  loop->start();
+
+  EXPECT_GE(end - begin, 300us);
+  EXPECT_FALSE(timer.is_active());
+
+  auto ticks = 0;
+  timer.set_timeout(1ms);
+  timer.set_callback([&ticks, &loop] {
+    if (++ticks == 3) loop->stop();
+  });
+  timer.start();
+  loop->start();
+  EXPECT_EQ(ticks, 3);
+  EXPECT_TRUE(timer.is_active());
+  EXPECT_EQ(timer.get_timeout(), 1ms);
+}
+
+TEST_F(epoll_tests, io) {
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+
+  auto loop = std::make_shared<loop_type>();
+  cyan::event::basic_timer<traits> timer{ loop };
+  timer.set_callback([&loop] { loop->stop(); });
+
+  // Without reading, level-triggered keeps reporting the byte and
+  // edge-triggered reports it once
+  for (auto edge : { false, true }) {
+    auto calls = 0;
+    cyan::event::basic_io<traits> io{ loop };
+    io.set_file_descriptor(fds[0]);
+    io.set_event_flags(traits::io::event_read | (edge ? traits::io::event_edge : 0));
+    io.set_callback([&calls] (traits::io::event_flags events) {
+      EXPECT_TRUE(events & traits::io::event_read);
+      calls++;
+    });
+    io.start();
+
+    ASSERT_EQ(::write(fds[1], "x", 1), 1);
+    timer.arm(20ms);
+    loop->start();
+    io.stop();
+
+    char byte;
+    ASSERT_EQ(::read(fds[0], &byte, 1), 1);
+    if (edge) {
+      EXPECT_EQ(calls, 1);
+    } else {
+      EXPECT_GT(calls, 1);
+    }
+  }
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_F(epoll_tests, stopped_watcher_is_skipped) {
+  int first[2], second[2];
+  ASSERT_EQ(::pipe(first), 0);
+  ASSERT_EQ(::pipe(second), 0);
+
+  auto loop = std::make_shared<loop_type>();
+  auto a = std::make_unique<cyan::event::basic_io<traits>>(loop);
+  auto b = std::make_unique<cyan::event::basic_io<traits>>(loop);
+  auto calls = 0;
+
+  // Whichever fires first destroys the other, whose event is already
+  // collected in the same batch
+  a->set_callback([&] (traits::io::event_flags) { calls++; b.reset(); loop->stop(); });
+  b->set_callback([&] (traits::io::event_flags) { calls++; a.reset(); loop->stop(); });
+  for (auto [io, fd] : { std::pair{ a.get(), first[0] }, std::pair{ b.get(), second[0] } }) {
+    io->set_file_descriptor(fd);
+    io->set_event_flags(traits::io::event_read);
+    io->start();
+  }
+
+  ASSERT_EQ(::write(first[1], "x", 1), 1);
+  ASSERT_EQ(::write(second[1], "x", 1), 1);
+  loop->start();
+  EXPECT_EQ(calls, 1);
+
+  for (auto fd : { first[0], first[1], second[0], second[1] }) ::close(fd);
+}
+
+TEST_F(epoll_tests, signal_and_idle) {
+  auto loop = std::make_shared<loop_type>();
+  cyan::event::basic_signal<traits> signal{ loop };
+  cyan::event::basic_idle<traits> idle{ loop };
+  auto signalled = false;
+
+  signal.set_number(SIGUSR1);
+  signal.set_callback([&] { signalled = true; loop->stop(); });
+  signal.start();
+  idle.set_callback([&idle] {
+    idle.stop();
+    ::raise(SIGUSR1);
+  });
+  idle.start();
+
+  loop->start();
+  EXPECT_TRUE(signalled);
+  signal.stop();
+}
+
+TEST_F(epoll_tests, signal_to_another_thread) {
+  auto loop = std::make_shared<loop_type>();
+  cyan::event::basic_signal<traits> signal{ loop };
+  cyan::event::basic_idle<traits> idle{ loop };
+  std::atomic<bool> signalled{ false };
+
+  // Delivered to a thread that never blocked it, and still forwarded
+  signal.set_number(SIGUSR2);
+  signal.set_callback([&] { signalled = true; loop->stop(); });
+  signal.start();
+  idle.set_callback([&idle] {
+    idle.stop();
+    std::thread{ [] { ::pthread_kill(::pthread_self(), SIGUSR2); } }.join();
+  });
+  idle.start();
+
+  loop->start();
+  EXPECT_TRUE(signalled);
+  signal.stop();
+}
+
+TEST_F(epoll_tests, timer_wheel) {
+  auto loop = std::make_shared<loop_type>();
+  cyan::event::basic_timer_wheel<traits> timer_wheel{ loop, 1ms };
+  std::vector<int> fired;
+
+  for (auto i : { 3, 1, 2 }) {
+    timer_wheel.post([&fired, i] { fired.push_back(i); }, std::chrono::milliseconds(i));
+  }
+  timer_wheel.post([&loop] { loop->stop(); }, 10ms);
+
+  loop->start();
+  EXPECT_EQ(fired, (std::vector<int>{ 1, 2, 3 }));
+  EXPECT_EQ(loop->get_metrics().timers_expired, 4u);
+}
+
+#endif // CYAN_EVENT_HAVE_EPOLL
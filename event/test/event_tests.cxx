@@ -23,12 +23,43 @@
  **/
 #include <gtest/gtest.h>
 
+#include <csignal>
+#include <mutex>
 #include <thread>
 #include <future>
+#include <typeinfo>
+#include <vector>
+#include <algorithm>
+
+#include <unistd.h>
 
 #include <cyan/event.h>
 using namespace std::chrono_literals;
 
+namespace {
+
+struct counters {
+  void on_async() {
+    async++;
+  }
+
+  void on_timer() {
+    timer++;
+    loop->stop();
+  }
+
+  void on_io(cyan::event::io::event_flags events) {
+    if (events & cyan::event::io::event_read) io++;
+  }
+
+  std::shared_ptr<cyan::event::loop> loop;
+  std::int32_t async = 0;
+  std::int32_t timer = 0;
+  std::int32_t io = 0;
+};
+
+}
+
 // Instead of mocking the backend traits, these
 // tests involve integration testing with the actual
 // event backend, and behavior of the various event
@@ -110,6 +141,31 @@ TEST_F(event_tests, timer) {
   EXPECT_GE(duration, timeout) << "expected " << timeout.count() << "ms; got " << duration.count() << "ms";
 }
 
+TEST_F(event_tests, timer_arm) {
+  using clock = std::chrono::steady_clock;
+
+  cyan::event::timer timer{ cyan::this_thread::get_event_loop() };
+  timer.set_timeout(250us);
+  EXPECT_EQ(timer.get_timeout(), 250us);
+
+  clock::time_point end;
+  timer.set_callback([&end] {
+    end = clock::now();
+    cyan::this_thread::get_event_loop()->stop();
+  });
+
+  // The expiry is rounded up to the next multiple of the slack
+  auto const slack = 10ms;
+  auto const begin = clock::now();
+  timer.arm(1ms, slack);
+  EXPECT_TRUE(timer.is_active());
+  cyan::this_thread::get_event_loop()->start();
+
+  auto const aligned = (begin + 1ms).time_since_epoch() / slack * slack + slack;
+  EXPECT_GE(end.time_since_epoch(), std::chrono::duration_cast<clock::duration>(aligned) - 1ms);
+  EXPECT_FALSE(timer.is_active());
+}
+
 TEST_F(event_tests, timer_wheel) {
   cyan::event::timer_wheel timer_wheel{ cyan::this_thread::get_event_loop() };
 
@@ -136,6 +192,117 @@ TEST_F(event_tests, timer_wheel) {
   EXPECT_EQ(task2.get_future().wait_for(0ms), std::future_status::ready);
 }
 
+TEST_F(event_tests, timer_wheel_ordering) {
+  auto loop = cyan::this_thread::get_event_loop();
+  cyan::event::timer_wheel timer_wheel{ loop, 1ms };
+
+  // Delays past 256 ticks are cascaded down from the upper levels
+  std::vector<int> fired;
+  std::vector<cyan::event::timer_wheel::request_id_type> ids;
+  auto const now = std::chrono::steady_clock::now();
+  for (auto i = 0; i < 1000; i++) {
+    auto const delay = (i * 37) % 300;
+    ids.push_back(timer_wheel.post_at([&fired, delay] { fired.push_back(delay); }, now + std::chrono::milliseconds(delay)));
+  }
+
+  auto cancelled = 0;
+  for (auto i = 0u; i < ids.size(); i += 7, cancelled++) timer_wheel.cancel(ids[i]);
+  EXPECT_THROW(timer_wheel.cancel(ids[0]), std::out_of_range);
+  EXPECT_THROW(timer_wheel.reset(ids[0]), std::out_of_range);
+
+  timer_wheel.post_at([&loop] { loop->stop(); }, now + 320ms);
+
+  loop->start();
+  ASSERT_EQ(fired.size(), ids.size() - cancelled);
+  EXPECT_TRUE(std::is_sorted(fired.begin(), fired.end()));
+  EXPECT_FALSE(timer_wheel.is_pending());
+  EXPECT_FALSE(timer_wheel.is_active());
+}
+
+TEST_F(event_tests, timer_wheel_due_in_order) {
+  auto loop = cyan::this_thread::get_event_loop();
+  cyan::event::timer_wheel timer_wheel{ loop };
+
+  // Posted in reverse into one slot, all due by the first wakeup
+  std::vector<int> fired;
+  auto const now = std::chrono::steady_clock::now();
+  for (auto i = 10; i > 0; i--) {
+    timer_wheel.post_at([&fired, i] { fired.push_back(i); }, now + std::chrono::milliseconds(i));
+  }
+  timer_wheel.post_at([&loop] { loop->stop(); }, now + 11ms);
+  std::this_thread::sleep_for(20ms);
+
+  loop->start();
+  ASSERT_EQ(fired.size(), 10u);
+  EXPECT_TRUE(std::is_sorted(fired.begin(), fired.end()));
+}
+
+TEST_F(event_tests, timer_wheel_tickless) {
+  using clock = std::chrono::steady_clock;
+
+  auto loop = cyan::this_thread::get_event_loop();
+  cyan::event::timer_wheel timer_wheel{ loop };
+
+  // Fires at its own expiry rather than on the next resolution boundary
+  clock::time_point end;
+  auto const begin = clock::now();
+  timer_wheel.post([&end, &loop] {
+    end = clock::now();
+    loop->stop();
+  }, 5ms);
+
+  loop->start();
+  EXPECT_GE(end - begin, 5ms);
+  EXPECT_LT(end - begin, cyan::event::timer_wheel::default_resolution / 2);
+  EXPECT_FALSE(timer_wheel.is_active());
+}
+
+TEST_F(event_tests, timer_wheel_coalescing) {
+  auto loop = cyan::this_thread::get_event_loop();
+  cyan::event::timer_wheel timer_wheel{ loop, 1ms };
+  auto const before = loop->get_metrics();
+
+  // Windows [20ms + i, 40ms + i] all overlap at 40ms, so one wakeup serves
+  // every request
+  auto fired = 0;
+  auto const now = std::chrono::steady_clock::now();
+  for (auto i = 0; i < 10; i++) {
+    timer_wheel.post_at([&fired] { fired++; }, now + 20ms + std::chrono::milliseconds(i), 20ms);
+  }
+  timer_wheel.post_at([&loop] { loop->stop(); }, now + 100ms);
+
+  loop->start();
+  auto const after = loop->get_metrics();
+  EXPECT_EQ(fired, 10);
+  EXPECT_EQ(after.timers_expired - before.timers_expired, 11u);
+  EXPECT_EQ(after.timer_wakeups - before.timer_wakeups, 2u);
+  EXPECT_EQ(after.timer_wakeups_saved - before.timer_wakeups_saved, 9u);
+}
+
+TEST_F(event_tests, timer_wheel_late_wakeup) {
+  using clock = std::chrono::steady_clock;
+
+  auto loop = cyan::this_thread::get_event_loop();
+  cyan::event::timer_wheel timer_wheel{ loop, 1ns };
+
+  // Tens of millions of ticks have passed by the first wakeup; catching up
+  // must not walk them one by one
+  std::vector<int> fired;
+  auto const now = clock::now();
+  timer_wheel.post_at([&fired] { fired.push_back(2); }, now + 2ms);
+  timer_wheel.post_at([&fired] { fired.push_back(1); }, now + 1ms);
+  timer_wheel.post_at([&fired, &loop] {
+    fired.push_back(3);
+    loop->stop();
+  }, now + 3ms);
+  std::this_thread::sleep_for(50ms);
+
+  auto const begin = clock::now();
+  loop->start();
+  EXPECT_LT(clock::now() - begin, 20ms);
+  EXPECT_EQ(fired, (std::vector<int>{ 1, 2, 3 }));
+}
+
 TEST_F(event_tests, signal) {
   cyan::event::signal signal{ cyan::event::get_main_loop() };
   auto promise = std::promise<void>{};
@@ -151,7 +318,7 @@ TEST_F(event_tests, signal) {
   signal.start();
   EXPECT_TRUE(signal.is_active());
 
-  ev_feed_signal(SIGINT);
+  ::raise(SIGINT);
 
   cyan::event::get_main_loop()->start();
   ASSERT_EQ(promise.get_future().wait_for(0ms), std::future_status::ready);
@@ -175,3 +342,244 @@ TEST_F(event_tests, idle) {
   cyan::event::get_main_loop()->start();
   ASSERT_EQ(promise.get_future().wait_for(0ms), std::future_status::ready);
 }
+
+TEST_F(event_tests, member_callbacks) {
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  counters counters{ loop };
+
+  cyan::event::async async{ loop };
+  async.set_callback<&counters::on_async>(&counters);
+  async.start();
+
+  cyan::event::io io{ loop };
+  io.set_file_descriptor(fds[0]);
+  io.set_event_flags(cyan::event::io::event_read);
+  io.set_callback<&counters::on_io>(&counters);
+  io.start();
+
+  cyan::event::timer timer{ loop };
+  timer.set_callback<&counters::on_timer>(&counters);
+  timer.arm(20ms);
+
+  async.send();
+  ASSERT_EQ(::write(fds[1], "x", 1), 1);
+  loop->start();
+  EXPECT_EQ(counters.async, 1);
+  EXPECT_GE(counters.io, 1);
+  EXPECT_EQ(counters.timer, 1);
+
+  // Setting a callable replaces the bound member function
+  io.stop();
+  auto calls = 0;
+  async.set_callback([&calls, &loop] {
+    calls++;
+    loop->stop();
+  });
+  async.send();
+  loop->start();
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(counters.async, 1);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_F(event_tests, post) {
+  constexpr auto producers = 4;
+  constexpr auto tasks = 1000;
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  auto count = 0;
+
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < producers; ++i) {
+    threads.emplace_back([&loop, &count] {
+      for (auto j = 0; j < tasks; ++j) {
+        loop->post([&loop, &count] {
+          if (++count == producers * tasks) loop->stop();
+        });
+      }
+    });
+  }
+
+  loop->start();
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(count, producers * tasks);
+}
+
+TEST_F(event_tests, dispatch) {
+  auto loop = std::make_shared<cyan::event::loop>();
+
+  auto inline_run = false;
+  loop->dispatch([&inline_run] { inline_run = true; });
+  EXPECT_TRUE(inline_run);
+
+  std::thread::id ran_on;
+  std::thread thread{[&loop, &ran_on] {
+    loop->dispatch([&loop, &ran_on] {
+      ran_on = std::this_thread::get_id();
+      loop->stop();
+    });
+  }};
+
+  loop->start();
+  thread.join();
+  EXPECT_EQ(ran_on, std::this_thread::get_id());
+}
+
+TEST_F(event_tests, post_does_not_starve) {
+  auto loop = std::make_shared<cyan::event::loop>();
+
+  // A task that keeps posting itself must leave room for the timer
+  auto reposts = 0;
+  std::function<void()> repost = [&loop, &reposts, &repost] {
+    ++reposts;
+    loop->post([&repost] { repost(); });
+  };
+  loop->post([&repost] { repost(); });
+
+  cyan::event::timer timer{ loop };
+  timer.set_callback([&loop] { loop->stop(); });
+  timer.arm(20ms);
+
+  loop->start();
+  EXPECT_GT(reposts, 1);
+}
+
+TEST_F(event_tests, instrumentation) {
+  auto loop = std::make_shared<cyan::event::loop>();
+
+  // The watchdog reports from its own thread
+  std::mutex mutex;
+  std::vector<cyan::event::slow_callback> reported;
+  loop->set_instrumentation(true);
+  loop->set_slow_callback_handler(2ms, [&mutex, &reported] (cyan::event::slow_callback const& slow) {
+    std::lock_guard<std::mutex> lock{ mutex };
+    reported.push_back(slow);
+  });
+
+  cyan::event::timer slow{ loop };
+  auto sleep = [] { std::this_thread::sleep_for(10ms); };
+  slow.set_callback(sleep);
+  slow.arm(10ms);
+
+  cyan::event::timer done{ loop };
+  done.set_callback([&loop] { loop->stop(); });
+  done.arm(40ms);
+
+  loop->start();
+
+  auto metrics = loop->get_metrics();
+  EXPECT_GT(metrics.iterations, 0u);
+  EXPECT_GE(metrics.events, 2u);
+  EXPECT_GE(metrics.max_events_per_iteration, 1u);
+  EXPECT_GE(metrics.blocked_time, 10ms);
+  EXPECT_GE(metrics.callback_time, 5ms);
+  EXPECT_GE(metrics.max_callback_duration, 5ms);
+  EXPECT_EQ(metrics.slow_callbacks, 1u);
+  EXPECT_EQ(metrics.last_slow_callback.watcher, slow.native_handle());
+  {
+    std::lock_guard<std::mutex> lock{ mutex };
+    // Once while it ran, once as it returned
+    ASSERT_EQ(reported.size(), 2u);
+    EXPECT_TRUE(reported.front().in_progress);
+    EXPECT_GT(reported.front().duration, 2ms);
+    EXPECT_FALSE(reported.back().in_progress);
+    EXPECT_GE(reported.back().duration, 10ms);
+    for (auto const& report : reported) {
+      EXPECT_EQ(report.watcher, slow.native_handle());
+      ASSERT_NE(report.callable, nullptr);
+      EXPECT_EQ(*report.callable, typeid(sleep));
+    }
+  }
+
+  // Without instrumentation only the timer wheel counters move
+  loop->set_instrumentation(false);
+  slow.arm(1ms);
+  done.arm(10ms);
+  loop->start();
+  EXPECT_EQ(loop->get_metrics().events, metrics.events);
+}
+
+TEST_F(event_tests, busy_poll) {
+  auto loop = std::make_shared<cyan::event::loop>();
+
+  auto count = 0;
+  std::thread thread{[&loop, &count] {
+    for (auto i = 0; i < 100; ++i) {
+      loop->post([&loop, &count] {
+        if (++count == 100) loop->stop();
+      });
+    }
+  }};
+
+  loop->start_busy_poll();
+  thread.join();
+  EXPECT_EQ(count, 100);
+
+  // Past its idle budget the loop blocks until the timer is due
+  cyan::event::timer timer{ loop };
+  timer.set_callback([&loop] { loop->stop(); });
+  timer.arm(20ms);
+
+  loop->set_instrumentation(true);
+  loop->start_busy_poll(1ms);
+  auto metrics = loop->get_metrics();
+  EXPECT_GE(metrics.blocked_time, 10ms);
+}
+
+TEST_F(event_tests, run_once) {
+  using clock = std::chrono::steady_clock;
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  EXPECT_EQ(loop->poll(), 0u);
+
+  // Nothing is due: the pass waits out its timeout
+  auto begin = clock::now();
+  EXPECT_EQ(loop->run_once(10ms), 0u);
+  EXPECT_GE(clock::now() - begin, 10ms);
+
+  auto fired = 0;
+  cyan::event::timer first{ loop };
+  first.set_callback([&fired] { fired++; });
+  cyan::event::timer second{ loop };
+  second.set_callback([&fired] { fired++; });
+  first.arm(5ms);
+  second.arm(5ms);
+
+  std::size_t processed = 0;
+  while (fired < 2) processed += loop->run_once(100ms);
+  EXPECT_EQ(processed, 2u);
+
+  auto posted = 0;
+  loop->post([&posted] { posted++; });
+  EXPECT_EQ(loop->poll(), 1u);
+  EXPECT_EQ(posted, 1);
+}
+
+TEST_F(event_tests, run_for) {
+  using clock = std::chrono::steady_clock;
+
+  auto loop = std::make_shared<cyan::event::loop>();
+
+  auto ticks = 0;
+  cyan::event::timer timer{ loop };
+  timer.set_callback([&ticks] { ticks++; });
+  timer.set_timeout(5ms);
+  timer.start();
+
+  auto begin = clock::now();
+  auto processed = loop->run_for(30ms);
+  EXPECT_GE(clock::now() - begin, 30ms);
+  EXPECT_GE(ticks, 2);
+  EXPECT_EQ(processed, static_cast<std::size_t>(ticks));
+
+  // A stop from a callback ends the run before its deadline
+  timer.set_callback([&loop] { loop->stop(); });
+  begin = clock::now();
+  loop->run_until(clock::now() + 1s);
+  EXPECT_LT(clock::now() - begin, 500ms);
+}
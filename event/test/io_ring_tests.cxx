@@ -0,0 +1,240 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cyan/event.h>
+
+#ifdef CYAN_EVENT_HAVE_IO_URING
+
+namespace {
+
+std::int32_t listen_loopback(::sockaddr_in& address) {
+  auto fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  address = ::sockaddr_in{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::socklen_t length = sizeof(address);
+  if (::bind(fd, reinterpret_cast<::sockaddr*>(&address), length) != 0 || ::listen(fd, 16) != 0 ||
+      ::getsockname(fd, reinterpret_cast<::sockaddr*>(&address), &length) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}
+
+class io_ring_tests : public ::testing::Test {
+public:
+  void SetUp() {
+  }
+
+  void TearDown() {
+  }
+};
+
+TEST_F(io_ring_tests, send_receive) {
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  cyan::event::io_ring ring{ loop };
+
+  char data[16] = {};
+  std::int32_t received = 0;
+  std::int32_t sent = 0;
+  ring.receive(fds[0], data, sizeof(data), 0, [&] (std::int32_t result, std::uint32_t) {
+    received = result;
+    loop->stop();
+  });
+  ring.send(fds[1], "hello", 5, 0, [&] (std::int32_t result, std::uint32_t) { sent = result; });
+  EXPECT_EQ(ring.pending(), 2u);
+
+  loop->start();
+  EXPECT_EQ(sent, 5);
+  EXPECT_EQ(received, 5);
+  EXPECT_EQ(std::string(data, 5), "hello");
+  EXPECT_EQ(ring.pending(), 0u);
+
+  // Registered descriptors go through the fixed file table
+  ring.register_file(fds[0]);
+  ring.register_file(fds[1]);
+  EXPECT_TRUE(ring.is_registered(fds[0]));
+
+  received = sent = 0;
+  ring.receive(fds[0], data, sizeof(data), 0, [&] (std::int32_t result, std::uint32_t) {
+    received = result;
+    loop->stop();
+  });
+  ring.send(fds[1], "fixed", 5, 0, [&] (std::int32_t result, std::uint32_t) { sent = result; });
+  loop->start();
+  EXPECT_EQ(received, 5);
+  EXPECT_EQ(std::string(data, 5), "fixed");
+
+  ring.unregister_file(fds[0]);
+  ring.unregister_file(fds[1]);
+  EXPECT_FALSE(ring.is_registered(fds[0]));
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_F(io_ring_tests, accept_connect) {
+  ::sockaddr_in address;
+  auto listener = listen_loopback(address);
+  ASSERT_GE(listener, 0);
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  cyan::event::io_ring ring{ loop };
+
+  auto client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  std::int32_t accepted = -1;
+  std::int32_t connected = -1;
+  auto done = [&] { if (accepted >= 0 && connected == 0) loop->stop(); };
+
+  ring.accept(listener, nullptr, nullptr, [&] (std::int32_t result, std::uint32_t) {
+    accepted = result;
+    done();
+  });
+  ring.connect(client, reinterpret_cast<::sockaddr*>(&address), sizeof(address),
+      [&] (std::int32_t result, std::uint32_t) {
+    connected = result;
+    done();
+  });
+
+  loop->start();
+  EXPECT_GE(accepted, 0);
+  EXPECT_EQ(connected, 0);
+
+  ::close(accepted);
+  ::close(client);
+  ::close(listener);
+}
+
+TEST_F(io_ring_tests, multishot_accept) {
+  ::sockaddr_in address;
+  auto listener = listen_loopback(address);
+  ASSERT_GE(listener, 0);
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  cyan::event::io_ring ring{ loop };
+
+  std::vector<std::int32_t> accepted;
+  std::int32_t last = 0;
+  cyan::event::io_ring::operation_id_type id;
+  id = ring.multishot_accept(listener, [&] (std::int32_t result, std::uint32_t flags) {
+    if (!cyan::event::io_ring::has_more(flags)) {
+      last = result;
+      loop->stop();
+      return;
+    }
+
+    accepted.push_back(result);
+    if (accepted.size() == 3) ring.cancel(id);
+  });
+
+  std::vector<std::int32_t> clients;
+  for (auto i = 0; i < 3; ++i) {
+    clients.push_back(::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    ASSERT_EQ(::connect(clients.back(), reinterpret_cast<::sockaddr*>(&address), sizeof(address)), 0);
+  }
+
+  loop->start();
+  ASSERT_EQ(accepted.size(), 3u);
+  for (auto fd : accepted) EXPECT_GE(fd, 0);
+  EXPECT_EQ(last, -ECANCELED);
+  EXPECT_EQ(ring.pending(), 0u);
+
+  // Cancelling a completed operation is a no-op
+  ring.cancel(id);
+
+  for (auto fd : accepted) ::close(fd);
+  for (auto fd : clients) ::close(fd);
+  ::close(listener);
+}
+
+TEST_F(io_ring_tests, multishot_receive) {
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  cyan::event::io_ring ring{ loop };
+  EXPECT_THROW(ring.register_buffers(1, 3, 64), std::invalid_argument);
+  ring.register_buffers(1, 2, 4);
+
+  std::string received;
+  std::int32_t last = 0;
+  cyan::event::io_ring::operation_id_type id;
+  cyan::event::io_ring::receive_completion_type completion;
+  completion = [&] (std::int32_t result, void const* data, std::uint32_t flags) {
+    // Each chunk lands in a provided buffer, recycled after the callback
+    if (result > 0) {
+      ASSERT_NE(data, nullptr);
+      ASSERT_LE(result, 4);
+      received.append(static_cast<char const*>(data), result);
+      if (received.size() == 26) ring.cancel(id);
+    }
+
+    if (!cyan::event::io_ring::has_more(flags)) {
+      // Running out of buffers ends the operation, which is then rearmed
+      if (result > 0 || result == -ENOBUFS) {
+        id = ring.multishot_receive(fds[0], 1, [&] (std::int32_t r, void const* d, std::uint32_t f) {
+          completion(r, d, f);
+        });
+      } else {
+        last = result;
+        loop->stop();
+      }
+    }
+  };
+  id = ring.multishot_receive(fds[0], 1, [&] (std::int32_t r, void const* d, std::uint32_t f) {
+    completion(r, d, f);
+  });
+
+  // More data than the buffer group holds at once
+  std::string const alphabet = "abcdefghijklmnopqrstuvwxyz";
+  for (std::size_t i = 0; i < alphabet.size(); i += 13) {
+    ASSERT_EQ(::write(fds[1], alphabet.data() + i, 13), 13);
+  }
+
+  loop->start();
+  EXPECT_EQ(received, alphabet);
+  EXPECT_EQ(last, -ECANCELED);
+
+  ring.unregister_buffers(1);
+  EXPECT_THROW(ring.multishot_receive(fds[0], 1, nullptr), std::out_of_range);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+#endif // CYAN_EVENT_HAVE_IO_URING
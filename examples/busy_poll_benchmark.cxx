@@ -0,0 +1,186 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <cyan/event.h>
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::size_t message_size = 64;
+constexpr int busy_poll_us = 50;
+
+// Runs `loop` the way `busy` asks for
+void run_loop(cyan::event::loop& loop, bool busy) {
+  if (busy) {
+    loop.start_busy_poll();
+  } else {
+    loop.start();
+  }
+}
+
+bool read_message(int fd, char* data) {
+  std::size_t read = 0;
+  while (read < message_size) {
+    auto rc = ::read(fd, data + read, message_size - read);
+    if (rc <= 0) return false;
+    read += static_cast<std::size_t>(rc);
+  }
+  return true;
+}
+
+void prepare(int fd, bool busy) {
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_BUSY_POLL
+  if (busy) {
+    int us = busy_poll_us;
+    // Needs CAP_NET_ADMIN to raise above net.core.busy_read; harmless if refused
+    ::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us));
+  }
+#endif // SO_BUSY_POLL
+}
+
+// A connected pair of loopback tcp sockets
+bool connect_pair(int fds[2]) {
+  auto listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  ::sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::socklen_t length = sizeof(address);
+
+  auto ok = listener >= 0
+      && ::bind(listener, reinterpret_cast<::sockaddr*>(&address), length) == 0
+      && ::listen(listener, 1) == 0
+      && ::getsockname(listener, reinterpret_cast<::sockaddr*>(&address), &length) == 0;
+
+  fds[0] = ok ? ::socket(AF_INET, SOCK_STREAM, 0) : -1;
+  ok = ok && fds[0] >= 0 && ::connect(fds[0], reinterpret_cast<::sockaddr*>(&address), length) == 0;
+  fds[1] = ok ? ::accept(listener, nullptr, nullptr) : -1;
+
+  if (listener >= 0) ::close(listener);
+  return ok && fds[1] >= 0;
+}
+
+// Bounces `rounds` messages between a client on this thread and an echo
+// server on another, each running its own loop in the given mode, and
+// reports the round trip times.
+void run(char const* name, bool busy, int rounds) {
+  int fds[2];
+  if (!connect_pair(fds)) {
+    std::cout << name << ": loopback connection failed: " << std::strerror(errno) << std::endl;
+    return;
+  }
+  prepare(fds[0], busy);
+  prepare(fds[1], busy);
+
+  std::promise<std::shared_ptr<cyan::event::loop>> server_loop;
+  std::thread server{[fd = fds[1], busy, &server_loop] {
+    auto loop = std::make_shared<cyan::event::loop>();
+    cyan::event::io io{ loop };
+    io.set_file_descriptor(fd);
+    io.set_event_flags(cyan::event::io::event_read);
+    io.set_callback([fd, &loop] (cyan::event::io::event_flags) {
+      char data[message_size];
+      if (!read_message(fd, data) || ::write(fd, data, message_size) != message_size) loop->stop();
+    });
+    io.start();
+
+    server_loop.set_value(loop);
+    run_loop(*loop, busy);
+    io.stop();
+  }};
+  auto remote = server_loop.get_future().get();
+
+  auto loop = std::make_shared<cyan::event::loop>();
+  std::vector<clock_type::duration> samples;
+  samples.reserve(static_cast<std::size_t>(rounds));
+  char data[message_size] = {};
+  clock_type::time_point sent;
+
+  auto ping = [fd = fds[0], &data, &sent] {
+    sent = clock_type::now();
+    return ::write(fd, data, message_size) == message_size;
+  };
+
+  cyan::event::io io{ loop };
+  io.set_file_descriptor(fds[0]);
+  io.set_event_flags(cyan::event::io::event_read);
+  io.set_callback([fd = fds[0], rounds, &data, &sent, &samples, &ping, &loop] (cyan::event::io::event_flags) {
+    if (!read_message(fd, data)) {
+      loop->stop();
+      return;
+    }
+    samples.push_back(clock_type::now() - sent);
+    if (static_cast<int>(samples.size()) == rounds || !ping()) loop->stop();
+  });
+  io.start();
+
+  if (ping()) run_loop(*loop, busy);
+  io.stop();
+
+  remote->post([remote] { remote->stop(); });
+  server.join();
+  ::close(fds[0]);
+  ::close(fds[1]);
+
+  if (samples.empty()) {
+    std::cout << name << ": no round trips completed" << std::endl;
+    return;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  auto const at = [&samples] (double q) {
+    auto index = static_cast<std::size_t>(q * static_cast<double>(samples.size() - 1));
+    return std::chrono::duration<double, std::micro>(samples[index]).count();
+  };
+  std::cout << name << " " << samples.size() << " round trips: median " << at(.5) << "us, p99 " << at(.99)
+      << "us, p99.9 " << at(.999) << "us, max " << at(1.) << "us" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  auto rounds = argc > 1 ? std::stoi(argv[1]) : 100'000;
+
+  if (std::thread::hardware_concurrency() < 2) {
+    std::cout << "warning: fewer than two cpus, busy-polling threads will share one" << std::endl;
+  }
+
+  run("blocking", false, rounds);
+  run("busy-poll", true, rounds);
+  return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <atomic>
+#include <thread>
+#include <future>
+#include <iostream>
+#include <functional>
+
+#include <cyan/event.h>
+#include <cyan/lockfree/queue.h>
+#include <cyan/dispatch.h>
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int iters = 5'000'000;
+
+void report(char const* name, clock_type::time_point begin, clock_type::time_point end, long sum) {
+  auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+  std::cout << name << ": " << ms << "ms, "
+      << (ms ? iters / ms * 1000 : 0) << " msgs/s (checksum " << sum << ")" << std::endl;
+}
+
+// Producer on the main thread, consumer on a handler_thread woken through a
+// raw lockfree::queue + event::async pair.
+void raw_queue() {
+  cyan::lockfree::queue<int> queue;
+  std::atomic<bool> closed{ false };
+  std::promise<long> result;
+  std::unique_ptr<cyan::event::async> async;
+  long sum = 0;
+  bool reported = false;
+
+  cyan::dispatch::handler_thread consumer;
+  consumer.post_awaitable([&] {
+    async = std::make_unique<cyan::event::async>(cyan::this_thread::get_event_loop());
+    async->set_callback([&] {
+      int value;
+      while (queue.try_dequeue(value)) sum += value;
+      // A send coalesced after the last one may run this once more
+      if (closed.load() && queue.empty() && !reported) {
+        reported = true;
+        result.set_value(sum);
+      }
+    });
+    async->start();
+  }).get();
+
+  auto begin = clock_type::now();
+  for (auto i = 0; i < iters; i++) {
+    queue.enqueue(i);
+    async->send();
+  }
+  closed = true;
+  async->send();
+  auto total = result.get_future().get();
+  report("lockfree::queue + async", begin, clock_type::now(), total);
+
+  consumer.post_awaitable([&] { async.reset(); }).get();
+}
+
+// Same hand-off through a channel; the consumer drains whatever is ready
+// before waiting again.
+void channel(std::size_t capacity, char const* name) {
+  cyan::dispatch::channel<int> ch{ capacity };
+  std::promise<long> result;
+  long sum = 0;
+
+  std::function<void(std::optional<int>)> on_value = [&](std::optional<int> value) {
+    if (!value) {
+      result.set_value(sum);
+      return;
+    }
+    sum += *value;
+
+    int next;
+    while (ch.try_receive(next)) sum += next;
+    ch.receive(on_value);
+  };
+
+  cyan::dispatch::handler_thread consumer;
+  consumer.post([&] { ch.receive(on_value); });
+
+  auto begin = clock_type::now();
+  for (auto i = 0; i < iters; i++) ch.send(i);
+  ch.close();
+  auto total = result.get_future().get();
+  report(name, begin, clock_type::now(), total);
+}
+
+int main(int, char**) {
+  raw_queue();
+  channel(0, "channel (unbounded)");
+  channel(1024, "channel (bounded 1024)");
+  return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, Sayan Chaliha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <cyan/event.h>
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int rounds = 200;
+constexpr int active = 100;
+
+// Watches the read ends of `pipes` pipes; every round writes a byte to
+// `active` random ones and runs the loop until each has been read.
+template<typename BackendTraits>
+void run(char const* name, std::size_t pipes) {
+  using loop_type = cyan::event::basic_loop<BackendTraits>;
+  using io_type = cyan::event::basic_io<BackendTraits>;
+
+  std::vector<int> fds(pipes * 2);
+  for (std::size_t i = 0; i < pipes; i++) {
+    if (::pipe(&fds[i * 2])) {
+      std::cout << name << ": pipe: " << std::strerror(errno) << std::endl;
+      for (std::size_t j = 0; j < i * 2; j++) ::close(fds[j]);
+      return;
+    }
+  }
+
+  auto loop = std::make_shared<loop_type>();
+  std::vector<std::unique_ptr<io_type>> watchers;
+  watchers.reserve(pipes);
+  int fired = 0;
+
+  auto begin = clock_type::now();
+  for (std::size_t i = 0; i < pipes; i++) {
+    auto& io = watchers.emplace_back(std::make_unique<io_type>(loop));
+    io->set_file_descriptor(fds[i * 2]);
+    io->set_event_flags(io_type::event_read);
+    io->set_callback([fd = fds[i * 2], &fired, &loop] (typename io_type::event_flags) {
+      char byte;
+      if (::read(fd, &byte, 1) == 1 && ++fired == active) loop->stop();
+    });
+    io->start();
+  }
+  auto const setup = clock_type::now() - begin;
+
+  std::mt19937 random{ 42 };
+  std::uniform_int_distribution<std::size_t> pick{ 0, pipes - 1 };
+  std::vector<std::size_t> targets(active);
+
+  auto busy = clock_type::duration::zero();
+  for (int round = 0; round < rounds; round++) {
+    // Distinct pipes, so that each round fires exactly `active` callbacks
+    for (auto& target : targets) {
+      do {
+        target = pick(random);
+      } while (std::count(targets.data(), &target, target));
+    }
+
+    fired = 0;
+    begin = clock_type::now();
+    for (auto target : targets) {
+      [[maybe_unused]] auto rc = ::write(fds[target * 2 + 1], "x", 1);
+    }
+    loop->start();
+    busy += clock_type::now() - begin;
+  }
+
+  auto const us = [] (auto d) { return std::chrono::duration<double, std::micro>(d).count(); };
+  std::cout << name << " " << pipes << " watched fds: register " << us(setup) / 1000. << "ms, "
+      << us(busy) / rounds << "us/round, " << us(busy) * 1000. / (rounds * active) << "ns/event" << std::endl;
+
+  watchers.clear();
+  for (auto fd : fds) ::close(fd);
+}
+
+int main(int argc, char** argv) {
+  // Two fds per watched pipe, plus a few for the loops themselves
+  ::rlimit limit;
+  ::getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  ::setrlimit(RLIMIT_NOFILE, &limit);
+
+  std::vector<std::size_t> sizes{ 10'000, 50'000, 100'000 };
+  if (argc > 1) {
+    sizes.clear();
+    for (int i = 1; i < argc; i++) sizes.push_back(std::stoul(argv[i]));
+  }
+
+  for (auto size : sizes) {
+    if (size * 2 + 64 > limit.rlim_cur) {
+      std::cout << size << " watched fds: skipped, RLIMIT_NOFILE is " << limit.rlim_cur << std::endl;
+      continue;
+    }
+
+    run<cyan::event::backend_traits<cyan::event::backend::libev>>("libev", size);
+#ifdef CYAN_EVENT_HAVE_EPOLL
+    run<cyan::event::backend_traits<cyan::event::backend::epoll>>("epoll", size);
+#endif
+  }
+  return 0;
+}
@@ -87,8 +87,16 @@ public:
     size_.fetch_add(1, std::memory_order_relaxed);
   }
 
-  void reserve(std::size_t size) noexcept {
-    max_size_ = size;
+  // Grows the list to hold at least size nodes, allocating them up front.
+  // Not safe against concurrent allocate/deallocate.
+  void reserve(std::size_t size) {
+    auto const current = max_size_.load(std::memory_order_relaxed);
+    if (size <= current) return;
+
+    max_size_.store(size, std::memory_order_relaxed);
+    for (std::size_t i = current; i < size; i++) {
+      deallocate(allocator_.allocate(1));
+    }
   }
 
   allocator_type get_allocator() const noexcept {
@@ -104,7 +112,7 @@ public:
   }
 
 private:
-  std::atomic<std::size_t> const max_size_;
+  std::atomic<std::size_t> max_size_;
   std::atomic<std::size_t> size_;
   std::atomic<node*> head_;
   allocator_type allocator_;
@@ -142,7 +142,7 @@ public:
     return tail_.is_lock_free() && head_.is_lock_free();
   }
 
-  void reserve(std::size_t size) noexcept {
+  void reserve(std::size_t size) {
     pool_.reserve(size);
   }
 
@@ -63,7 +63,11 @@ public:
   basic_socket(basic_socket&& other) noexcept : base_io{ std::move(other) },
         native_handle_{ other.native_handle_ },
         local_endpoint_{ std::move(other.local_endpoint_) },
-        remote_endpoint_{ std::move(other.remote_endpoint_) } {
+        remote_endpoint_{ std::move(other.remote_endpoint_) }
+#ifdef CYAN_EVENT_HAVE_IO_URING
+        , io_ring_{ std::move(other.io_ring_) }
+#endif // CYAN_EVENT_HAVE_IO_URING
+        {
     other.native_handle_ = cyan::net::detail::invalid_socket;
   }
 
@@ -74,6 +78,9 @@ public:
     other.native_handle_ = cyan::net::detail::invalid_socket;
     local_endpoint_ = std::move(other.local_endpoint_);
     remote_endpoint_ = std::move(other.remote_endpoint_);
+#ifdef CYAN_EVENT_HAVE_IO_URING
+    io_ring_ = std::move(other.io_ring_);
+#endif // CYAN_EVENT_HAVE_IO_URING
     return *this;
   }
 
@@ -100,6 +107,12 @@ public:
     std::error_code ec;
 
     base_io::stop();
+#ifdef CYAN_EVENT_HAVE_IO_URING
+    if (io_ring_) {
+      io_ring_->cancel_all(native_handle_);
+      io_ring_->unregister_file(native_handle_);
+    }
+#endif // CYAN_EVENT_HAVE_IO_URING
     cyan::net::detail::close(native_handle_, ec);
     if (ec) throw std::system_error{ ec };
 
@@ -192,6 +205,32 @@ public:
     base_io::stop();
   }
 
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  using io_ring_type = cyan::event::io_ring;
+  using operation_id_type = io_ring_type::operation_id_type;
+
+  // Completion-based operations go through this thread's io ring unless
+  // another one is set; it must belong to the socket's loop
+  void set_io_ring(std::shared_ptr<io_ring_type> const& ring) noexcept {
+    io_ring_ = ring;
+  }
+
+  io_ring_type& io_ring() {
+    if (!io_ring_) io_ring_ = cyan::this_thread::get_io_ring();
+    return *io_ring_;
+  }
+
+  // Lets the ring skip the descriptor lookup on every operation
+  void register_descriptor() {
+    io_ring().register_file(native_handle_);
+  }
+
+  // The operation completes with operation_canceled
+  void cancel(operation_id_type id) {
+    io_ring().cancel(id);
+  }
+#endif // CYAN_EVENT_HAVE_IO_URING
+
 protected:
   virtual ~basic_socket() {
     close();
@@ -200,6 +239,9 @@ protected:
   native_handle_type native_handle_;
   mutable endpoint_type local_endpoint_;
   mutable endpoint_type remote_endpoint_;
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  std::shared_ptr<io_ring_type> io_ring_;
+#endif // CYAN_EVENT_HAVE_IO_URING
 };
 
 } // cyan::net
@@ -119,6 +119,9 @@
 #ifdef SO_NOSIGPIPE
 # define CYAN_OS_DEF_SO_NOSIGPIPE SO_NOSIGPIPE // boolean
 #endif // SO_NOSIGPIPE
+#ifdef SO_BUSY_POLL
+# define CYAN_OS_DEF_SO_BUSY_POLL SO_BUSY_POLL // integer
+#endif // SO_BUSY_POLL
 #define CYAN_OS_DEF_SO_NREAD SO_NREAD // integer
 #define CYAN_OS_DEF_SO_NWRITE SO_NWRITE // integer
 #define CYAN_OS_DEF_SO_LINGER_SEC SO_LINGER_SEC
@@ -157,28 +157,12 @@ socket_type accept(socket_type sock, sockaddr_type* addr, std::uint32_t* len, st
   clear_last_error();
   socket_type new_sock = error_wrapper(::accept(sock, addr, len), ec);
   if (new_sock == invalid_socket) return new_sock;
- 
-#ifdef CYAN_OS_DEF_SO_NOSIGPIPE
-  boolean_socket_option<CYAN_OS_DEF(SOL_SOCKET), CYAN_OS_DEF(SO_NOSIGPIPE)> nosigpipe{ true };
-  if (set_socket_option(new_sock, nosigpipe, ec) == -1) {
-    ::close(new_sock);
-    return invalid_socket;
-  }
-#endif // CYAN_OS_DEF_SO_NOSIGPIPE
 
-  boolean_socket_option<CYAN_OS_DEF(IPPROTO_TCP), CYAN_OS_DEF(TCP_NODELAY)> nodelay{ true };
-  if (set_socket_option(new_sock, nodelay, ec) == -1) {
-    ::close(new_sock);
-    return invalid_socket;
-  }
-
-  if (socket_set_non_blocking(new_sock, true, ec) == -1) {
+  if (setup_accepted(new_sock, ec) == -1) {
     ::close(new_sock);
     return invalid_socket;
   }
 
-  ec = std::error_code{};
-
   return new_sock;
 }
 
@@ -212,5 +196,23 @@ std::int64_t send(socket_type sock, void const* buffer, std::size_t len, std::in
   return error_wrapper(::send(sock, buffer, len, flags), ec);
 }
 
+std::int32_t setup_accepted(socket_type sock, std::error_code& ec) noexcept {
+#ifdef CYAN_OS_DEF_SO_NOSIGPIPE
+  boolean_socket_option<CYAN_OS_DEF(SOL_SOCKET), CYAN_OS_DEF(SO_NOSIGPIPE)> nosigpipe{ true };
+  if (set_socket_option(sock, nosigpipe, ec) == -1) return -1;
+#endif // CYAN_OS_DEF_SO_NOSIGPIPE
+
+  boolean_socket_option<CYAN_OS_DEF(IPPROTO_TCP), CYAN_OS_DEF(TCP_NODELAY)> nodelay{ true };
+  if (set_socket_option(sock, nodelay, ec) == -1) return -1;
+
+  if (socket_set_non_blocking(sock, true, ec) == -1) return -1;
+
+  ec = std::error_code{};
+  return 0;
+}
+
+std::error_code completion_error(std::int32_t result) noexcept {
+  return result < 0 ? std::error_code{ -result, std::system_category() } : std::error_code{};
+}
 
 } // cyan::net::detail
@@ -50,4 +50,11 @@ std::int64_t send(socket_type sock, void const* buffer, std::size_t size, std::i
 
 // -------------------------------------------------------------------------------------------------------------------
 
+// Applies the options `accept` sets on a connection accepted elsewhere, e.g. by the io ring
+std::int32_t setup_accepted(socket_type sock, std::error_code& ec) noexcept;
+// Converts an io ring completion result, a negated errno on failure
+std::error_code completion_error(std::int32_t result) noexcept;
+
+// -------------------------------------------------------------------------------------------------------------------
+
 }
@@ -41,16 +41,24 @@ public:
   using native_handle_type = cyan::net::detail::socket_type;
   using endpoint_type = typename protocol_type::endpoint;
   using connection_callback_type = std::function<void(std::unique_ptr<basic_stream_socket<Protocol>>&&)>;
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  using io_ring_type = cyan::event::io_ring;
+  using operation_id_type = io_ring_type::operation_id_type;
+  using accept_completion_type = std::function<void(std::error_code const&,
+        std::unique_ptr<basic_stream_socket<Protocol>>&&)>;
+  using multishot_accept_completion_type = std::function<void(std::error_code const&,
+        std::unique_ptr<basic_stream_socket<Protocol>>&&, bool more)>;
+#endif // CYAN_EVENT_HAVE_IO_URING
 
   basic_socket_acceptor(event_loop_type loop_ref) noexcept : base_io{ loop_ref },
          native_handle_{ cyan::net::detail::invalid_socket } {
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_socket_acceptor::event_callback>(this);
     base_io::set_event_flags(cyan::event::io::event_read);
   }
 
   basic_socket_acceptor(event_loop_type loop_ref, native_handle_type native_handle) : base_io{ loop_ref },
         native_handle_{ native_handle } {
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_socket_acceptor::event_callback>(this);
     base_io::set_event_flags(cyan::event::io::event_read);
     base_io::set_file_descriptor(native_handle_);
   }
@@ -58,7 +66,7 @@ public:
   basic_socket_acceptor(event_loop_type loop_ref, protocol_type const& protocol) : base_io{ loop_ref },
         native_handle_{ cyan::net::detail::invalid_socket } {
     open(protocol);
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_socket_acceptor::event_callback>(this);
     base_io::set_event_flags(cyan::event::io::event_read);
   }
 
@@ -66,24 +74,45 @@ public:
         native_handle_{ cyan::net::detail::invalid_socket } {
     bind(endpoint);
     listen();
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_socket_acceptor::event_callback>(this);
     base_io::set_event_flags(cyan::event::io::event_read);
   }
 
-  basic_socket_acceptor(basic_socket_acceptor&& other) noexcept : native_handle_{ other.native_handle_ },
-        local_endpoint_{ std::move(other.local_endpoint_) } {
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+  basic_socket_acceptor(basic_socket_acceptor&& other) noexcept : base_io{ std::move(other) },
+        native_handle_{ other.native_handle_ },
+        local_endpoint_{ std::move(other.local_endpoint_) }
+#ifdef CYAN_EVENT_HAVE_IO_URING
+        , io_ring_{ std::move(other.io_ring_) }
+#endif // CYAN_EVENT_HAVE_IO_URING
+        {
+    base_io::template set_callback<&basic_socket_acceptor::event_callback>(this);
     other.native_handle_ = cyan::net::detail::invalid_socket;
+    std::swap(self_, other.self_);
+    *self_ = this;
+    *other.self_ = &other;
   }
 
   basic_socket_acceptor& operator =(basic_socket_acceptor&& other) noexcept {
+    base_io::operator =(std::move(other));
     native_handle_ = other.native_handle_;
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_socket_acceptor::event_callback>(this);
     other.native_handle_ = cyan::net::detail::invalid_socket;
     local_endpoint_ = std::move(other.local_endpoint_);
+#ifdef CYAN_EVENT_HAVE_IO_URING
+    io_ring_ = std::move(other.io_ring_);
+#endif // CYAN_EVENT_HAVE_IO_URING
+    // Completions of the operations this acceptor had started are orphaned
+    *self_ = nullptr;
+    self_ = std::exchange(other.self_, std::make_shared<basic_socket_acceptor*>(&other));
+    *self_ = this;
     return *this;
   }
 
+  ~basic_socket_acceptor() {
+    *self_ = nullptr;
+    close();
+  }
+
   native_handle_type native_handle() const {
     return native_handle_;
   }
@@ -105,6 +134,12 @@ public:
     if (!is_open()) return;
 
     base_io::stop();
+#ifdef CYAN_EVENT_HAVE_IO_URING
+    if (io_ring_) {
+      io_ring_->cancel_all(native_handle_);
+      io_ring_->unregister_file(native_handle_);
+    }
+#endif // CYAN_EVENT_HAVE_IO_URING
 
     std::error_code ec;
     cyan::net::detail::close(native_handle_, ec);
@@ -194,7 +229,79 @@ public:
     connection_callback_ = std::move(callback);
   }
 
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  void set_io_ring(std::shared_ptr<io_ring_type> const& ring) noexcept {
+    io_ring_ = ring;
+  }
+
+  io_ring_type& io_ring() {
+    if (!io_ring_) io_ring_ = cyan::this_thread::get_io_ring();
+    return *io_ring_;
+  }
+
+  void register_descriptor() {
+    io_ring().register_file(native_handle_);
+  }
+
+  void cancel(operation_id_type id) {
+    io_ring().cancel(id);
+  }
+
+  // Accepts one connection through the io ring. Completions may run after
+  // the acceptor is gone, as closing it cancels them.
+  operation_id_type async_accept(accept_completion_type&& completion) {
+    return io_ring().accept(native_handle_, nullptr, nullptr,
+        [self = self_, completion = std::move(completion)] (std::int32_t result, std::uint32_t) {
+          std::error_code ec;
+          auto socket = accepted(*self, result, ec);
+          completion(ec, std::move(socket));
+        });
+  }
+
+  // Keeps accepting connections, one completion each, until an error; the
+  // last completion has `more` unset
+  operation_id_type multishot_accept(multishot_accept_completion_type&& completion) {
+    return io_ring().multishot_accept(native_handle_,
+        [self = self_, completion = std::move(completion)] (std::int32_t result, std::uint32_t flags) {
+          std::error_code ec;
+          auto socket = accepted(*self, result, ec);
+          completion(ec, std::move(socket), io_ring_type::has_more(flags));
+        });
+  }
+#endif // CYAN_EVENT_HAVE_IO_URING
+
 protected:
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  // A connection accepted after the acceptor was destroyed is closed
+  static std::unique_ptr<basic_stream_socket<Protocol>> accepted(basic_socket_acceptor* acceptor,
+        std::int32_t result, std::error_code& ec) {
+    ec = cyan::net::detail::completion_error(result);
+    if (ec) return nullptr;
+
+    if (!acceptor) {
+      std::error_code ignored;
+      cyan::net::detail::close(result, ignored);
+      ec = std::make_error_code(std::errc::operation_canceled);
+      return nullptr;
+    }
+    return acceptor->accepted(result, ec);
+  }
+
+  std::unique_ptr<basic_stream_socket<Protocol>> accepted(std::int32_t result, std::error_code& ec) {
+
+    if (cyan::net::detail::setup_accepted(result, ec) == -1) {
+      std::error_code ignored;
+      cyan::net::detail::close(result, ignored);
+      return nullptr;
+    }
+
+    auto socket = std::make_unique<basic_stream_socket<Protocol>>(base_io::loop_ref_.lock(), result);
+    socket->set_io_ring(io_ring_);
+    return socket;
+  }
+#endif // CYAN_EVENT_HAVE_IO_URING
+
+
   void event_callback(cyan::event::io::event_flags events) {
     if (events & cyan::event::io::event_error) {
       // error
@@ -219,6 +326,12 @@ protected:
   native_handle_type native_handle_;
   endpoint_type local_endpoint_;
   connection_callback_type connection_callback_;
+  // How io ring completions, which may outlive the acceptor, reach it:
+  // follows moves and is cleared on destruction
+  std::shared_ptr<basic_socket_acceptor*> self_{ std::make_shared<basic_socket_acceptor*>(this) };
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  std::shared_ptr<io_ring_type> io_ring_;
+#endif // CYAN_EVENT_HAVE_IO_URING
 };
 
 } // cyan::net
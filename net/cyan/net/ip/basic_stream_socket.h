@@ -25,6 +25,8 @@
 #pragma once
 
 #include <iostream>
+#include <cyan/trace.h>
+#include <cyan/net/buffers.h>
 #include <cyan/net/basic_socket.h>
 
 namespace cyan::net::ip {
@@ -44,25 +46,31 @@ public:
   using native_handle_type = typename base::native_handle_type;
   using endpoint_type = typename protocol_type::endpoint;
   using callback_type = std::function<void(basic_stream_socket<Protocol>&)>;
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  using operation_id_type = typename base::operation_id_type;
+  using completion_type = std::function<void(std::error_code const&, std::size_t)>;
+  using connect_completion_type = std::function<void(std::error_code const&)>;
+  using receive_completion_type = std::function<void(std::error_code const&, const_buffer const&, bool more)>;
+#endif // CYAN_EVENT_HAVE_IO_URING
 
   basic_stream_socket(event_loop_type loop_ref) : base{ loop_ref } {}
 
   basic_stream_socket(event_loop_type loop_ref, native_handle_type native_handle) : base{ loop_ref, native_handle } {
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_stream_socket::event_callback>(this);
   }
 
   basic_stream_socket(event_loop_type loop_ref, protocol_type const& protocol) : base{ loop_ref, protocol } {
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_stream_socket::event_callback>(this);
   }
 
   basic_stream_socket(event_loop_type loop_ref, endpoint_type const& endpoint) : base{ loop_ref, endpoint } {
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_stream_socket::event_callback>(this);
   }
 
   basic_stream_socket(basic_stream_socket&& other) noexcept : base{ std::move(other) },
         readable_callback_{ std::move(other.readable_callback_) },
         writable_callback_{ std::move(other.writable_callback_) } {
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_stream_socket::event_callback>(this);
     other.readable_callback_ = nullptr;
     other.writable_callback_ = nullptr;
   }
@@ -71,7 +79,7 @@ public:
     base::operator =(std::move(other));
     readable_callback_ = std::move(other.readable_callback_);
     writable_callback_ = std::move(other.writable_callback_);
-    base_io::set_callback([this] (cyan::event::io::event_flags events) { event_callback(events); });
+    base_io::template set_callback<&basic_stream_socket::event_callback>(this);
     other.readable_callback_ = nullptr;
     other.writable_callback_ = nullptr;
   }
@@ -117,11 +125,64 @@ public:
     }
   }
 
+#ifdef CYAN_EVENT_HAVE_IO_URING
+  // Completion-based counterparts of the calls above: the operation is
+  // handed to the io ring and the completion runs on the loop's thread once
+  // it is done, without waiting for readiness first. Buffers must stay valid
+  // until then. Completions do not refer to the socket, whose destruction
+  // cancels them.
+  template<typename MutableBuffer>
+  operation_id_type async_receive(MutableBuffer&& buffer, completion_type&& completion,
+        socket_base::message_flags flags = 0) {
+    return base::io_ring().receive(base::native_handle_, buffer.data(), buffer.size(), flags,
+        [completion = std::move(completion)] (std::int32_t result, std::uint32_t) {
+          completion(cyan::net::detail::completion_error(result), result < 0 ? 0 : result);
+        });
+  }
+
+  template<typename Buffer>
+  operation_id_type async_send(Buffer const& buffer, completion_type&& completion,
+        socket_base::message_flags flags = 0) {
+    return base::io_ring().send(base::native_handle_, buffer.data(), buffer.size(), flags,
+        [completion = std::move(completion)] (std::int32_t result, std::uint32_t) {
+          completion(cyan::net::detail::completion_error(result), result < 0 ? 0 : result);
+        });
+  }
+
+  operation_id_type async_connect(endpoint_type const& peer, connect_completion_type&& completion) {
+    if (!base::is_open()) base::open(peer.protocol());
+
+    // The kernel may read the address after the socket is gone
+    base::remote_endpoint_ = peer;
+    auto address = std::make_shared<endpoint_type>(peer);
+    return base::io_ring().connect(base::native_handle_, address->data(), static_cast<std::uint32_t>(address->size()),
+        [address, completion = std::move(completion)] (std::int32_t result, std::uint32_t) {
+          completion(cyan::net::detail::completion_error(result));
+        });
+  }
+
+  // Receives continuously into buffers taken from `group`, registered with
+  // the io ring beforehand; each buffer is only valid during the completion.
+  // The last completion has `more` unset: on error, at end of stream (an
+  // empty buffer) or once the group runs dry (no_buffer_space), after which
+  // the operation has to be restarted.
+  operation_id_type async_receive(std::uint16_t group, receive_completion_type&& completion) {
+    return base::io_ring().multishot_receive(base::native_handle_, group,
+        [completion = std::move(completion)] (std::int32_t result, void const* data, std::uint32_t flags) {
+          completion(cyan::net::detail::completion_error(result),
+              const_buffer{ data, result < 0 ? 0 : static_cast<std::size_t>(result) },
+              cyan::event::io_ring::has_more(flags));
+        });
+  }
+#endif // CYAN_EVENT_HAVE_IO_URING
+
 protected:
   friend class basic_socket_acceptor<Protocol>;
 
 private:
   void event_callback(cyan::event::io::event_flags events) {
+    cyan::trace::scope scope{ "stream_socket::event_callback", "net" };
+
     if (events & cyan::event::io::event_error) {
       // TODO: Handle error
       base::close();
@@ -60,6 +60,10 @@ public:
   using receive_timeout = cyan::net::detail::time_socket_option<CYAN_OS_DEF(SOL_SOCKET), CYAN_OS_DEF(SO_RCVTIMEO)>;
   using type = cyan::net::detail::integer_socket_option<CYAN_OS_DEF(SOL_SOCKET), CYAN_OS_DEF(SO_TYPE)>;
   using error = cyan::net::detail::integer_socket_option<CYAN_OS_DEF(SOL_SOCKET), CYAN_OS_DEF(SO_ERROR)>;
+#ifdef CYAN_OS_DEF_SO_BUSY_POLL
+  // Microseconds to spin on the device queue in blocking receives and polls
+  using busy_poll = cyan::net::detail::integer_socket_option<CYAN_OS_DEF(SOL_SOCKET), CYAN_OS_DEF(SO_BUSY_POLL)>;
+#endif // CYAN_OS_DEF_SO_BUSY_POLL
   constexpr static std::int32_t max_listen_connections = CYAN_OS_DEF(SOMAXCONN);
 
 protected: